@@ -1,8 +1,9 @@
 set(H_SOURCES_ROOT ${CMAKE_CURRENT_SOURCE_DIR}/sources)
 set(H_TARGETS
-        stardraw stardraw-demo glad
+        stardraw stardraw-demo stardraw-shader-archiver glad
 )
 
 add_subdirectory(sources/glad)
 add_subdirectory(sources/stardraw)
-add_subdirectory(sources/stardraw-demo)
\ No newline at end of file
+add_subdirectory(sources/stardraw-demo)
+add_subdirectory(sources/stardraw-shader-archiver)
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <fstream>
 
 #include "stardraw/api/render_context.hpp"
+#include "stardraw/api/render_graph.hpp"
 #include "stardraw/api/shaders.hpp"
 #include "starlib/general/gameloop.hpp"
 #include "starlib/general/logger.hpp"
@@ -163,6 +164,22 @@ int main()
         logger.log_info({"meow", ""}, "meow!");
     }
 
+    ///Render graph transients are created as views of their storage, so make sure depth transients can be too.
+    render_graph depth_graph("depth-graph");
+    status depth_texture_status = depth_graph.add_transient_texture("depth-transient", texture_format::create_2d(64, 64, texture_data_type::DEPTH_F32));
+    status depth_framebuffer_status = depth_graph.add_transient_framebuffer(framebuffer("depth-framebuffer", {}, framebuffer_attachment_info {"depth-transient", 0, 0, false}));
+    status depth_pass_status = depth_graph.add_pass({
+        .name = "depth-clear",
+        .writes = {"depth-framebuffer"},
+        .commands = {clear_framebuffer("depth-framebuffer", {}, 1.0f)},
+        .has_side_effects = true,
+    });
+
+    command_list depth_graph_commands;
+    status depth_graph_status = depth_graph.compile(ctx, depth_graph_commands);
+    if (depth_graph_status.is_error()) logger.log_info({"meow", ""}, "Compiling a render graph with a depth transient failed!");
+    status depth_release_status = depth_graph.release(ctx);
+
     wind->callbacks.on_input_events = [&logger, wind](window*, const std::vector<input_event>& events)
     {
         for (const input_event& event : events)
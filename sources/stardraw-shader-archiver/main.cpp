@@ -0,0 +1,118 @@
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <sstream>
+
+#include "stardraw/api/shader_archive.hpp"
+#include "stardraw/api/shaders.hpp"
+
+using namespace stardraw;
+using namespace starlib;
+
+///Build-time tool that compiles Slang shaders into a shader archive, so shipping builds can load them without running Slang.
+///The manifest has one program per line: '<program name> <slang source path> <entry point> [<entry point>...]'
+///Source paths are relative to the manifest. Empty lines and lines starting with '#' are ignored.
+
+static bool read_text_file(const std::filesystem::path& path, std::string& out_text)
+{
+    std::ifstream file(path, std::ios::in);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out_text = buffer.str();
+    return true;
+}
+
+int main(const int argc, const char** argv)
+{
+    if (argc != 3)
+    {
+        std::println(stderr, "Usage: stardraw-shader-archiver <manifest> <output archive>");
+        return 1;
+    }
+
+    const std::filesystem::path manifest_path = argv[1];
+    std::ifstream manifest(manifest_path, std::ios::in);
+    if (!manifest.is_open())
+    {
+        std::println(stderr, "Couldn't open manifest '{0}'", manifest_path.string());
+        return 1;
+    }
+
+    shader_compiler_context* compiler;
+    if (shader_compiler_context::create(compiler).is_error())
+    {
+        std::println(stderr, "Couldn't create the Slang shader compiler");
+        return 1;
+    }
+
+    std::vector<shader_archive_program> programs;
+    std::string line;
+    u32 line_number = 0;
+
+    while (std::getline(manifest, line))
+    {
+        line_number++;
+        std::istringstream words(line);
+        std::string name;
+        std::string source_path;
+        if (!(words >> name) || name.starts_with('#')) continue;
+
+        std::vector<std::string> entry_point_names;
+        std::string entry_point_name;
+        words >> source_path;
+        while (words >> entry_point_name) entry_point_names.push_back(entry_point_name);
+
+        if (entry_point_names.empty())
+        {
+            std::println(stderr, "{0}:{1}: program '{2}' needs a source path and at least one entry point", manifest_path.string(), line_number, name);
+            return 1;
+        }
+
+        std::string source;
+        if (!read_text_file(manifest_path.parent_path() / source_path, source))
+        {
+            std::println(stderr, "{0}:{1}: couldn't read shader source '{2}'", manifest_path.string(), line_number, source_path);
+            return 1;
+        }
+
+        shader_module module;
+        if (compiler->load_shader_module(source, module).is_error())
+        {
+            std::println(stderr, "{0}:{1}: failed to compile '{2}'", manifest_path.string(), line_number, source_path);
+            return 1;
+        }
+
+        std::vector<shader_entry_point> entry_points;
+        for (const std::string& entry_point : entry_point_names) entry_points.push_back({module, entry_point});
+
+        shader_program linked_program;
+        if (compiler->link_shader_program(entry_points, linked_program).is_error())
+        {
+            std::println(stderr, "{0}:{1}: failed to link program '{2}'", manifest_path.string(), line_number, name);
+            return 1;
+        }
+
+        shader_archive_program& program = programs.emplace_back(name);
+        for (const shader_entry_point& entry_point : entry_points)
+        {
+            shader_stage stage;
+            if (compiler->create_shader_stage(linked_program, entry_point, graphics_api::GL45, stage).is_error())
+            {
+                std::println(stderr, "{0}:{1}: failed to create stage '{2}' of program '{3}'", manifest_path.string(), line_number, entry_point.entry_point_name, name);
+                return 1;
+            }
+            program.stages.push_back(stage);
+        }
+    }
+
+    if (write_shader_archive(argv[2], programs).is_error())
+    {
+        std::println(stderr, "Failed to write shader archive '{0}'", argv[2]);
+        return 1;
+    }
+
+    std::println("Wrote {0} programs to '{1}'", programs.size(), argv[2]);
+    delete compiler;
+    return cleanup_shader_compiler().is_error() ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    ///Rules used to pad shader buffer data. Uniform / constant buffers use STD140 in GL, storage and structured buffers use STD430.
+    enum class buffer_layout_rules : starlib::u8
+    {
+        STD140, STD430
+    };
+
+    ///Marks a field as a vector of 2 to 4 32 bit scalars (for instance, shader_vector<f32, 3> is a float3). Values are given as std::array<T, N>.
+    template <typename T, starlib::u32 N>
+    struct shader_vector {};
+
+    ///Marks a field as a fixed size array. Values are given as a std::array of the element values.
+    template <typename T, starlib::u32 N>
+    struct shader_array {};
+
+    ///Description of a field in a compile-time buffer layout, used to validate it against shader reflection.
+    struct buffer_layout_field
+    {
+        starlib::u64 offset = 0;
+        starlib::u64 size = 0;
+
+        //Non-zero for arrays
+        starlib::u32 element_count = 0;
+        starlib::u64 element_stride = 0;
+
+        //Fields of the structure, or of the array element for arrays of structures.
+        std::vector<buffer_layout_field> fields;
+    };
+
+    ///A compile-time buffer layout bound to a buffer name, so it can be checked against a shader (see the shader descriptor).
+    struct shader_buffer_layout
+    {
+        std::string buffer_name;
+        starlib::u64 size = 0;
+        std::vector<buffer_layout_field> fields;
+    };
+
+    constexpr starlib::u64 align_layout_offset(const starlib::u64 offset, const starlib::u64 alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    ///Layout of a single field type under a set of layout rules. Specialized for each supported type.
+    template <buffer_layout_rules rules, typename T>
+    struct shader_field_layout;
+
+    template <buffer_layout_rules rules, typename T> requires std::is_same_v<T, starlib::f32> || std::is_same_v<T, starlib::i32> || std::is_same_v<T, starlib::u32>
+    struct shader_field_layout<rules, T>
+    {
+        typedef T value_type;
+        static constexpr starlib::u64 size = sizeof(T);
+        static constexpr starlib::u64 alignment = sizeof(T);
+
+        static void write(starlib::u8* destination, const value_type& value)
+        {
+            memcpy(destination, &value, size);
+        }
+
+        static buffer_layout_field describe(const starlib::u64 offset)
+        {
+            return {offset, size};
+        }
+    };
+
+    template <buffer_layout_rules rules, typename T, starlib::u32 N>
+    struct shader_field_layout<rules, shader_vector<T, N>>
+    {
+        static_assert(N >= 2 && N <= 4, "Shader vectors have 2 to 4 components");
+
+        typedef std::array<T, N> value_type;
+        static constexpr starlib::u64 size = shader_field_layout<rules, T>::size * N;
+        //3 component vectors are aligned like 4 component vectors, so a following scalar can pack into the last slot.
+        static constexpr starlib::u64 alignment = shader_field_layout<rules, T>::size * (N == 2 ? 2 : 4);
+
+        static void write(starlib::u8* destination, const value_type& value)
+        {
+            memcpy(destination, value.data(), size);
+        }
+
+        static buffer_layout_field describe(const starlib::u64 offset)
+        {
+            return {offset, size};
+        }
+    };
+
+    template <buffer_layout_rules rules, typename T, starlib::u32 N>
+    struct shader_field_layout<rules, shader_array<T, N>>
+    {
+        typedef shader_field_layout<rules, T> element_layout;
+        typedef std::array<typename element_layout::value_type, N> value_type;
+
+        //STD140 rounds the alignment (and so the stride) of array elements up to 16 bytes, STD430 doesn't.
+        static constexpr starlib::u64 alignment = rules == buffer_layout_rules::STD140 ? align_layout_offset(element_layout::alignment, 16) : element_layout::alignment;
+        static constexpr starlib::u64 element_stride = align_layout_offset(element_layout::size, alignment);
+        static constexpr starlib::u64 size = element_stride * N;
+
+        static void write(starlib::u8* destination, const value_type& value)
+        {
+            for (starlib::u32 idx = 0; idx < N; idx++)
+            {
+                element_layout::write(destination + idx * element_stride, value[idx]);
+            }
+        }
+
+        static buffer_layout_field describe(const starlib::u64 offset)
+        {
+            return {offset, size, N, element_stride, element_layout::describe(offset).fields};
+        }
+    };
+
+    ///A structure layout computed at compile time from its field types, matching how the shader will pad it.
+    ///Use it to write field values straight into mapped or transfer memory, or keep a padded_buffer of it to upload with a single copy.
+    ///Layouts can be nested as fields of other layouts with the same rules.
+    template <buffer_layout_rules rules, typename... field_types>
+    struct buffer_layout
+    {
+        static_assert(sizeof...(field_types) > 0, "Buffer layouts need at least one field");
+
+        static constexpr starlib::u32 field_count = sizeof...(field_types);
+
+        template <starlib::u32 idx>
+        using field_type = std::tuple_element_t<idx, std::tuple<field_types...>>;
+
+        template <starlib::u32 idx>
+        using field_value_type = typename shader_field_layout<rules, field_type<idx>>::value_type;
+
+        static constexpr std::array<starlib::u64, field_count> offsets = []
+        {
+            std::array<starlib::u64, field_count> result {};
+            starlib::u64 offset = 0;
+            starlib::u32 idx = 0;
+            ((offset = align_layout_offset(offset, shader_field_layout<rules, field_types>::alignment), result[idx++] = offset, offset += shader_field_layout<rules, field_types>::size), ...);
+            return result;
+        }();
+
+        //STD140 rounds the alignment of structures up to 16 bytes, STD430 doesn't.
+        static constexpr starlib::u64 alignment = rules == buffer_layout_rules::STD140 ? align_layout_offset(std::max({shader_field_layout<rules, field_types>::alignment...}), 16) : std::max({shader_field_layout<rules, field_types>::alignment...});
+        static constexpr starlib::u64 size = align_layout_offset(offsets[field_count - 1] + shader_field_layout<rules, field_type<field_count - 1>>::size, alignment);
+
+        ///Write a single field into memory laid out by this layout.
+        template <starlib::u32 idx>
+        static void write_field(void* destination, const field_value_type<idx>& value)
+        {
+            shader_field_layout<rules, field_type<idx>>::write(static_cast<starlib::u8*>(destination) + offsets[idx], value);
+        }
+
+        ///Write all fields into memory laid out by this layout (size bytes). Padding is left untouched.
+        static void write(void* destination, const typename shader_field_layout<rules, field_types>::value_type&... values)
+        {
+            write_fields(destination, std::make_integer_sequence<starlib::u32, field_count>(), values...);
+        }
+
+        ///Bind the layout to a buffer name, so it can be validated against a shader's reflection.
+        static shader_buffer_layout for_buffer(const std::string_view& buffer_name)
+        {
+            return {std::string(buffer_name), size, describe(0).fields};
+        }
+
+        static buffer_layout_field describe(const starlib::u64 offset)
+        {
+            return describe_fields(offset, std::make_integer_sequence<starlib::u32, field_count>());
+        }
+
+    private:
+        template <starlib::u32... indices>
+        static void write_fields(void* destination, std::integer_sequence<starlib::u32, indices...>, const typename shader_field_layout<rules, field_types>::value_type&... values)
+        {
+            (write_field<indices>(destination, values), ...);
+        }
+
+        template <starlib::u32... indices>
+        static buffer_layout_field describe_fields(const starlib::u64 offset, std::integer_sequence<starlib::u32, indices...>)
+        {
+            return {offset, size, 0, 0, {shader_field_layout<rules, field_types>::describe(offset + offsets[indices])...}};
+        }
+    };
+
+    ///CPU-side copy of a buffer layout's padded data. Fields are written in place, so uploading it is a single copy of 'size' bytes.
+    template <typename layout>
+    struct padded_buffer
+    {
+        template <starlib::u32 idx>
+        void set(const typename layout::template field_value_type<idx>& value)
+        {
+            layout::template write_field<idx>(bytes, value);
+        }
+
+        [[nodiscard]] const void* data() const
+        {
+            return bytes;
+        }
+
+        static constexpr starlib::u64 size = layout::size;
+        alignas(16) starlib::u8 bytes[layout::size] {};
+    };
+
+    template <buffer_layout_rules rules, typename... field_types>
+    struct shader_field_layout<rules, buffer_layout<rules, field_types...>>
+    {
+        typedef buffer_layout<rules, field_types...> layout;
+        typedef padded_buffer<layout> value_type;
+        static constexpr starlib::u64 size = layout::size;
+        static constexpr starlib::u64 alignment = layout::alignment;
+
+        static void write(starlib::u8* destination, const value_type& value)
+        {
+            memcpy(destination, value.bytes, size);
+        }
+
+        static buffer_layout_field describe(const starlib::u64 offset)
+        {
+            return layout::describe(offset);
+        }
+    };
+}
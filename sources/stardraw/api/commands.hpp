@@ -16,10 +16,11 @@ namespace stardraw
     {
         DRAW, DRAW_INDIRECT, DRAW_INDEXED, DRAW_INDEXED_INDIRECT,
         CONFIG_BLENDING, CONFIG_STENCIL, CONFIG_SCISSOR, CONFIG_FACE_CULL, CONFIG_DEPTH_TEST, CONFIG_DEPTH_RANGE, CONFIG_DRAW, CONFIG_VIEWPORTS,
-        BUFFER_COPY, TEXTURE_COPY, FRAMEBUFFER_COPY,
+        BUFFER_COPY, TEXTURE_COPY, FRAMEBUFFER_COPY, GENERATE_MIPMAPS,
         CLEAR_WINDOW, CLEAR_FRAMEBUFFER, CLEAR_TEXTURE,
         CONFIG_SHADER, COMPUTE_DISPATCH, COMPUTE_DISPATCH_INDIRECT,
-        SIGNAL,
+        SIGNAL, MEMORY_BARRIER,
+        BEGIN_QUERY, END_QUERY, BEGIN_OCCLUSION_QUERY, END_OCCLUSION_QUERY, BEGIN_CONDITIONAL_RENDER, END_CONDITIONAL_RENDER,
         AQUIRE, PRESENT,
     };
 
@@ -98,6 +99,8 @@ namespace stardraw
     struct draw_indirect final : command
     {
         draw_indirect(const std::string_view& indirect_buffer, const draw_mode mode, const starlib::u32 draw_count, const starlib::u32 indirect_index = 0) : indirect_buffer(indirect_buffer), mode(mode), draw_count(draw_count), indirect_index(indirect_index) {}
+        ///Reads the number of draws from a u32 at count_address in count_buffer (for instance, written by a culling compute shader), making at most max_draw_count draws.
+        draw_indirect(const std::string_view& indirect_buffer, const std::string_view& count_buffer, const starlib::u64 count_address, const draw_mode mode, const starlib::u32 max_draw_count, const starlib::u32 indirect_index = 0) : indirect_buffer(indirect_buffer), mode(mode), draw_count(max_draw_count), indirect_index(indirect_index), count_buffer(object_identifier(count_buffer)), count_address(count_address) {}
 
         [[nodiscard]] command_type type() const override
         {
@@ -106,8 +109,11 @@ namespace stardraw
 
         object_identifier indirect_buffer;
         draw_mode mode;
+        ///Number of draws, or the maximum number of draws if a count buffer is used.
         starlib::u32 draw_count;
         starlib::u32 indirect_index;
+        std::optional<object_identifier> count_buffer;
+        starlib::u64 count_address = 0;
     };
 
     ///Draws some triangles, using an indirect draw command buffer. A valid draw specification must have been configured to provide the shader and vertex data
@@ -115,29 +121,22 @@ namespace stardraw
     struct draw_indexed_indirect final : command
     {
         draw_indexed_indirect(const std::string_view& indirect_buffer, const draw_mode mode, const starlib::u32 draw_count, const starlib::u32 indirect_index = 0, const draw_indexed_index_type index_type = draw_indexed_index_type::UINT_32) : indirect_buffer(indirect_buffer), mode(mode), index_type(index_type), draw_count(draw_count), indirect_index(indirect_index) {}
+        ///Reads the number of draws from a u32 at count_address in count_buffer (for instance, written by a culling compute shader), making at most max_draw_count draws.
+        draw_indexed_indirect(const std::string_view& indirect_buffer, const std::string_view& count_buffer, const starlib::u64 count_address, const draw_mode mode, const starlib::u32 max_draw_count, const starlib::u32 indirect_index = 0, const draw_indexed_index_type index_type = draw_indexed_index_type::UINT_32) : indirect_buffer(indirect_buffer), mode(mode), index_type(index_type), draw_count(max_draw_count), indirect_index(indirect_index), count_buffer(object_identifier(count_buffer)), count_address(count_address) {}
 
         [[nodiscard]] command_type type() const override
         {
-            return command_type::DRAW_INDIRECT;
+            return command_type::DRAW_INDEXED_INDIRECT;
         }
 
         object_identifier indirect_buffer;
         draw_mode mode;
         draw_indexed_index_type index_type;
+        ///Number of draws, or the maximum number of draws if a count buffer is used.
         starlib::u32 draw_count;
         starlib::u32 indirect_index;
-    };
-
-    ///Sets the active draw specification. A valid draw specification must be set prior to calling any draw commands.
-    struct configure_draw final : command
-    {
-        explicit configure_draw(const std::string& draw_specification) : draw_specification(draw_specification) {}
-        [[nodiscard]] command_type type() const override
-        {
-            return command_type::CONFIG_DRAW;
-        }
-
-        object_identifier draw_specification;
+        std::optional<object_identifier> count_buffer;
+        starlib::u64 count_address = 0;
     };
 
     ///Stencil test function options
@@ -480,6 +479,56 @@ namespace stardraw
         clear_values values = clear_info_defaults::FLOAT_DEFAULT;
     };
 
+    ///What happens to the contents of a framebuffer attachment when a pass starts using it.
+    /// - LOAD: The existing contents are kept.
+    /// - CLEAR: The attachment is cleared to a value.
+    /// - DONT_CARE: The existing contents aren't needed, and are undefined until drawn over.
+    enum class attachment_load_action : starlib::u8
+    {
+        LOAD, CLEAR, DONT_CARE,
+    };
+
+    ///What happens to the contents of a framebuffer attachment when a pass stops using it.
+    /// - STORE: The contents are kept for later use.
+    /// - DONT_CARE: The contents aren't needed after the pass, and may be discarded.
+    enum class attachment_store_action : starlib::u8
+    {
+        STORE, DONT_CARE,
+    };
+
+    ///Load and store actions for a single framebuffer attachment.
+    struct attachment_actions
+    {
+        attachment_load_action load = attachment_load_action::LOAD;
+        attachment_store_action store = attachment_store_action::STORE;
+        ///Used by the CLEAR load action. Depth and stencil attachments use the depth and stencil values.
+        clear_values clear_value = clear_info_defaults::FLOAT_DEFAULT;
+    };
+
+    ///Load and store actions for the attachments of a framebuffer. Color actions are indexed like the framebuffer's color attachments,
+    ///and attachments without actions given are loaded and stored.
+    struct framebuffer_pass_actions
+    {
+        std::vector<attachment_actions> color;
+        attachment_actions depth;
+        attachment_actions stencil;
+    };
+
+    ///Sets the active draw specification. A valid draw specification must be set prior to calling any draw commands.
+    ///If the draw specification renders to a framebuffer, pass actions may be given to start a pass on it: load actions are applied immediately, and store
+    ///actions when the pass ends - when a different framebuffer (or the same framebuffer with new pass actions) is configured, or the command list finishes.
+    struct configure_draw final : command
+    {
+        explicit configure_draw(const std::string& draw_specification, const std::optional<framebuffer_pass_actions>& pass_actions = std::nullopt) : draw_specification(draw_specification), pass_actions(pass_actions) {}
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::CONFIG_DRAW;
+        }
+
+        object_identifier draw_specification;
+        std::optional<framebuffer_pass_actions> pass_actions;
+    };
+
     ///Clears some number of framebuffer attachments to the given values.
     struct clear_framebuffer final : command
     {
@@ -530,16 +579,145 @@ namespace stardraw
     };
 
     ///Set a fence ('signal') that can be checked via the render context to determine when previous commands are finished.
+    ///Signals form a single timeline: each signal records a value, which must be higher than every value signalled before it,
+    ///and a value is reached once the GPU has finished every command before its signal (see render_context::completed_signal_value).
+    ///Command buffers that are executed more than once should signal the next value instead, and get it from render_context::last_signal_value.
     struct signal final : command
     {
-        explicit signal(const std::string_view& signal_name) : signal_name(signal_name) {}
+        ///Signal the next value on the timeline, one higher than the last value signalled.
+        signal() : value(0) {}
+        explicit signal(const starlib::u64 value) : value(value) {}
 
         [[nodiscard]] command_type type() const override
         {
             return command_type::SIGNAL;
         }
 
-        std::string signal_name;
+        ///0 signals the next value.
+        starlib::u64 value;
+    };
+
+    ///Makes any incoherent shader writes (storage buffer / image stores) to the given objects visible to all following commands.
+    ///Stardraw inserts barriers automatically for objects bound to shaders, so this is only needed for dependencies it can't see,
+    ///such as separate objects that share the same underlying memory (texture views).
+    struct memory_barrier final : command
+    {
+        memory_barrier(const std::initializer_list<object_identifier> objects) : objects(objects) {}
+        explicit memory_barrier(const std::vector<object_identifier>& objects) : objects(objects) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::MEMORY_BARRIER;
+        }
+
+        std::vector<object_identifier> objects;
+    };
+
+    ///Types of GPU query. All results are u64 values:
+    /// - TIME_ELAPSED: GPU time taken by the commands between the begin and end of the query, in nanoseconds.
+    /// - SAMPLES_PASSED: Number of samples that passed the depth and stencil tests.
+    /// - PRIMITIVES_GENERATED: Number of primitives emitted by the vertex processing stages.
+    enum class query_type : starlib::u8
+    {
+        TIME_ELAPSED, SAMPLES_PASSED, PRIMITIVES_GENERATED,
+    };
+
+    ///Status for queries. Not used in the commands, but returned when reading query results via the render context.
+    enum class query_status : starlib::u8
+    {
+        AVAILABLE, PENDING, UNKNOWN_QUERY,
+    };
+
+    ///Start measuring a named GPU query. Only one query of each type may be active at once.
+    ///Results are read back without stalling once the GPU has finished with them (usually a few frames later). See render_context::get_query_result.
+    struct begin_query final : command
+    {
+        begin_query(const std::string_view& query_name, const query_type query_kind) : query_name(query_name), query_kind(query_kind) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::BEGIN_QUERY;
+        }
+
+        std::string query_name;
+        query_type query_kind;
+    };
+
+    ///Stop measuring a named GPU query.
+    struct end_query final : command
+    {
+        explicit end_query(const std::string_view& query_name) : query_name(query_name) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::END_QUERY;
+        }
+
+        std::string query_name;
+    };
+
+    ///Start a named occlusion query, which records whether any samples of the following draws pass the depth and stencil tests.
+    ///Occlusion queries stay on the GPU and are only used to drive conditional rendering, so the CPU never waits on their results.
+    ///Only one occlusion query (or SAMPLES_PASSED query) may be active at once. Beginning a query again replaces its previous result.
+    ///Conservative queries may report samples passing when none did, but can be cheaper to evaluate.
+    struct begin_occlusion_query final : command
+    {
+        explicit begin_occlusion_query(const std::string_view& query_name, const bool conservative = false) : query_name(query_name), conservative(conservative) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::BEGIN_OCCLUSION_QUERY;
+        }
+
+        std::string query_name;
+        bool conservative;
+    };
+
+    ///Stop recording a named occlusion query.
+    struct end_occlusion_query final : command
+    {
+        explicit end_occlusion_query(const std::string_view& query_name) : query_name(query_name) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::END_OCCLUSION_QUERY;
+        }
+
+        std::string query_name;
+    };
+
+    ///How conditional rendering treats occlusion queries that haven't finished yet.
+    /// - WAIT: Wait on the GPU for the query result.
+    /// - NO_WAIT: Render anyway if the result isn't ready.
+    /// - BY_REGION_*: As above, but the query may be evaluated per framebuffer region, which can be cheaper on tiled GPUs.
+    enum class conditional_render_mode : starlib::u8
+    {
+        WAIT, NO_WAIT, BY_REGION_WAIT, BY_REGION_NO_WAIT,
+    };
+
+    ///Skip draws, clears and copies on the GPU until end_conditional_render if no samples passed during a named occlusion query.
+    ///Inverted conditional rendering skips them if any samples passed instead. Conditional rendering can't be nested.
+    struct begin_conditional_render final : command
+    {
+        explicit begin_conditional_render(const std::string_view& query_name, const conditional_render_mode mode = conditional_render_mode::WAIT, const bool inverted = false) : query_name(query_name), mode(mode), inverted(inverted) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::BEGIN_CONDITIONAL_RENDER;
+        }
+
+        std::string query_name;
+        conditional_render_mode mode;
+        bool inverted;
+    };
+
+    ///Stop conditional rendering.
+    struct end_conditional_render final : command
+    {
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::END_CONDITIONAL_RENDER;
+        }
     };
 
     ///Information required to perform texture copies
@@ -595,6 +773,38 @@ namespace stardraw
         texture_copy_info copy_info;
     };
 
+    ///How generate_mipmaps computes each texel of a level from the level above it.
+    /// - DEFAULT: The driver's own downsampling (usually a box filter). Supports any filterable, color renderable texture.
+    /// - AVERAGE: The average of each 2x2 block, in a compute shader. sRGB textures are averaged in linear space.
+    /// - MIN / MAX: The smallest / largest value of each block, per channel, in a compute shader. For instance, a hierarchical-Z pyramid
+    ///   is built with MAX (or MIN for reversed depth) on an R_F32 texture holding a copy of the depth buffer, as depth textures can't be written by shaders.
+    ///Compute filters cover the extra row / column of odd sized levels, so MIN / MAX never skip a texel. They require a 2D, array or cubemap texture
+    ///with R, RG or RGBA channels of 8-bit normalized, F16 or F32 data, or SRGBA_U8_NORM.
+    enum class mipmap_filter : starlib::u8
+    {
+        DEFAULT, AVERAGE, MIN, MAX,
+    };
+
+    ///Fills mipmap levels of a texture by repeatedly downsampling, starting from base_level. Levels base_level + 1 to base_level + level_count are written,
+    ///for layers layer to layer + layers (cubemap faces count as layers). Zero level_count or layers extends the range to the end of the texture.
+    ///Barriers for earlier writes to the texture, and for later reads of the generated levels, are inserted automatically.
+    struct generate_mipmaps final : command
+    {
+        explicit generate_mipmaps(const std::string_view& texture, const mipmap_filter filter = mipmap_filter::DEFAULT, const starlib::u32 base_level = 0, const starlib::u32 level_count = 0, const starlib::u32 layer = 0, const starlib::u32 layers = 0) : texture(texture), filter(filter), base_level(base_level), level_count(level_count), layer(layer), layers(layers) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::GENERATE_MIPMAPS;
+        }
+
+        object_identifier texture;
+        mipmap_filter filter;
+        starlib::u32 base_level;
+        starlib::u32 level_count;
+        starlib::u32 layer;
+        starlib::u32 layers;
+    };
+
     ///Marks the start of the frame.
     ///It is undefined behaviour if you do not call this at the end of your frame rendering.
     struct aquire final : command
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <optional>
 #include <utility>
 
@@ -156,11 +157,24 @@ namespace stardraw
         std::optional<object_identifier> framebuffer;
     };
 
-    ///Describes a shader made up of some number of shader states
+    ///Status for shaders. Not used in the descriptor, but returned when querying shader state.
+    ///Shaders may compile in the background after being created - using a shader that is still compiling will wait for it to finish.
+    enum class shader_status : starlib::u8
+    {
+        READY, COMPILING, FAILED, UNKNOWN_SHADER
+    };
+
+    ///Describes a shader made up of some number of shader states.
+    ///Cache data (see render_context::get_shader_cache_data) can be provided to skip compiling the stages. Cache data is backend and driver specific,
+    ///so if it is rejected the shader will be compiled from the stages instead (or fail to create if there are no stages).
     struct shader final : descriptor
     {
         shader(const std::string_view& name, const std::vector<shader_stage>& stages) : descriptor(name), stages(stages), cache_ptr(nullptr), cache_size(0) {}
         shader(const std::string_view& name, const void* cache_ptr, const starlib::u64 cache_size) : descriptor(name), stages({}), cache_ptr(cache_ptr), cache_size(cache_size) {}
+        shader(const std::string_view& name, const std::vector<shader_stage>& stages, const void* cache_ptr, const starlib::u64 cache_size) : descriptor(name), stages(stages), cache_ptr(cache_ptr), cache_size(cache_size) {}
+        shader(const std::string_view& name, const std::vector<shader_stage>& stages, const std::vector<shader_specialization_constant>& specialization_constants) : descriptor(name), stages(stages), cache_ptr(nullptr), cache_size(0), specialization_constants(specialization_constants) {}
+        ///Shader using a variant from a variant library. The variant is compiled when the shader is created if it hasn't been used before.
+        shader(const std::string_view& name, shader_variant_library* variant_library, const shader_variant_key& variant) : descriptor(name), stages({}), cache_ptr(nullptr), cache_size(0), variant_library(variant_library), variant(variant) {}
 
         [[nodiscard]] descriptor_type type() const override
         {
@@ -170,6 +184,14 @@ namespace stardraw
         std::vector<shader_stage> stages;
         const void* cache_ptr;
         const starlib::u64 cache_size;
+        shader_variant_library* variant_library = nullptr;
+        shader_variant_key variant;
+
+        ///Specialization constant values applied to every stage, replacing any values set on the stages themselves.
+        std::vector<shader_specialization_constant> specialization_constants;
+
+        ///Compile-time buffer layouts (see buffer_layout::for_buffer) checked against the stages when the shader is created.
+        std::vector<shader_buffer_layout> buffer_layouts;
     };
 
     ///Specifies how texture data is interpreted.
@@ -202,9 +224,160 @@ namespace stardraw
         R_F16, RG_F16, RGB_F16, RGBA_F16,
         R_F32, RG_F32, RGB_F32, RGBA_F32,
 
-        //TODO: Support compressed textures?
+        //Block-compressed formats. Data is uploaded already compressed, in whole blocks, and they can't be rendered to.
+        //BC (S3TC / RGTC / BPTC) formats, 4x4 blocks. BC1-3 require S3TC support from the driver, which is practically universal on desktop.
+        BC1_RGB, BC1_SRGB, BC1_RGBA, BC1_SRGBA,
+        BC2_RGBA, BC2_SRGBA,
+        BC3_RGBA, BC3_SRGBA,
+        BC4_R, BC4_R_SIGNED,
+        BC5_RG, BC5_RG_SIGNED,
+        BC6H_RGB_F16, BC6H_RGB_UF16,
+        BC7_RGBA, BC7_SRGBA,
+
+        //ETC2 / EAC formats, 4x4 blocks.
+        ETC2_RGB, ETC2_SRGB, ETC2_RGB_A1, ETC2_SRGB_A1, ETC2_RGBA, ETC2_SRGBA,
+        EAC_R, EAC_R_SIGNED, EAC_RG, EAC_RG_SIGNED,
+
+        //ASTC (LDR) formats, block size in the name. Require ASTC support from the driver.
+        ASTC_4X4_RGBA, ASTC_4X4_SRGBA,
+        ASTC_6X6_RGBA, ASTC_6X6_SRGBA,
+        ASTC_8X8_RGBA, ASTC_8X8_SRGBA,
     };
 
+    ///Number of bytes used to store a single texel of an uncompressed texture data type. Use texture_data_type_block_info for compressed types.
+    inline starlib::u32 texture_data_type_element_bytes(const texture_data_type type)
+    {
+        switch (type)
+        {
+            case texture_data_type::R_U8:
+            case texture_data_type::R_I8:
+            case texture_data_type::STENCIL_U8:
+            case texture_data_type::R_U8_NORM: return 1;
+            case texture_data_type::RG_U8:
+            case texture_data_type::RG_U8_NORM:
+            case texture_data_type::R_U16:
+            case texture_data_type::RG_I8:
+            case texture_data_type::R_I16:
+            case texture_data_type::DEPTH_U16_NORM:
+            case texture_data_type::R_F16: return 2;
+            case texture_data_type::RGB_U8:
+            case texture_data_type::RGB_I8:
+            case texture_data_type::DEPTH_U24_NORM:
+            case texture_data_type::RGB_U8_NORM:
+            case texture_data_type::SRGB_U8_NORM: return 3;
+            case texture_data_type::RGBA_U8_NORM:
+            case texture_data_type::SRGBA_U8_NORM:
+            case texture_data_type::RG_F16:
+            case texture_data_type::R_F32:
+            case texture_data_type::RGBA_I8:
+            case texture_data_type::RGBA_U8:
+            case texture_data_type::RG_U16:
+            case texture_data_type::R_U32:
+            case texture_data_type::RG_I16:
+            case texture_data_type::R_I32:
+            case texture_data_type::DEPTH_U32_NORM:
+            case texture_data_type::DEPTH_F32:
+            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8: return 4;
+            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8: return 5;
+            case texture_data_type::RGB_F16:
+            case texture_data_type::RGB_U16:
+            case texture_data_type::RGB_I16: return 6;
+            case texture_data_type::RG_U32:
+            case texture_data_type::RGBA_U16:
+            case texture_data_type::RGBA_I16:
+            case texture_data_type::RGBA_F16:
+            case texture_data_type::RG_F32:
+            case texture_data_type::RG_I32: return 8;
+            case texture_data_type::RGB_U32:
+            case texture_data_type::RGB_F32:
+            case texture_data_type::RGB_I32: return 12;
+            case texture_data_type::RGBA_U32:
+            case texture_data_type::RGBA_F32:
+            case texture_data_type::RGBA_I32: return 16;
+            default: return -1;
+        }
+    }
+
+    ///The unit texture data is stored (and transferred) in: a block of width x height texels taking some number of bytes.
+    ///Uncompressed data types are stored in 1x1 blocks, one texel each.
+    struct texture_data_block
+    {
+        starlib::u32 width;
+        starlib::u32 height;
+        starlib::u32 bytes;
+    };
+
+    inline texture_data_block texture_data_type_block_info(const texture_data_type type)
+    {
+        switch (type)
+        {
+            case texture_data_type::BC1_RGB:
+            case texture_data_type::BC1_SRGB:
+            case texture_data_type::BC1_RGBA:
+            case texture_data_type::BC1_SRGBA:
+            case texture_data_type::BC4_R:
+            case texture_data_type::BC4_R_SIGNED:
+            case texture_data_type::ETC2_RGB:
+            case texture_data_type::ETC2_SRGB:
+            case texture_data_type::ETC2_RGB_A1:
+            case texture_data_type::ETC2_SRGB_A1:
+            case texture_data_type::EAC_R:
+            case texture_data_type::EAC_R_SIGNED: return {4, 4, 8};
+            case texture_data_type::BC2_RGBA:
+            case texture_data_type::BC2_SRGBA:
+            case texture_data_type::BC3_RGBA:
+            case texture_data_type::BC3_SRGBA:
+            case texture_data_type::BC5_RG:
+            case texture_data_type::BC5_RG_SIGNED:
+            case texture_data_type::BC6H_RGB_F16:
+            case texture_data_type::BC6H_RGB_UF16:
+            case texture_data_type::BC7_RGBA:
+            case texture_data_type::BC7_SRGBA:
+            case texture_data_type::ETC2_RGBA:
+            case texture_data_type::ETC2_SRGBA:
+            case texture_data_type::EAC_RG:
+            case texture_data_type::EAC_RG_SIGNED:
+            case texture_data_type::ASTC_4X4_RGBA:
+            case texture_data_type::ASTC_4X4_SRGBA: return {4, 4, 16};
+            case texture_data_type::ASTC_6X6_RGBA:
+            case texture_data_type::ASTC_6X6_SRGBA: return {6, 6, 16};
+            case texture_data_type::ASTC_8X8_RGBA:
+            case texture_data_type::ASTC_8X8_SRGBA: return {8, 8, 16};
+            default: return {1, 1, texture_data_type_element_bytes(type)};
+        }
+    }
+
+    inline bool is_texture_data_type_compressed(const texture_data_type type)
+    {
+        const texture_data_block block = texture_data_type_block_info(type);
+        return block.width > 1 || block.height > 1;
+    }
+
+    inline bool does_texture_data_type_have_depth(const texture_data_type type)
+    {
+        switch (type)
+        {
+            case texture_data_type::DEPTH_F32:
+            case texture_data_type::DEPTH_U32_NORM:
+            case texture_data_type::DEPTH_U24_NORM:
+            case texture_data_type::DEPTH_U16_NORM:
+            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8:
+            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8: return true;
+            default: return false;
+        }
+    }
+
+    inline bool does_texture_data_type_have_stencil(const texture_data_type type)
+    {
+        switch (type)
+        {
+            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8:
+            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8:
+            case texture_data_type::STENCIL_U8: return true;
+            default: return false;
+        }
+    }
+
     ///Texture 'shape' determines what coordinates are used to read from the texture.
     enum class texture_shape : starlib::u8
     {
@@ -276,8 +449,27 @@ namespace stardraw
         {
             return {.data_type = data_type, .shape = texture_shape::CUBE_MAP, .width = width, .height = height, .layers = num_cubemaps * 6, .mipmap_levels = mipmap_levels};
         }
+
+        bool operator==(const texture_format&) const = default;
     };
 
+    ///Approximate number of bytes of GPU memory used by a texture with some format, including all of its mipmaps, layers and samples.
+    inline starlib::u64 texture_format_bytes(const texture_format& format)
+    {
+        const starlib::u64 samples = format.msaa == texture_msaa_level::NONE ? 1 : static_cast<starlib::u64>(format.msaa);
+        const texture_data_block block = texture_data_type_block_info(format.data_type);
+        starlib::u64 bytes = 0;
+        for (starlib::u32 level = 0; level < format.mipmap_levels; level++)
+        {
+            //Partial blocks at the edges of a level are stored as whole blocks.
+            const starlib::u64 blocks_x = (std::max(format.width >> level, 1u) + block.width - 1) / block.width;
+            const starlib::u64 blocks_y = (std::max(format.height >> level, 1u) + block.height - 1) / block.height;
+            const starlib::u64 depth = std::max(format.depth >> level, 1u);
+            bytes += blocks_x * blocks_y * depth * format.layers * samples * block.bytes;
+        }
+        return bytes;
+    }
+
     ///Level of anisotropic filtering to use on a texture.
     ///Requires that filtering must be able to account for at least an aspect ratio of 1/X where X is the anistropy level.
     enum class texture_anisotropy_level : starlib::u8
@@ -368,6 +560,11 @@ namespace stardraw
         texture_format format;
         texture_sampling_conifg default_sampling_config;
         std::optional<object_identifier> as_view_of;
+
+        ///Streamed textures only sample from mipmap levels that have finished uploading: sampling starts at the smallest level, and moves to each
+        ///larger level once it (and every level smaller than it) has been fully uploaded and the GPU has finished the upload. See texture_streamer.
+        ///Texture views can't be streamed.
+        bool streamed = false;
     };
 
     ///Describes a texture sampling config that can be applied to a specific sampler via shader parameters.
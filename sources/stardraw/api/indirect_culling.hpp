@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <string_view>
+
+#include "buffer_layout.hpp"
+#include "commands.hpp"
+#include "descriptors.hpp"
+#include "shaders.hpp"
+#include "starlib/general/status.hpp"
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    ///Layout of the uniform buffer the culling constants are written into: 6 frustum planes followed by the instance count.
+    typedef buffer_layout<buffer_layout_rules::STD140, shader_array<shader_vector<starlib::f32, 4>, 6>, starlib::u32> indirect_culling_constants_layout;
+
+    ///Objects and values used by one run of an indirect culling shader.
+    struct indirect_culling_config
+    {
+        ///Buffer of at least indirect_culling_constants_layout::size bytes that the culling constants are written into.
+        object_identifier constants_buffer;
+
+        ///One bounding sphere per instance, as 4 floats: centre xyz, radius w.
+        object_identifier instance_bounds_buffer;
+
+        ///One draw command per instance (see indirect_culling_shader::command_size). Give each command its own start instance to find per-instance data when drawing.
+        object_identifier source_commands_buffer;
+
+        ///Receives the draw commands of visible instances, packed from the start of the buffer. Must have room for instance_count commands.
+        object_identifier output_commands_buffer;
+
+        ///Receives the number of visible instances as a u32 at address 0. Use it as the count buffer of draw_indirect / draw_indexed_indirect.
+        object_identifier count_buffer;
+
+        starlib::u32 instance_count = 0;
+
+        ///Frustum planes as (normal xyz, distance w) with normals pointing into the frustum. Spheres entirely behind any plane are culled.
+        std::array<starlib::f32, 24> frustum_planes {};
+    };
+
+    ///Reference GPU-driven culling: compute shaders that test per-instance bounding spheres against the view frustum and compact the
+    ///draw commands of visible instances into an indirect buffer, writing the visible count into a count buffer for indirect count draws.
+    class indirect_culling_shader
+    {
+    public:
+        ///Compile the culling shaders. Indexed shaders copy draw_indexed_indirect commands, others copy draw_indirect commands.
+        [[nodiscard]] static starlib::status create(const shader_compiler_context* compiler, const starlib::graphics_api& api, bool indexed, indirect_culling_shader& out_shader);
+
+        ///Shader descriptors to create in a render context before recording any culling commands with the same name.
+        [[nodiscard]] descriptor_list descriptors(const std::string_view& name) const;
+
+        ///Record the commands that reset the count and cull the instances. The shaders must have been created from descriptors(name).
+        [[nodiscard]] starlib::status record(const std::string_view& name, const indirect_culling_config& config, command_list& out_commands) const;
+
+        ///Size in bytes of one draw command in the source and output command buffers.
+        [[nodiscard]] starlib::u32 command_size() const;
+
+        ///Number of instances tested by each compute workgroup.
+        static constexpr starlib::u32 group_size = 64;
+
+    private:
+        shader_stage reset_stage;
+        shader_stage cull_stage;
+        bool indexed = false;
+    };
+}
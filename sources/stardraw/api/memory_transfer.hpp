@@ -68,8 +68,9 @@ namespace stardraw
         starlib::u32 layers = 1;
 
         //The data type that the pixels being uploaded are provided as.
+        //Ignored for compressed textures, which are uploaded as blocks already in the texture's data type.
         pixel_data_type data_type = pixel_data_type::U8;
-        //The channels that the pixels being provided include
+        //The channels that the pixels being provided include. Ignored for compressed textures.
         pixel_channels channels = pixel_channels::RGBA;
     };
 
@@ -82,6 +83,11 @@ namespace stardraw
         //Transfer the requested memory amount in or out of data. Blocks calling thread until transfer is completed (or an error status is generated)
         //Call from a different thread if you want to avoid blocking your render thread during the transfer
         virtual starlib::status transfer(void* data) = 0;
+
+        //Get the transfer memory to write into directly, instead of copying from data with transfer() - for instance, with buffer_layout::write.
+        //The handle counts as transferred once this returns, so all of the requested memory must be written before the handle is flushed.
+        virtual starlib::status transfer_direct(void*& out_destination) = 0;
+
         virtual memory_transfer_status transfer_status() = 0;
     };
 
@@ -99,8 +105,33 @@ namespace stardraw
         std::vector<pad> pads;
     };
 
+    ///A memory layout compiled into the runs of bytes copied for each element, so laying out many elements doesn't re-walk the pad list.
+    ///Build one once per layout (for instance, when the shader is created) and reuse it for every transfer.
+    struct memory_layout_plan
+    {
+        struct copy_run
+        {
+            starlib::u64 packed_offset;
+            starlib::u64 padded_offset;
+            starlib::u64 size;
+        };
+
+        starlib::u64 packed_size = 0;
+        starlib::u64 padded_size = 0;
+        std::vector<copy_run> runs;
+    };
+
+    [[nodiscard]] memory_layout_plan plan_memory_layout(const memory_layout_info& layout);
+
     ///Allocates and returns a new block of memory with the data laid out according to the layout information.
     ///Inserted padding space is left uninitialized.
     ///NOTE: Input data is assumed to be tightly packed. Using non-tightly-packed input data will result in unexpected behaviour!
     [[nodiscard]] void* layout_memory(const memory_layout_info& layout, const void* data, const starlib::u64 data_size);
+
+    ///Lays out packed data into a caller-provided destination (for instance, transfer memory), which must hold padded_size bytes per element.
+    ///Inserted padding space may be overwritten with arbitrary data.
+    void layout_memory(const memory_layout_plan& plan, const void* data, const starlib::u64 data_size, void* destination);
+
+    ///The inverse of layout_memory, for readbacks: strips the padding from laid out data, writing packed_size bytes per element to the destination.
+    void pack_memory(const memory_layout_plan& plan, const void* padded_data, const starlib::u64 padded_data_size, void* destination);
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <filesystem>
+#include <functional>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "commands.hpp"
 #include "common.hpp"
@@ -11,6 +15,44 @@
 
 namespace stardraw
 {
+    ///Counters describing how memory barriers between incoherent shader writes and later reads were handled by a render context.
+    struct barrier_statistics
+    {
+        ///Number of full memory barriers issued to the backend.
+        starlib::u64 barriers_issued = 0;
+        ///Number of framebuffer-region-local memory barriers issued to the backend.
+        starlib::u64 region_barriers_issued = 0;
+        ///Number of barriers a write needed that were already covered by an earlier barrier, or were merged into another barrier.
+        starlib::u64 barriers_elided = 0;
+    };
+
+    ///GPU time spent executing a named command buffer. See render_context_config::time_command_buffers.
+    struct command_buffer_timing
+    {
+        ///GPU time of the most recent execution measured, in nanoseconds.
+        starlib::u64 last_nanos = 0;
+        ///Total GPU time of every execution measured, in nanoseconds.
+        starlib::u64 total_nanos = 0;
+        ///Number of executions measured.
+        starlib::u64 executions = 0;
+    };
+
+    ///CPU and GPU timing of a presented frame. See render_context::collect_frame_statistics.
+    struct frame_statistics
+    {
+        ///Number of the frame, counting presents from 1.
+        starlib::u64 frame = 0;
+        ///CPU time from the previous present to this one, in nanoseconds.
+        starlib::u64 cpu_frame_nanos = 0;
+        ///Time present spent waiting for the GPU to keep within render_context_config::frames_in_flight, in nanoseconds.
+        starlib::u64 cpu_wait_nanos = 0;
+        ///Time from present until the CPU saw that the GPU had finished the frame, in nanoseconds.
+        ///Frames are checked at each present, so unless present had to wait for this frame, the lag is rounded up to a later present.
+        starlib::u64 gpu_lag_nanos = 0;
+        ///Number of unfinished frames (including this one) when present returned. This is how far the CPU actually ran ahead of the GPU.
+        starlib::u32 frames_in_flight = 0;
+    };
+
     ///Render context configuration information
     struct render_context_config
     {
@@ -27,11 +69,74 @@ namespace stardraw
         ///Callback that will be passed additional validation messages that are not returned via statuses.
         std::function<void(const std::string message)> validation_message_callback;
 
+        ///Toggle whether the GPU time taken by every execution of a named command buffer is measured (see render_context::get_command_buffer_timings).
+        ///Uses a pair of timestamp queries per execution, so it's cheap enough to leave on in production builds.
+        bool time_command_buffers = false;
+
+        ///Maximum number of frames the CPU may run ahead of the GPU. Once this many frames are unfinished, present waits for the oldest one.
+        ///Fewer frames in flight lowers input latency, more lets the CPU keep working while the GPU is busy. 2 suits most applications.
+        ///0 leaves the limit to the driver, which may queue several frames under load.
+        starlib::u32 frames_in_flight = 0;
+
         ///--- OPENGL ---
 
         ///Custom gl loader function (such as GLFWGetProcAddress, SDL_GL_GetProcAddress, etc)
         ///OpenGL support will work without a loader, but it's more efficient to use one if you have it!
         starlib::gl_loader_func gl_loader;
+
+        ///Optional directory to persist compiled shader programs in. Programs are keyed by their SPIR-V and the active driver,
+        ///so shaders that have been created before (with the same driver) can skip compilation entirely. Leave empty to disable.
+        std::filesystem::path shader_cache_directory;
+
+        ///Toggle whether shaders are loaded as SPIR-V directly when the driver supports it (GL_ARB_gl_spirv), instead of being transpiled to GLSL and recompiled.
+        ///Shaders that use features GL SPIR-V can't express (such as separate samplers) always use the GLSL path. Disable this to work around driver bugs.
+        bool native_spirv_shaders = true;
+
+        ///Toggle whether memory barriers between fragment shader writes and fragment shader reads of the same framebuffer may be issued per-region.
+        ///Region barriers are cheaper (especially on tiled GPUs), but only make writes visible to reads of the same pixel / sample.
+        ///Only enable this if your fragment shaders never read values written by *other* fragments to the same framebuffer, as those reads become undefined.
+        bool framebuffer_region_barriers = false;
+
+        ///Optional function that makes a second GL context current on the calling thread, returning false if it couldn't.
+        ///The context must be created by your windowing library and share objects with the main context (for instance, a hidden GLFW window created
+        ///with the main window as its share parameter). If provided, the render context runs a loader thread on this context for load_objects_async.
+        std::function<bool()> gl_loader_context_make_current;
+
+        ///Called on the loader thread just before it exits, to release the loader context (for instance, by making no context current).
+        std::function<void()> gl_loader_context_release;
+    };
+
+    ///Data to write to a buffer created by a background load.
+    struct background_buffer_data
+    {
+        object_identifier buffer;
+        starlib::u64 address = 0;
+        std::vector<starlib::u8> data;
+    };
+
+    ///Data to write to a region of a texture created by a background load, laid out as for a texture memory transfer.
+    ///The region's transfer buffer is ignored, as the loader uploads the data itself.
+    struct background_texture_data
+    {
+        texture_memory_transfer_info region;
+        std::vector<starlib::u8> data;
+    };
+
+    ///A batch of objects to create and fill on the loader thread. See render_context::load_objects_async.
+    struct background_load
+    {
+        descriptor_list descriptors;
+        std::vector<background_buffer_data> buffer_data;
+        std::vector<background_texture_data> texture_data;
+    };
+
+    ///Status of a background load.
+    /// - PENDING: The loader thread (or the GPU) is still working on it, and none of its objects can be used yet.
+    /// - COMPLETE: Every object in the load has been created, filled, and added to the context.
+    /// - FAILED: Nothing from the load was added to the context.
+    enum class load_status : starlib::u8
+    {
+        PENDING, COMPLETE, FAILED, UNKNOWN_LOAD,
     };
 
     ///Main render context interface that manages graphics state and objects.
@@ -62,17 +167,68 @@ namespace stardraw
         ///so unexpected behaviour may occur if you delete an object that is still being referenced by any other objects.
         [[nodiscard]] virtual starlib::status delete_object(descriptor_type type, const std::string_view& name) = 0;
 
+        ///Check whether a named shader has finished compiling, without waiting for it.
+        ///If the shader failed to compile, the error will be returned by any call that tries to use it.
+        [[nodiscard]] virtual shader_status check_shader(const std::string_view& name) = 0;
+
+        ///Get backend and driver specific data that can be provided to a shader descriptor to recreate a shader without compiling it.
+        [[nodiscard]] virtual starlib::status get_shader_cache_data(const std::string_view& name, std::vector<starlib::u8>& out_data) = 0;
+
         ///Execute a previously defined command buffer. You should set up and reuse command buffers for commands that do not require dynamic data.
         [[nodiscard]] virtual starlib::status execute_command_buffer(const std::string_view& name) = 0;
 
         ///Consume and execute a given command buffer immediately. You should only use this for commands that require dynamic data.
         [[nodiscard]] virtual starlib::status execute_command_buffer(const command_list&& cmd_buffer) = 0;
 
-        ///Check the status of a named signal
-        [[nodiscard]] virtual signal_status check_signal(const std::string_view& name) = 0;
+        ///Get the highest signal value the GPU has reached (see signal), or 0 if none has been reached yet.
+        ///Safe to call from any thread. It advances when the render thread polls signals, which happens on present, check_signal and wait_signal.
+        [[nodiscard]] virtual starlib::u64 completed_signal_value() const = 0;
+
+        ///Get the value of the most recently executed signal command, including signals of the next value, or 0 if nothing has been signalled.
+        [[nodiscard]] virtual starlib::u64 last_signal_value() const = 0;
+
+        ///Check whether the GPU has reached a signal value, without waiting. UNKNOWN_SIGNAL is returned for values that haven't been signalled yet.
+        [[nodiscard]] virtual signal_status check_signal(starlib::u64 value) = 0;
+
+        ///Wait for the GPU to reach a signal value. UNKNOWN_SIGNAL is returned for values that haven't been signalled yet, as waiting on them would never finish.
+        [[nodiscard]] virtual signal_status wait_signal(starlib::u64 value, starlib::u64 timeout_nanos) = 0;
+
+        ///Get the memory barrier counters accumulated since the context was created or the counters were last reset.
+        [[nodiscard]] virtual barrier_statistics get_barrier_statistics() const = 0;
+
+        ///Reset the memory barrier counters.
+        virtual void reset_barrier_statistics() = 0;
+
+        ///Get the latest result of a named query (see begin_query). Results are collected without waiting for the GPU,
+        ///so PENDING is returned until the first result for the query has arrived.
+        [[nodiscard]] virtual query_status get_query_result(const std::string_view& name, starlib::u64& out_result) = 0;
+
+        ///Get the GPU time taken by named command buffers, keyed by command buffer name. Only measured if time_command_buffers was enabled in the config.
+        ///Like query results, timings arrive a few frames after the command buffer executes.
+        [[nodiscard]] virtual std::unordered_map<std::string, command_buffer_timing> get_command_buffer_timings() = 0;
+
+        ///Reset the command buffer timings.
+        virtual void reset_command_buffer_timings() = 0;
+
+        ///Take the statistics of every frame the GPU has finished since the last call, oldest first. Only the most recent few hundred frames are kept.
+        [[nodiscard]] virtual std::vector<frame_statistics> collect_frame_statistics() = 0;
+
+        ///Create and fill a batch of objects on the loader thread (see render_context_config::gl_loader_context_make_current), without blocking the calling thread.
+        ///Descriptors are consumed in order, and may reference objects from earlier in the same load or objects already in the context.
+        ///Buffers, textures, samplers and shaders are created on the loader thread. Objects that GL can't share between contexts (vertex and draw configurations,
+        ///framebuffers, transfer buffers) are created when the load is published, which is cheap as their data lives in the shared objects.
+        ///Texture views in a load must view a texture from the same load. Shader compile errors are reported when the shader is used, as for create_objects.
+        ///Shader variants are resolved (and compiled, if they haven't been used before) on the calling thread, as variant libraries aren't thread safe.
+        ///A load is published to the context once the GPU has finished its uploads, during check_load or present, so it never waits on the GPU.
+        [[nodiscard]] virtual starlib::status load_objects_async(const std::string_view& name, background_load&& load) = 0;
+
+        ///Check a background load, publishing it if the GPU has finished with it. If the load failed, its error is returned.
+        ///Finished loads are forgotten once they have been checked, after which UNKNOWN_LOAD is reported.
+        [[nodiscard]] virtual starlib::status check_load(const std::string_view& name, load_status& out_status) = 0;
 
-        ///Wait for a named signal to be flagged
-        [[nodiscard]] virtual signal_status wait_signal(const std::string_view& name, const starlib::u64 timeout_nanos) = 0;
+        ///Get the lowest mipmap level of a streamed texture that can currently be sampled (see texture::streamed).
+        ///out_level is the texture's number of mipmap levels until its smallest level arrives, and 0 for textures that aren't streamed.
+        [[nodiscard]] virtual starlib::status get_texture_resident_level(const std::string_view& name, starlib::u32& out_level) = 0;
 
         //Create a memory transfer handle for uploading or downloading data to/from a buffer.
         //Memory transfer handles are single-use and threadsafe.
@@ -0,0 +1,104 @@
+#pragma once
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "commands.hpp"
+#include "common.hpp"
+#include "descriptors.hpp"
+#include "render_context.hpp"
+#include "starlib/general/status.hpp"
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    ///A single pass in a render graph. Passes must declare every object they read from or write to, which the graph uses to
+    ///order dependencies between passes, cull passes that do no useful work and alias transient textures.
+    struct render_graph_pass
+    {
+        ///Name of the pass, used for error reporting. Must be unique within the graph.
+        std::string name;
+
+        ///Objects (buffers, textures or framebuffers) the pass reads from.
+        std::vector<object_identifier> reads;
+
+        ///Objects (buffers, textures or framebuffers) the pass writes to.
+        std::vector<object_identifier> writes;
+
+        ///Commands that make up the pass.
+        command_list commands;
+
+        ///Passes with side effects (for instance, drawing to the window or setting a signal) are never culled.
+        ///Passes that write to any non-transient object are also never culled, since the graph can't know if the object is used elsewhere.
+        bool has_side_effects = false;
+    };
+
+    ///Information about the result of compiling a render graph.
+    struct render_graph_compile_info
+    {
+        starlib::u32 passes_compiled = 0;
+        starlib::u32 passes_culled = 0;
+
+        ///Number of transient textures used by the compiled passes.
+        starlib::u32 transient_textures = 0;
+
+        ///Number of textures actually allocated to back the transient textures after aliasing.
+        starlib::u32 transient_storage_textures = 0;
+
+        starlib::u32 memory_barriers = 0;
+    };
+
+    ///Builds a list of passes into a single command list, handling dependencies between them.
+    ///Transient textures (and framebuffers over them) are owned by the graph and created in the render context when compiling.
+    ///Transient textures that are never used at the same time may share the same storage via texture views, so their contents are undefined before their first write.
+    class render_graph
+    {
+    public:
+        explicit render_graph(const std::string_view& name) : graph_name(name) {}
+
+        ///Declare a texture that only needs to exist during the graph.
+        [[nodiscard]] starlib::status add_transient_texture(const std::string_view& name, const texture_format& format, const texture_sampling_conifg& sampling_config = texture_sampling_configs::none);
+
+        ///Declare a framebuffer that only needs to exist during the graph. It may only attach transient textures.
+        ///Passes that read or write the framebuffer are treated as reading or writing all of its attachments.
+        [[nodiscard]] starlib::status add_transient_framebuffer(const framebuffer& descriptor);
+
+        ///Add a pass to the end of the graph. Passes are always executed in the order they are added.
+        [[nodiscard]] starlib::status add_pass(const render_graph_pass& pass);
+
+        ///Compile the graph into a single command list, creating the transient objects it needs in the render context.
+        ///Any objects created by a previous compile of this graph are deleted first, so previously compiled command lists must not be executed afterward.
+        [[nodiscard]] starlib::status compile(render_context* context, command_list& out_commands, render_graph_compile_info* out_info = nullptr);
+
+        ///Delete any objects the graph created in the render context.
+        [[nodiscard]] starlib::status release(render_context* context);
+
+        ///Remove all passes and transient declarations. Does not delete any created objects, see release().
+        void clear();
+
+    private:
+        struct transient_texture
+        {
+            std::string name;
+            texture_format format;
+            texture_sampling_conifg sampling_config;
+        };
+
+        struct created_object
+        {
+            descriptor_type type;
+            std::string name;
+        };
+
+        [[nodiscard]] std::vector<starlib::u64> expand_objects(const std::vector<object_identifier>& objects) const;
+        [[nodiscard]] bool is_transient(starlib::u64 object_hash) const;
+
+        std::string graph_name;
+        std::vector<render_graph_pass> passes;
+        std::vector<transient_texture> transient_textures;
+        std::vector<framebuffer> transient_framebuffers;
+        std::unordered_map<starlib::u64, starlib::u32> transient_texture_indices;
+        std::unordered_map<starlib::u64, starlib::u32> transient_framebuffer_indices;
+        std::vector<created_object> created_objects;
+    };
+}
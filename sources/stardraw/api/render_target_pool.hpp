@@ -0,0 +1,81 @@
+#pragma once
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "common.hpp"
+#include "descriptors.hpp"
+#include "render_context.hpp"
+#include "starlib/general/status.hpp"
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    ///A render target handed out by a render target pool: a texture, and a framebuffer with the texture as its only attachment.
+    struct pooled_render_target
+    {
+        object_identifier texture;
+        object_identifier framebuffer;
+    };
+
+    ///Memory and reuse counters for a render target pool.
+    struct render_target_pool_statistics
+    {
+        ///Number of targets currently allocated, whether in use or not.
+        starlib::u32 allocated_targets = 0;
+        ///Number of targets acquired since the last end_frame.
+        starlib::u32 acquired_targets = 0;
+        ///Approximate texture memory currently allocated by the pool, in bytes.
+        starlib::u64 allocated_bytes = 0;
+        ///Highest allocated_bytes has been since the pool was created or the mark was last reset.
+        starlib::u64 high_water_bytes = 0;
+
+        starlib::u64 targets_created = 0;
+        starlib::u64 targets_reused = 0;
+        starlib::u64 targets_trimmed = 0;
+    };
+
+    ///Hands out textures (and framebuffers over them) for transient render targets such as post-processing intermediates, reusing targets with the same format.
+    ///Targets acquired during a frame go back to the pool at end_frame, so changing resolution or quality only allocates targets the pool doesn't already have.
+    ///Unused targets are deleted least recently used first, once they've gone unused for too many frames or the pool's unused memory is over budget.
+    ///Target contents are undefined when acquired.
+    class render_target_pool
+    {
+    public:
+        explicit render_target_pool(const std::string_view& name, const starlib::u32 max_unused_frames = 4, const starlib::u64 max_unused_bytes = std::numeric_limits<starlib::u64>::max()) : pool_name(name), max_unused_frames(max_unused_frames), max_unused_bytes(max_unused_bytes) {}
+
+        ///Get a target with exactly the given format, creating it in the render context if no unused target matches. The target is in use until end_frame.
+        [[nodiscard]] starlib::status acquire(render_context* context, const texture_format& format, pooled_render_target& out_target);
+
+        ///Return every target acquired this frame to the pool, and delete unused targets that are past the frame or memory limits.
+        [[nodiscard]] starlib::status end_frame(render_context* context);
+
+        ///Delete every target the pool has created in the render context.
+        [[nodiscard]] starlib::status release(render_context* context);
+
+        [[nodiscard]] render_target_pool_statistics statistics() const;
+        void reset_high_water_mark();
+
+    private:
+        struct pooled_target
+        {
+            texture_format format;
+            pooled_render_target target;
+            starlib::u64 bytes;
+            starlib::u64 last_used_frame;
+            bool in_use;
+        };
+
+        [[nodiscard]] starlib::status create_target(render_context* context, const texture_format& format, pooled_target& out_target);
+        [[nodiscard]] starlib::status trim(render_context* context);
+        [[nodiscard]] starlib::status delete_target(render_context* context, starlib::u32 target_idx);
+
+        std::string pool_name;
+        starlib::u32 max_unused_frames;
+        starlib::u64 max_unused_bytes;
+        std::vector<pooled_target> targets;
+        starlib::u64 frame = 0;
+        starlib::u64 next_target_id = 0;
+        render_target_pool_statistics stats;
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "shaders.hpp"
+#include "starlib/general/status.hpp"
+
+namespace stardraw
+{
+    ///A named program to store in a shader archive - all the stages needed to create a shader, created for the same API.
+    struct shader_archive_program
+    {
+        std::string name;
+        std::vector<shader_stage> stages;
+    };
+
+    ///Write programs into a single shader archive file. Each stage is stored as SPIR-V with its reflection index and buffer layouts.
+    ///GL45 programs also store transpiled GLSL and binding-patched SPIR-V, so loading them never needs Slang or SPIR-V reflection.
+    [[nodiscard]] starlib::status write_shader_archive(const std::filesystem::path& path, const std::vector<shader_archive_program>& programs);
+
+    ///Precompiled shader programs, memory mapped from a file written by write_shader_archive (for instance, by the stardraw-shader-archiver tool).
+    ///Shader stages from an archive point directly into the mapping, so the archive must outlive them and any parameter locations found in them.
+    ///Programs are only parsed the first time they're requested. Archives are thread safe.
+    class shader_archive
+    {
+    public:
+        [[nodiscard]] static starlib::status open(const std::filesystem::path& path, shader_archive*& out_archive);
+
+        ///Get the stages of a program, in the order they were written.
+        [[nodiscard]] starlib::status get_program(const std::string_view& name, std::vector<shader_stage>& out_stages) const;
+
+        [[nodiscard]] std::vector<std::string_view> program_names() const;
+
+        ~shader_archive();
+
+    private:
+        struct shader_archive_internal;
+        std::unique_ptr<shader_archive_internal> internal;
+
+        shader_archive();
+    };
+}
@@ -1,8 +1,12 @@
 #pragma once
+#include <bit>
+#include <filesystem>
 #include <memory>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "buffer_layout.hpp"
 #include "memory_transfer.hpp"
 #include "starlib/general/graphics.hpp"
 #include "starlib/general/stdint.hpp"
@@ -35,7 +39,12 @@ namespace stardraw
         ~shader_program();
     };
 
+    ///Flattened table of every parameter location reachable in a shader, built once when a shader stage is created.
+    struct shader_reflection_index;
+
     ///Opaque type that represents a 'shader parameter location' - a memory location in a shader (usually a field/index into a field) that data can be written to.
+    ///Locations are small handles into the shader's reflection index, so they're cheap to copy and navigating them never allocates.
+    ///They remain valid for as long as the shader compiler context (or shader archive) that created the shader stage.
     struct shader_parameter_location
     {
         ///Navigate to an index within the located array-like field or buffer
@@ -43,17 +52,53 @@ namespace stardraw
         ///Navigate to a named field within the located structure
         [[nodiscard]] shader_parameter_location field(const std::string_view& name) const;
 
-        shader_parameter_location(const shader_parameter_location& other);
-        shader_parameter_location& operator=(const shader_parameter_location& other);
-        shader_parameter_location(shader_parameter_location&& other) noexcept;
-        shader_parameter_location& operator=(shader_parameter_location&& other) noexcept;
-
-        bool operator==(const shader_parameter_location& other) const;
-        struct shader_parameter_location_internal;
-        std::unique_ptr<shader_parameter_location_internal> internal;
+        ///False if the location doesn't exist in the shader
+        [[nodiscard]] bool is_valid() const;
+        ///Path to the location in the shader, for error reporting.
+        ///For invalid locations, this is the path of the last valid location navigated through, or '???' if there wasn't one.
+        [[nodiscard]] std::string_view path() const;
+
+        bool operator==(const shader_parameter_location& other) const = default;
+
+        const shader_reflection_index* reflection = nullptr;
+        ///Entry in the reflection index. For invalid locations, the last valid entry navigated through, or u32 max if there wasn't one.
+        starlib::u32 entry = 0;
+        ///Combined index into any arrays navigated through.
+        starlib::u32 array_index = 0;
+        ///Byte offset added by navigating into array elements other than the first.
+        starlib::u64 element_offset = 0;
+        bool valid = false;
+    };
 
-        explicit shader_parameter_location(std::unique_ptr<shader_parameter_location_internal>&& internal);
-        ~shader_parameter_location();
+    ///Value for a SPIR-V specialization constant, identified by its constant id (for instance '[vk::constant_id(3)] const int light_count = 4;' in Slang)
+    ///Specialization constants are fixed when a shader is created, so backends can generate code specialized for their values without recompiling any Slang.
+    struct shader_specialization_constant
+    {
+        static shader_specialization_constant boolean(const starlib::u32 id, const bool value)
+        {
+            return {id, value ? 1u : 0u};
+        }
+
+        static shader_specialization_constant integer(const starlib::u32 id, const starlib::i32 value)
+        {
+            return {id, std::bit_cast<starlib::u32>(value)};
+        }
+
+        static shader_specialization_constant uinteger(const starlib::u32 id, const starlib::u32 value)
+        {
+            return {id, value};
+        }
+
+        static shader_specialization_constant floating(const starlib::u32 id, const starlib::f32 value)
+        {
+            return {id, std::bit_cast<starlib::u32>(value)};
+        }
+
+        bool operator==(const shader_specialization_constant&) const = default;
+
+        starlib::u32 id;
+        ///Raw 32 bits of the constant value
+        starlib::u32 value_bits;
     };
 
     ///Opaque type that represents a 'shader stage' - a single shader entry point for a specific type of stage, with associated data.
@@ -65,11 +110,18 @@ namespace stardraw
         ///Number of bytes required to store all variables of a shader buffer. -1 indicates an unknown or unsized buffer.
         [[nodiscard]] starlib::i64 buffer_size(const std::string_view& name) const;
 
+        ///Check a compile-time buffer layout matches the layout the shader uses for the buffer - field offsets, sizes and array strides.
+        [[nodiscard]] starlib::status validate_buffer_layout(const shader_buffer_layout& layout) const;
+
         ///Get the type of shader stage
         [[nodiscard]] shader_stage_type get_stage_type() const;
 
+        ///Get a copy of this stage with specialization constant values set. Values replace any previously set for the same constant id.
+        [[nodiscard]] shader_stage specialize(const std::vector<shader_specialization_constant>& constants) const;
+
         struct shader_stage_internal;
         std::shared_ptr<shader_stage_internal> internal;
+        std::vector<shader_specialization_constant> specialization_constants;
         ~shader_stage();
     };
 
@@ -88,17 +140,30 @@ namespace stardraw
         bool operator==(const shader_entry_point& key) const = default;
     };
 
+    ///Validate compile-time buffer layouts against every stage that uses their buffer. Fails if no stage uses a buffer.
+    ///Only reads the reflection captured when the stages were created, so it never calls into Slang and is safe to use from any thread.
+    [[nodiscard]] starlib::status validate_shader_buffer_layouts(const std::vector<shader_stage>& stages, const std::vector<shader_buffer_layout>& layouts);
+
+    ///Release the process-wide Slang global session. Contexts that are still alive keep their own reference to it.
+    [[nodiscard]] starlib::status cleanup_shader_compiler();
+
     class shader_compiler_context
     {
     public:
 
-        ///Initialize a slang shader compiler session. Sessions and shader data are not thread safe, but it is safe to create multiple sessions and use
-        ///data generated by one session in a different session. (for instance, loading modules on separate threads and linking them on the main thread)
-        [[nodiscard]] static starlib::status create(shader_compiler_context*& out_context, const std::vector<shader_macro>& macro_defines = {});
+        ///Initialize a slang shader compiler context. All contexts share one process-wide Slang global session, so creating more is cheap.
+        ///Contexts can be used from any thread, but Slang itself isn't thread safe, so calls that compile, link, reflect or serialize are serialized process-wide.
+        ///Modules loaded on one thread can be linked on another. Shader stages only use Slang while being created, so using them afterwards never waits on the compiler.
+        ///If a cache directory is given, compiled modules and shader stage data are cached there, keyed by their inputs, the macro defines and the Slang version.
+        ///Unchanged shaders are then loaded from disk without invoking the Slang frontend or SPIR-V generation. Multiple contexts may share a directory.
+        [[nodiscard]] static starlib::status create(shader_compiler_context*& out_context, const std::vector<shader_macro>& macro_defines = {}, const std::filesystem::path& cache_directory = {});
 
-        ///Load a shader module from Slang source code.
+        ///Load a shader module from Slang source code. Uses the cache directory (if any) when the same source has been compiled before.
         [[nodiscard]] starlib::status load_shader_module(const std::string_view& source, shader_module& out_shader_module) const;
 
+        ///Load a shader module from Slang source code, with macros defined in addition to the ones the context was created with.
+        [[nodiscard]] starlib::status load_shader_module(const std::string_view& source, const std::vector<shader_macro>& additional_macro_defines, shader_module& out_shader_module) const;
+
         ///Load a shader module from cache data previously generated.
         [[nodiscard]] starlib::status load_shader_module(const void* cache_ptr, const starlib::u64 cache_size, shader_module& out_shader_module) const;
 
@@ -114,7 +179,8 @@ namespace stardraw
         ///Determines memory layout for a buffer given the API-specific rules on buffer layouts.
         ///Only 32 bit integer types, 32 bit floating point types, and composite types made of those are guarenteed to be supported.
         ///Support for other types is dependent on the api, and attempting to use types an API does not support is undefined behaviour.
-        [[nodiscard]] starlib::status determine_shader_buffer_layout(const shader_stage& program, const std::string_view& buffer_name, memory_layout_info& out_buffer_layout) const;
+        ///Layouts are read from the stage's reflection index, so this also works for stages loaded from a shader archive.
+        [[nodiscard]] static starlib::status determine_shader_buffer_layout(const shader_stage& program, const std::string_view& buffer_name, memory_layout_info& out_buffer_layout);
 
         ~shader_compiler_context();
 
@@ -124,4 +190,49 @@ namespace stardraw
 
         shader_compiler_context();
     };
+
+    ///A permutation axis of a shader variant library: a keyword macro and the values it may be defined as. The first value is the default.
+    struct shader_variant_axis
+    {
+        std::string keyword;
+        std::vector<std::string> values;
+    };
+
+    ///Selects a variant of a shader variant library by giving values to some of its axes. Axes that aren't given use their default value.
+    typedef std::vector<shader_macro> shader_variant_key;
+
+    ///A family of shader variants compiled from the same Slang source with different combinations of keyword macros defined.
+    ///Variants are compiled the first time they're requested, deduplicated by their fully resolved macro set, and kept in memory
+    ///(and on disk, if the compiler context has a cache directory). Libraries are not thread safe, unlike the compiler context.
+    class shader_variant_library
+    {
+    public:
+        ///Create a library. The compiler context must outlive the library.
+        [[nodiscard]] static starlib::status create(shader_variant_library*& out_library, shader_compiler_context* compiler, const std::string_view& source, const std::vector<shader_variant_axis>& axes, const std::vector<std::string>& entry_points);
+
+        ///Get the shader stages for a variant, compiling it if it hasn't been requested before.
+        [[nodiscard]] starlib::status get_variant(const shader_variant_key& key, const starlib::graphics_api& api, std::vector<shader_stage>& out_stages);
+
+        ///Resolve a variant key into the full set of macros it defines, including default values for axes the key doesn't give.
+        [[nodiscard]] starlib::status resolve_variant(const shader_variant_key& key, std::vector<shader_macro>& out_macro_defines) const;
+
+        ///Number of distinct variants compiled so far.
+        [[nodiscard]] starlib::u64 compiled_variant_count() const;
+
+    private:
+        struct compiled_variant
+        {
+            shader_module module;
+            shader_program program;
+            std::vector<std::pair<starlib::graphics_api, std::vector<shader_stage>>> api_stages;
+        };
+
+        shader_compiler_context* compiler = nullptr;
+        std::string source;
+        std::vector<shader_variant_axis> axes;
+        std::vector<std::string> entry_points;
+        std::unordered_map<std::string, compiled_variant> variants;
+
+        shader_variant_library() = default;
+    };
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+#include "common.hpp"
+#include "descriptors.hpp"
+#include "render_context.hpp"
+#include "texture_streaming.hpp"
+#include "starlib/general/status.hpp"
+
+namespace stardraw
+{
+    ///A KTX2 or DDS texture file, memory mapped so texture data is copied straight from the file's pages into transfer memory, without a heap copy in between.
+    ///Mipmap chains, array textures, cubemaps and block-compressed data are supported. Supercompressed KTX2 files, and data types that
+    ///texture memory transfers can't upload unconverted (16-bit, integer and depth / stencil types), are not.
+    class texture_file
+    {
+    public:
+        [[nodiscard]] static starlib::status open(const std::filesystem::path& path, texture_file*& out_file);
+
+        ///The format a texture needs to hold the file's data.
+        [[nodiscard]] const texture_format& format() const;
+
+        ///A texture descriptor matching the file's format.
+        [[nodiscard]] texture texture_descriptor(const std::string_view& name, const texture_sampling_conifg& sampling_config, bool streamed = false) const;
+
+        ///Upload every mipmap level and layer in the file to a texture created from texture_descriptor(), via a transfer buffer.
+        [[nodiscard]] starlib::status upload(render_context* context, const object_identifier& texture, const object_identifier& transfer_buffer) const;
+
+        ///Describe the file's mipmap levels for a texture_streamer, pointing into the mapping (so the file must outlive the streaming).
+        ///DDS files store each layer's mipmap chain separately, so array and cubemap DDS files can't be streamed and return UNSUPPORTED.
+        [[nodiscard]] starlib::status stream_source(const object_identifier& texture, const object_identifier& transfer_buffer, texture_stream_source& out_source) const;
+
+        ~texture_file();
+
+    private:
+        struct texture_file_internal;
+        std::unique_ptr<texture_file_internal> internal;
+
+        texture_file();
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+
+#include "common.hpp"
+#include "descriptors.hpp"
+#include "memory_transfer.hpp"
+#include "render_context.hpp"
+#include "starlib/general/status.hpp"
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    ///Data for every mipmap level of a texture to stream.
+    struct texture_stream_source
+    {
+        ///A texture created with streamed set, so it only samples from levels that have arrived.
+        object_identifier texture;
+        object_identifier transfer_buffer;
+
+        ///Must match the format the texture was created with.
+        texture_format format;
+
+        ///Data for each mipmap level, level 0 first. Each entry holds the whole level for every layer, tightly packed as for a texture memory transfer.
+        ///The data must stay valid (for instance, mapped from a file) until the texture finishes streaming or is cancelled.
+        std::vector<const void*> mipmap_levels;
+
+        texture_memory_transfer_info::pixel_data_type data_type = texture_memory_transfer_info::pixel_data_type::U8;
+        texture_memory_transfer_info::pixel_channels channels = texture_memory_transfer_info::pixel_channels::RGBA;
+    };
+
+    ///Uploads the mipmap levels of streamed textures over several frames, smallest levels first, within a per-frame byte budget.
+    ///Each texture becomes visible at low resolution as soon as its smallest levels arrive, and gets sharper as larger levels follow.
+    class texture_streamer
+    {
+    public:
+        explicit texture_streamer(const starlib::u64 bytes_per_frame) : bytes_per_frame(bytes_per_frame) {}
+
+        ///Queue every mipmap level of a texture for streaming, replacing anything already queued for the same texture.
+        [[nodiscard]] starlib::status stream(const texture_stream_source& source);
+
+        ///Stop streaming a texture. Levels that have already been uploaded stay resident.
+        void cancel(const object_identifier& texture);
+
+        ///Upload queued levels, smallest first across all textures, until the next level would exceed the budget. Call once per frame.
+        ///At least one level is uploaded per update, so levels larger than the budget still arrive.
+        [[nodiscard]] starlib::status update(render_context* context);
+
+        ///Bytes of mipmap data still waiting to be uploaded.
+        [[nodiscard]] starlib::u64 queued_bytes() const;
+        [[nodiscard]] bool is_idle() const;
+
+        starlib::u64 bytes_per_frame;
+
+    private:
+        struct queued_texture
+        {
+            texture_stream_source source;
+            ///Levels are uploaded from the last (smallest) level down to level 0.
+            starlib::u32 next_level;
+        };
+
+        [[nodiscard]] static starlib::status upload_level(render_context* context, const queued_texture& queued);
+
+        std::vector<queued_texture> queue;
+    };
+}
@@ -84,11 +84,66 @@ namespace stardraw::gl45
             case texture_data_type::RG_F32: return GL_RG32F;
             case texture_data_type::RGB_F32: return GL_RGB32F;
             case texture_data_type::RGBA_F32: return GL_RGBA32F;
+            case texture_data_type::BC1_RGB: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case texture_data_type::BC1_SRGB: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+            case texture_data_type::BC1_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case texture_data_type::BC1_SRGBA: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+            case texture_data_type::BC2_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            case texture_data_type::BC2_SRGBA: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+            case texture_data_type::BC3_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case texture_data_type::BC3_SRGBA: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+            case texture_data_type::BC4_R: return GL_COMPRESSED_RED_RGTC1;
+            case texture_data_type::BC4_R_SIGNED: return GL_COMPRESSED_SIGNED_RED_RGTC1;
+            case texture_data_type::BC5_RG: return GL_COMPRESSED_RG_RGTC2;
+            case texture_data_type::BC5_RG_SIGNED: return GL_COMPRESSED_SIGNED_RG_RGTC2;
+            case texture_data_type::BC6H_RGB_F16: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+            case texture_data_type::BC6H_RGB_UF16: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+            case texture_data_type::BC7_RGBA: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case texture_data_type::BC7_SRGBA: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+            case texture_data_type::ETC2_RGB: return GL_COMPRESSED_RGB8_ETC2;
+            case texture_data_type::ETC2_SRGB: return GL_COMPRESSED_SRGB8_ETC2;
+            case texture_data_type::ETC2_RGB_A1: return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+            case texture_data_type::ETC2_SRGB_A1: return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+            case texture_data_type::ETC2_RGBA: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+            case texture_data_type::ETC2_SRGBA: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+            case texture_data_type::EAC_R: return GL_COMPRESSED_R11_EAC;
+            case texture_data_type::EAC_R_SIGNED: return GL_COMPRESSED_SIGNED_R11_EAC;
+            case texture_data_type::EAC_RG: return GL_COMPRESSED_RG11_EAC;
+            case texture_data_type::EAC_RG_SIGNED: return GL_COMPRESSED_SIGNED_RG11_EAC;
+            case texture_data_type::ASTC_4X4_RGBA: return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+            case texture_data_type::ASTC_4X4_SRGBA: return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+            case texture_data_type::ASTC_6X6_RGBA: return GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+            case texture_data_type::ASTC_6X6_SRGBA: return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR;
+            case texture_data_type::ASTC_8X8_RGBA: return GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+            case texture_data_type::ASTC_8X8_SRGBA: return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR;
         }
 
         return 0;
     }
 
+    ///Whether the driver can create textures with a data type. Uncompressed types, RGTC, BPTC and ETC2 / EAC are core, other compressed types are extensions.
+    inline bool is_texture_data_type_supported(const texture_data_type type)
+    {
+        switch (type)
+        {
+            case texture_data_type::BC1_RGB:
+            case texture_data_type::BC1_RGBA:
+            case texture_data_type::BC2_RGBA:
+            case texture_data_type::BC3_RGBA: return GLAD_GL_EXT_texture_compression_s3tc;
+            case texture_data_type::BC1_SRGB:
+            case texture_data_type::BC1_SRGBA:
+            case texture_data_type::BC2_SRGBA:
+            case texture_data_type::BC3_SRGBA: return GLAD_GL_EXT_texture_compression_s3tc && GLAD_GL_EXT_texture_sRGB;
+            case texture_data_type::ASTC_4X4_RGBA:
+            case texture_data_type::ASTC_4X4_SRGBA:
+            case texture_data_type::ASTC_6X6_RGBA:
+            case texture_data_type::ASTC_6X6_SRGBA:
+            case texture_data_type::ASTC_8X8_RGBA:
+            case texture_data_type::ASTC_8X8_SRGBA: return GLAD_GL_KHR_texture_compression_astc_ldr;
+            default: return true;
+        }
+    }
+
     inline bool is_integer_texture_data_type_signed(const texture_data_type type)
     {
         switch (type)
@@ -156,93 +211,9 @@ namespace stardraw::gl45
         }
     }
 
-    inline u32 bytes_per_texture_data_element(const texture_data_type type)
-    {
-        switch (type)
-        {
-            case texture_data_type::R_U8:
-            case texture_data_type::R_I8:
-            case texture_data_type::STENCIL_U8:
-            case texture_data_type::R_U8_NORM: return 1;
-            case texture_data_type::RG_U8:
-            case texture_data_type::RG_U8_NORM:
-            case texture_data_type::R_U16:
-            case texture_data_type::RG_I8:
-            case texture_data_type::R_I16:
-            case texture_data_type::DEPTH_U16_NORM:
-            case texture_data_type::R_F16: return 2;
-            case texture_data_type::RGB_U8:
-            case texture_data_type::RGB_I8:
-            case texture_data_type::DEPTH_U24_NORM:
-            case texture_data_type::RGB_U8_NORM:
-            case texture_data_type::SRGB_U8_NORM: return 3;
-            case texture_data_type::RGBA_U8_NORM:
-            case texture_data_type::SRGBA_U8_NORM:
-            case texture_data_type::RG_F16:
-            case texture_data_type::R_F32:
-            case texture_data_type::RGBA_I8:
-            case texture_data_type::RGBA_U8:
-            case texture_data_type::RG_U16:
-            case texture_data_type::R_U32:
-            case texture_data_type::RG_I16:
-            case texture_data_type::R_I32:
-            case texture_data_type::DEPTH_U32_NORM:
-            case texture_data_type::DEPTH_F32:
-            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8: return 4;
-            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8: return 5;
-            case texture_data_type::RGB_F16:
-            case texture_data_type::RGB_U16:
-            case texture_data_type::RGB_I16: return 6;
-            case texture_data_type::RG_U32:
-            case texture_data_type::RGBA_U16:
-            case texture_data_type::RGBA_I16:
-            case texture_data_type::RGBA_F16:
-            case texture_data_type::RG_F32:
-            case texture_data_type::RG_I32: return 8;
-            case texture_data_type::RGB_U32:
-            case texture_data_type::RGB_F32:
-            case texture_data_type::RGB_I32: return 12;
-            case texture_data_type::RGBA_U32:
-            case texture_data_type::RGBA_F32:
-            case texture_data_type::RGBA_I32: return 16;
-            default: return -1;
-        }
-    }
-
-    inline bool does_texture_data_type_have_depth(const texture_data_type& texture_data_type)
-    {
-        switch (texture_data_type)
-        {
-            case texture_data_type::DEPTH_F32:
-            case texture_data_type::DEPTH_U32_NORM:
-            case texture_data_type::DEPTH_U24_NORM:
-            case texture_data_type::DEPTH_U16_NORM:
-            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8:
-            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8:
-            {
-                return true;
-            }
-            default: return false;
-        }
-    }
-
-    inline bool does_texture_data_type_have_stencil(const texture_data_type& texture_data_type)
-    {
-        switch (texture_data_type)
-        {
-            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8:
-            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8:
-            case texture_data_type::STENCIL_U8:
-            {
-                return true;
-            }
-            default: return false;
-        }
-    }
-
     inline bool is_texture_data_type_color_renderable(const texture_data_type& texture_data_type)
     {
-        return !does_texture_data_type_have_depth(texture_data_type) && !does_texture_data_type_have_stencil(texture_data_type);
+        return !does_texture_data_type_have_depth(texture_data_type) && !does_texture_data_type_have_stencil(texture_data_type) && !is_texture_data_type_compressed(texture_data_type);
     }
 
     inline bool is_texture_data_type_depth_renderable(const texture_data_type& texture_data_type)
@@ -640,4 +611,29 @@ namespace stardraw::gl45
         return -1;
     }
 
+    inline GLenum to_gl_query_target(const query_type type)
+    {
+        switch (type)
+        {
+            case query_type::TIME_ELAPSED: return GL_TIME_ELAPSED;
+            case query_type::SAMPLES_PASSED: return GL_SAMPLES_PASSED;
+            case query_type::PRIMITIVES_GENERATED: return GL_PRIMITIVES_GENERATED;
+        }
+
+        return -1;
+    }
+
+    inline GLenum to_gl_conditional_render_mode(const conditional_render_mode mode, const bool inverted)
+    {
+        switch (mode)
+        {
+            case conditional_render_mode::WAIT: return inverted ? GL_QUERY_WAIT_INVERTED : GL_QUERY_WAIT;
+            case conditional_render_mode::NO_WAIT: return inverted ? GL_QUERY_NO_WAIT_INVERTED : GL_QUERY_NO_WAIT;
+            case conditional_render_mode::BY_REGION_WAIT: return inverted ? GL_QUERY_BY_REGION_WAIT_INVERTED : GL_QUERY_BY_REGION_WAIT;
+            case conditional_render_mode::BY_REGION_NO_WAIT: return inverted ? GL_QUERY_BY_REGION_NO_WAIT_INVERTED : GL_QUERY_BY_REGION_NO_WAIT;
+        }
+
+        return -1;
+    }
+
 }
@@ -0,0 +1,291 @@
+#include "background_loader.hpp"
+
+#include <format>
+
+#include "object_states/buffer_state.hpp"
+#include "object_states/texture_sampler_state.hpp"
+#include "object_states/texture_state.hpp"
+
+namespace stardraw::gl45
+{
+    background_loader::background_loader(const render_context_config& config, const program_binary_cache& cache, shader_builder build_shader) : make_context_current(config.gl_loader_context_make_current), release_context(config.gl_loader_context_release), cache(cache), build_shader(std::move(build_shader))
+    {
+        ZoneScoped;
+        thread = std::jthread([this](const std::stop_token& stop_token) { run(stop_token); });
+    }
+
+    background_loader::~background_loader()
+    {
+        ZoneScoped;
+        thread.request_stop();
+        if (thread.joinable()) thread.join();
+
+        //Loads that were never published still own their objects.
+        for (const finished_load& load : finished_loads)
+        {
+            if (load.fence != nullptr)
+            {
+                ZoneScopedN("GL calls");
+                glDeleteSync(load.fence);
+            }
+
+            for (const auto& [identifier, state] : load.states)
+            {
+                delete state;
+            }
+        }
+    }
+
+    status background_loader::queue(const std::string& name, background_load&& load)
+    {
+        ZoneScoped;
+        {
+            std::lock_guard lock(mutex);
+            if (context_status.is_error()) return context_status;
+            queued_loads.push_back({name, std::move(load)});
+        }
+        wake.notify_one();
+        return status_type::SUCCESS;
+    }
+
+    void background_loader::collect(const std::function<void(finished_load& load)>& on_finished)
+    {
+        ZoneScoped;
+        std::vector<finished_load> ready;
+        {
+            std::lock_guard lock(mutex);
+
+            //Loads are published in the order they were queued, so later loads can rely on objects from earlier ones.
+            u32 ready_count = 0;
+            for (finished_load& load : finished_loads)
+            {
+                if (load.fence != nullptr)
+                {
+                    ZoneScopedN("GL calls");
+                    if (glClientWaitSync(load.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+                    glDeleteSync(load.fence);
+                    load.fence = nullptr;
+                }
+                ready_count++;
+            }
+
+            ready.reserve(ready_count);
+            for (u32 load_idx = 0; load_idx < ready_count; load_idx++)
+            {
+                ready.push_back(std::move(finished_loads[load_idx]));
+            }
+            finished_loads.erase(finished_loads.begin(), finished_loads.begin() + ready_count);
+        }
+
+        for (finished_load& load : ready)
+        {
+            on_finished(load);
+        }
+    }
+
+    void background_loader::run(const std::stop_token& stop_token)
+    {
+        ZoneScoped;
+        if (!make_context_current())
+        {
+            std::lock_guard lock(mutex);
+            context_status = {status_type::BACKEND_ERROR, "Making the GL loader context current on the loader thread failed"};
+
+            //Fail anything queued before the error was known, so it doesn't stay pending forever.
+            for (const queued_load& queued : queued_loads)
+            {
+                finished_loads.push_back({queued.name, context_status});
+            }
+            queued_loads.clear();
+            return;
+        }
+
+        while (true)
+        {
+            queued_load queued;
+            {
+                std::unique_lock lock(mutex);
+                if (!wake.wait(lock, stop_token, [this] { return !queued_loads.empty(); })) break;
+                queued = std::move(queued_loads.front());
+                queued_loads.pop_front();
+            }
+
+            finished_load finished;
+            finished.name = queued.name;
+            process(queued, finished);
+
+            std::lock_guard lock(mutex);
+            finished_loads.push_back(std::move(finished));
+        }
+
+        if (release_context) release_context();
+    }
+
+    void background_loader::process(queued_load& queued, finished_load& out_finished) const
+    {
+        ZoneScoped;
+        out_finished.result = create_states(queued.load.descriptors, out_finished);
+        if (!out_finished.result.is_error()) out_finished.result = upload_data(queued.load, out_finished);
+
+        if (out_finished.result.is_error())
+        {
+            for (const auto& [identifier, state] : out_finished.states)
+            {
+                delete state;
+            }
+            out_finished.states.clear();
+            out_finished.deferred_descriptors.clear();
+            return;
+        }
+
+        //The render thread only sees the fence once the flush has submitted it, along with everything before it.
+        {
+            ZoneScopedN("GL calls");
+            out_finished.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+    }
+
+    status background_loader::create_states(const descriptor_list& descriptors, finished_load& out_finished) const
+    {
+        ZoneScoped;
+        std::vector<shader_state*> shaders;
+        for (const starlib::polymorphic<descriptor>& descriptor : descriptors)
+        {
+            const descriptor_type type = descriptor.ptr()->type();
+            const object_identifier identifier = descriptor.ptr()->identifier();
+
+            status create_status = status_type::SUCCESS;
+            object_state* state = nullptr;
+            switch (type)
+            {
+                case descriptor_type::BUFFER:
+                {
+                    state = new buffer_state(*dynamic_cast<const buffer*>(descriptor.ptr()), create_status);
+                    break;
+                }
+                case descriptor_type::TEXTURE:
+                {
+                    const texture* texture_descriptor = dynamic_cast<const texture*>(descriptor.ptr());
+                    if (texture_descriptor->as_view_of.has_value())
+                    {
+                        const texture_state* original = dynamic_cast<texture_state*>(find_state(out_finished, descriptor_type::TEXTURE, texture_descriptor->as_view_of.value()));
+                        if (original == nullptr) return {status_type::UNKNOWN, std::format("Texture view '{0}' in background load '{1}' must view a texture from the same load", identifier.name, out_finished.name)};
+                        state = new texture_state(original, *texture_descriptor, create_status);
+                    }
+                    else
+                    {
+                        state = new texture_state(*texture_descriptor, create_status);
+                    }
+                    break;
+                }
+                case descriptor_type::SAMPLER:
+                {
+                    state = new texture_sampler_state(*dynamic_cast<const sampler*>(descriptor.ptr()), create_status);
+                    break;
+                }
+                case descriptor_type::SHADER:
+                {
+                    shader_state* built_shader = nullptr;
+                    create_status = build_shader(dynamic_cast<const shader*>(descriptor.ptr()), built_shader);
+                    if (!create_status.is_error()) shaders.push_back(built_shader);
+                    state = built_shader;
+                    break;
+                }
+                default:
+                {
+                    //Container objects (VAOs, framebuffers) only exist in the context that created them.
+                    out_finished.deferred_descriptors.push_back(descriptor);
+                    continue;
+                }
+            }
+
+            if (create_status.is_error())
+            {
+                delete state;
+                return create_status;
+            }
+
+            if (find_state(out_finished, type, identifier) != nullptr)
+            {
+                delete state;
+                return {status_type::DUPLICATE, std::format("Background load '{0}' creates more than one object named '{1}'", out_finished.name, identifier.name)};
+            }
+
+            out_finished.states.emplace_back(identifier, state);
+        }
+
+        //Nothing else is waiting on this thread, so shaders are compiled to completion here rather than on first use.
+        for (shader_state* shader : shaders)
+        {
+            if (shader->needs_transpile()) (void)shader->transpile_pending_stages();
+            shader->begin_compile();
+        }
+
+        for (shader_state* shader : shaders)
+        {
+            (void)shader->poll_compile(cache, true);
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status background_loader::upload_data(const background_load& load, const finished_load& finished)
+    {
+        ZoneScoped;
+        for (const background_buffer_data& buffer_data : load.buffer_data)
+        {
+            const buffer_state* buffer = dynamic_cast<buffer_state*>(find_state(finished, descriptor_type::BUFFER, buffer_data.buffer));
+            if (buffer == nullptr) return {status_type::UNKNOWN, std::format("Buffer '{0}' isn't created by background load '{1}'", buffer_data.buffer.name, finished.name)};
+            if (buffer_data.data.empty()) continue;
+            if (!buffer->is_in_buffer_range(buffer_data.address, buffer_data.data.size())) return {status_type::RANGE_OVERFLOW, std::format("Background load data is out of range in buffer '{0}'", buffer_data.buffer.name)};
+
+            //GPU-only buffers have immutable storage, so the data goes through a temporary buffer initialised with it.
+            GLuint staging_buffer_id = 0;
+            {
+                ZoneScopedN("GL calls");
+                glCreateBuffers(1, &staging_buffer_id);
+                glNamedBufferStorage(staging_buffer_id, buffer_data.data.size(), buffer_data.data.data(), 0);
+            }
+
+            const status copy_status = buffer->copy_data(staging_buffer_id, 0, buffer_data.address, buffer_data.data.size());
+
+            {
+                ZoneScopedN("GL calls");
+                glDeleteBuffers(1, &staging_buffer_id);
+            }
+            if (copy_status.is_error()) return copy_status;
+        }
+
+        for (const background_texture_data& texture_data : load.texture_data)
+        {
+            const texture_memory_transfer_info& region = texture_data.region;
+            const texture_state* texture = dynamic_cast<texture_state*>(find_state(finished, descriptor_type::TEXTURE, region.target));
+            if (texture == nullptr) return {status_type::UNKNOWN, std::format("Texture '{0}' isn't created by background load '{1}'", region.target.name, finished.name)};
+            if (texture->streamed) return {status_type::INVALID, std::format("Texture '{0}' is streamed, so its data must be uploaded with a texture streamer rather than a background load", region.target.name)};
+
+            const status validate_status = texture->validate_upload(region);
+            if (validate_status.is_error()) return validate_status;
+
+            if (texture_data.data.size() < texture->compute_bytes_in_transfer(region))
+            {
+                return {status_type::RANGE_OVERFLOW, std::format("Background load data for texture '{0}' is smaller than the region it uploads", region.target.name)};
+            }
+
+            //The loader is allowed to block, so the driver copies straight from the load's memory.
+            const status unpack_status = texture->unpack_region(region, 0, reinterpret_cast<u64>(texture_data.data.data()));
+            if (unpack_status.is_error()) return unpack_status;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    object_state* background_loader::find_state(const finished_load& finished, const descriptor_type type, const object_identifier& identifier)
+    {
+        for (const auto& [state_identifier, state] : finished.states)
+        {
+            if (state->object_type() == type && state_identifier == identifier) return state;
+        }
+        return nullptr;
+    }
+}
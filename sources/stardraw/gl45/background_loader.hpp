@@ -0,0 +1,74 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "program_binary_cache.hpp"
+#include "object_states/shader_state.hpp"
+#include "stardraw/api/render_context.hpp"
+
+namespace stardraw::gl45
+{
+    ///A background load the loader thread has finished with. Its objects aren't in the render context until the fence signals.
+    struct finished_load
+    {
+        std::string name;
+        status result = status_type::SUCCESS;
+        ///Signalled once the GPU has finished the load's uploads. 0 if the load failed before issuing anything.
+        GLsync fence = nullptr;
+        std::vector<std::pair<object_identifier, object_state*>> states;
+        ///Descriptors for objects GL can't share between contexts, created on the render thread when the load is published.
+        descriptor_list deferred_descriptors;
+    };
+
+    ///Runs background loads on a second, shared GL context owned by a loader thread.
+    ///Loads are handed over to the render thread through collect, which never waits - a load is only returned once its fence has signalled.
+    class background_loader
+    {
+    public:
+        ///Builds a shader state the same way the render context does (validating buffer layouts). Called on the loader thread, so variants must already be resolved.
+        ///Builders must not call into Slang directly: anything that does has to go through a shader compiler context, which serializes Slang use with the render thread.
+        typedef std::function<status(const shader* descriptor, shader_state*& out_state)> shader_builder;
+
+        background_loader(const render_context_config& config, const program_binary_cache& cache, shader_builder build_shader);
+        background_loader(const background_loader&) = delete;
+        background_loader& operator=(const background_loader&) = delete;
+        ~background_loader();
+
+        [[nodiscard]] status queue(const std::string& name, background_load&& load);
+
+        ///Pass every load whose GPU work has finished (or that failed) to on_finished, in the order they were queued.
+        ///on_finished takes ownership of the load's object states. Must be called from the render thread.
+        void collect(const std::function<void(finished_load& load)>& on_finished);
+
+    private:
+        struct queued_load
+        {
+            std::string name;
+            background_load load;
+        };
+
+        void run(const std::stop_token& stop_token);
+        void process(queued_load& queued, finished_load& out_finished) const;
+        [[nodiscard]] status create_states(const descriptor_list& descriptors, finished_load& out_finished) const;
+        [[nodiscard]] static status upload_data(const background_load& load, const finished_load& finished);
+        [[nodiscard]] static object_state* find_state(const finished_load& finished, descriptor_type type, const object_identifier& identifier);
+
+        std::function<bool()> make_context_current;
+        std::function<void()> release_context;
+        const program_binary_cache& cache;
+        shader_builder build_shader;
+
+        std::mutex mutex;
+        std::condition_variable_any wake;
+        std::deque<queued_load> queued_loads;
+        std::vector<finished_load> finished_loads;
+        status context_status = status_type::SUCCESS;
+        std::jthread thread;
+    };
+}
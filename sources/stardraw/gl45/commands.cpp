@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <format>
 
 #include "api_conversion.hpp"
@@ -23,6 +24,12 @@ namespace stardraw::gl45
         }
     }
 
+    u64 render_context::active_framebuffer_hash() const
+    {
+        if (active_draw_specification == nullptr || !active_draw_specification->framebuffer.has_value()) return 0;
+        return active_draw_specification->framebuffer.value().hash;
+    }
+
     status render_context::execute_draw(const draw* cmd)
     {
         ZoneScoped;
@@ -32,20 +39,22 @@ namespace stardraw::gl45
         const status v_find_status = find_vertex_specification_state(active_draw_specification->vertex_specification, &vertex_spec);
         if (v_find_status.is_error()) return v_find_status;
 
-        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.barrier_if_needed(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.require_barrier(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
 
         shader_state* shader;
         status find_status = find_shader_state(active_draw_specification->shader, &shader);
         if (find_status.is_error()) return find_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        const u64 framebuffer_hash = active_framebuffer_hash();
+        shader->require_barriers(mem_barrier_controller, true, framebuffer_hash);
+        mem_barrier_controller.flush_barriers();
 
         {
             ZoneScopedN("GL calls");
             glDrawArraysInstancedBaseInstance(to_gl_draw_mode(cmd->mode), cmd->start_vertex, cmd->count, cmd->instances, cmd->start_instance);
         }
 
-        shader->flag_barriers(mem_barrier_controller);
+        shader->flag_writes(mem_barrier_controller, true, framebuffer_hash);
         return status_type::SUCCESS;
     }
 
@@ -63,21 +72,23 @@ namespace stardraw::gl45
         const status v_find_status = find_vertex_specification_state(active_draw_specification->vertex_specification, &vertex_spec);
         if (v_find_status.is_error()) return v_find_status;
 
-        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.barrier_if_needed(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(vertex_spec->index_buffer.identifier, GL_ELEMENT_ARRAY_BARRIER_BIT);
+        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.require_barrier(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(vertex_spec->index_buffer.identifier, GL_ELEMENT_ARRAY_BARRIER_BIT);
 
         shader_state* shader;
         status find_status = find_shader_state(active_draw_specification->shader, &shader);
         if (find_status.is_error()) return find_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        const u64 framebuffer_hash = active_framebuffer_hash();
+        shader->require_barriers(mem_barrier_controller, true, framebuffer_hash);
+        mem_barrier_controller.flush_barriers();
 
         {
             ZoneScopedN("GL calls");
             glDrawElementsInstancedBaseVertexBaseInstance(to_gl_draw_mode(cmd->mode), cmd->count, index_element_type, reinterpret_cast<const void*>(cmd->start_index * index_element_size), cmd->instances, cmd->vertex_index_offset, cmd->start_instance);
         }
 
-        shader->flag_barriers(mem_barrier_controller);
+        shader->flag_writes(mem_barrier_controller, true, framebuffer_hash);
         return status_type::SUCCESS;
     }
 
@@ -91,24 +102,39 @@ namespace stardraw::gl45
         const status v_find_status = find_vertex_specification_state(active_draw_specification->vertex_specification, &vertex_spec);
         if (v_find_status.is_error()) return v_find_status;
 
-        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.barrier_if_needed(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(cmd->indirect_buffer, GL_COMMAND_BARRIER_BIT);
+        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.require_barrier(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->indirect_buffer, GL_COMMAND_BARRIER_BIT);
 
         status bind_status = bind_buffer(cmd->indirect_buffer, GL_DRAW_INDIRECT_BUFFER);
         if (bind_status.is_error()) return bind_status;
 
+        buffer_state* count_state = nullptr;
+        const status count_status = find_indirect_count_buffer(cmd->count_buffer, cmd->count_address, &count_state);
+        if (count_status.is_error()) return count_status;
+
         shader_state* shader;
         status find_status = find_shader_state(active_draw_specification->shader, &shader);
         if (find_status.is_error()) return find_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        const u64 framebuffer_hash = active_framebuffer_hash();
+        shader->require_barriers(mem_barrier_controller, true, framebuffer_hash);
+        mem_barrier_controller.flush_barriers();
 
+        const void* indirect_offset = reinterpret_cast<const void*>(cmd->indirect_index * sizeof(draw_arrays_indirect_params));
+        if (count_state != nullptr && indirect_count_draws)
         {
             ZoneScopedN("GL calls");
-            glMultiDrawArraysIndirect(to_gl_draw_mode(cmd->mode), reinterpret_cast<const void*>(cmd->indirect_index * sizeof(draw_arrays_indirect_params)), cmd->draw_count, 0);
+            if (GLAD_GL_VERSION_4_6) glMultiDrawArraysIndirectCount(to_gl_draw_mode(cmd->mode), indirect_offset, cmd->count_address, cmd->draw_count, 0);
+            else glMultiDrawArraysIndirectCountARB(to_gl_draw_mode(cmd->mode), indirect_offset, cmd->count_address, cmd->draw_count, 0);
+        }
+        else
+        {
+            const GLsizei draw_count = count_state != nullptr ? read_indirect_draw_count(count_state, cmd->count_address, cmd->draw_count) : cmd->draw_count;
+            ZoneScopedN("GL calls");
+            glMultiDrawArraysIndirect(to_gl_draw_mode(cmd->mode), indirect_offset, draw_count, 0);
         }
 
-        shader->flag_barriers(mem_barrier_controller);
+        shader->flag_writes(mem_barrier_controller, true, framebuffer_hash);
         return status_type::SUCCESS;
     }
 
@@ -125,27 +151,77 @@ namespace stardraw::gl45
         const status v_find_status = find_vertex_specification_state(active_draw_specification->vertex_specification, &vertex_spec);
         if (v_find_status.is_error()) return v_find_status;
 
-        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.barrier_if_needed(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(vertex_spec->index_buffer.identifier, GL_ELEMENT_ARRAY_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(cmd->indirect_buffer, GL_COMMAND_BARRIER_BIT);
+        for (const vertex_specification_state::vertex_buffer_binding& binding : vertex_spec->vertex_buffers) mem_barrier_controller.require_barrier(binding.identifier, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(vertex_spec->index_buffer.identifier, GL_ELEMENT_ARRAY_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->indirect_buffer, GL_COMMAND_BARRIER_BIT);
 
         status bind_status = bind_buffer(cmd->indirect_buffer, GL_DRAW_INDIRECT_BUFFER);
         if (bind_status.is_error()) return bind_status;
 
+        buffer_state* count_state = nullptr;
+        const status count_status = find_indirect_count_buffer(cmd->count_buffer, cmd->count_address, &count_state);
+        if (count_status.is_error()) return count_status;
+
         shader_state* shader;
         status find_status = find_shader_state(active_draw_specification->shader, &shader);
         if (find_status.is_error()) return find_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        const u64 framebuffer_hash = active_framebuffer_hash();
+        shader->require_barriers(mem_barrier_controller, true, framebuffer_hash);
+        mem_barrier_controller.flush_barriers();
+
+        const void* indirect_offset = reinterpret_cast<const void*>(cmd->indirect_index * sizeof(draw_elements_indirect_params));
+        if (count_state != nullptr && indirect_count_draws)
+        {
+            ZoneScopedN("GL calls");
+            if (GLAD_GL_VERSION_4_6) glMultiDrawElementsIndirectCount(to_gl_draw_mode(cmd->mode), index_element_type, indirect_offset, cmd->count_address, cmd->draw_count, 0);
+            else glMultiDrawElementsIndirectCountARB(to_gl_draw_mode(cmd->mode), index_element_type, indirect_offset, cmd->count_address, cmd->draw_count, 0);
+        }
+        else
         {
+            const GLsizei draw_count = count_state != nullptr ? read_indirect_draw_count(count_state, cmd->count_address, cmd->draw_count) : cmd->draw_count;
             ZoneScopedN("GL calls");
-            glMultiDrawElementsIndirect(to_gl_draw_mode(cmd->mode), index_element_type, reinterpret_cast<const void*>(cmd->indirect_index * sizeof(draw_elements_indirect_params)), cmd->draw_count, 0);
+            glMultiDrawElementsIndirect(to_gl_draw_mode(cmd->mode), index_element_type, indirect_offset, draw_count, 0);
         }
-        shader->flag_barriers(mem_barrier_controller);
 
+        shader->flag_writes(mem_barrier_controller, true, framebuffer_hash);
         return status_type::SUCCESS;
     }
 
+    status render_context::find_indirect_count_buffer(const std::optional<object_identifier>& count_buffer, const u64 count_address, buffer_state** out_state)
+    {
+        ZoneScoped;
+        if (!count_buffer.has_value()) return status_type::SUCCESS;
+
+        const status find_status = find_buffer_state(count_buffer.value(), out_state);
+        if (find_status.is_error()) return find_status;
+
+        if (count_address % sizeof(u32) != 0) return {status_type::INVALID, std::format("Draw count address {0} in buffer '{1}' must be a multiple of 4", count_address, count_buffer->name)};
+        if (!(*out_state)->is_in_buffer_range(count_address, sizeof(u32))) return {status_type::RANGE_OVERFLOW, std::format("Draw count address {0} is out of range in buffer '{1}'", count_address, count_buffer->name)};
+
+        if (indirect_count_draws)
+        {
+            mem_barrier_controller.require_barrier(count_buffer.value(), GL_COMMAND_BARRIER_BIT);
+            return (*out_state)->bind_to(GL_PARAMETER_BUFFER);
+        }
+
+        //Without indirect count draws, the count is read back on the CPU instead.
+        mem_barrier_controller.require_barrier(count_buffer.value(), GL_BUFFER_UPDATE_BARRIER_BIT);
+        return status_type::SUCCESS;
+    }
+
+    GLsizei render_context::read_indirect_draw_count(const buffer_state* count_state, const u64 count_address, const u32 max_draw_count) const
+    {
+        ZoneScoped;
+        //Stalls until the GPU has written the count - only used when the driver has neither GL 4.6 nor ARB_indirect_parameters.
+        u32 draw_count = 0;
+        {
+            ZoneScopedN("GL calls");
+            glGetNamedBufferSubData(count_state->gl_id(), static_cast<GLintptr>(count_address), sizeof(u32), &draw_count);
+        }
+        return static_cast<GLsizei>(std::min(draw_count, max_draw_count));
+    }
+
     status render_context::execute_buffer_copy(const buffer_copy* cmd)
     {
         ZoneScoped;
@@ -161,8 +237,9 @@ namespace stardraw::gl45
         if (!source_state->is_in_buffer_range(cmd->source_address, cmd->bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->read_buffer.name)};
         if (!dest_state->is_in_buffer_range(cmd->dest_address, cmd->bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->write_buffer.name)};
 
-        mem_barrier_controller.barrier_if_needed(cmd->read_buffer, GL_BUFFER_UPDATE_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(cmd->write_buffer, GL_BUFFER_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->read_buffer, GL_BUFFER_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->write_buffer, GL_BUFFER_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.flush_barriers();
 
         return dest_state->copy_data(source_state->gl_id(), cmd->source_address, cmd->dest_address, cmd->bytes);
     }
@@ -179,8 +256,9 @@ namespace stardraw::gl45
         const status find_dest_status = find_texture_state(cmd->write_texture, &dest_state);
         if (find_dest_status.is_error()) return find_source_status;
 
-        mem_barrier_controller.barrier_if_needed(cmd->read_texture, GL_TEXTURE_UPDATE_BARRIER_BIT);
-        mem_barrier_controller.barrier_if_needed(cmd->write_texture, GL_TEXTURE_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->read_texture, GL_TEXTURE_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->write_texture, GL_TEXTURE_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.flush_barriers();
 
         return dest_state->copy_pixels(source_state, cmd->copy_info);
     }
@@ -198,20 +276,59 @@ namespace stardraw::gl45
             status dest_find_status = find_framebuffer_state(cmd->write_framebuffer.value(), &dest_state);
             if (dest_find_status.is_error()) return dest_find_status;
 
-            mem_barrier_controller.barrier_if_needed(cmd->read_framebuffer, GL_FRAMEBUFFER_BARRIER_BIT);
-            mem_barrier_controller.barrier_if_needed(cmd->write_framebuffer.value(), GL_FRAMEBUFFER_BARRIER_BIT);
+            mem_barrier_controller.require_barrier(cmd->read_framebuffer, GL_FRAMEBUFFER_BARRIER_BIT);
+            mem_barrier_controller.require_barrier(cmd->write_framebuffer.value(), GL_FRAMEBUFFER_BARRIER_BIT);
+            mem_barrier_controller.flush_barriers();
 
             return source_state->blit_to(dest_state, cmd->copy_info);
         }
 
-        mem_barrier_controller.barrier_if_needed(cmd->read_framebuffer, GL_FRAMEBUFFER_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(cmd->read_framebuffer, GL_FRAMEBUFFER_BARRIER_BIT);
+        mem_barrier_controller.flush_barriers();
         return source_state->blit_to_default(cmd->copy_info);
     }
 
     status render_context::execute_config_draw(const configure_draw* cmd)
     {
         ZoneScoped;
-        return bind_draw_specification_state(cmd->draw_specification);
+        draw_specification_state* state;
+        const status find_status = find_draw_specification_state(cmd->draw_specification, &state);
+        if (find_status.is_error()) return find_status;
+
+        if (cmd->pass_actions.has_value() && !state->framebuffer.has_value()) return {status_type::INVALID, std::format("Pass actions were given, but draw specification '{0}' doesn't render to a framebuffer", state->id.name)};
+
+        if (active_pass.has_value() && (cmd->pass_actions.has_value() || state->framebuffer != active_pass->framebuffer))
+        {
+            const status end_status = end_framebuffer_pass();
+            if (end_status.is_error()) return end_status;
+        }
+
+        const status bind_status = bind_draw_specification_state(cmd->draw_specification);
+        if (bind_status.is_error()) return bind_status;
+
+        if (!cmd->pass_actions.has_value()) return status_type::SUCCESS;
+
+        framebuffer_state* framebuffer;
+        const status framebuffer_find = find_framebuffer_state(state->framebuffer.value(), &framebuffer);
+        if (framebuffer_find.is_error()) return framebuffer_find;
+
+        active_pass = {state->framebuffer.value(), cmd->pass_actions.value()};
+        return framebuffer->begin_pass(cmd->pass_actions.value());
+    }
+
+    status render_context::end_framebuffer_pass()
+    {
+        ZoneScoped;
+        if (!active_pass.has_value()) return status_type::SUCCESS;
+
+        const framebuffer_pass pass = active_pass.value();
+        active_pass.reset();
+
+        //The framebuffer may have been deleted during the pass, in which case there's nothing left to store.
+        framebuffer_state* framebuffer = find_object_state<framebuffer_state, descriptor_type::FRAMEBUFFER>(pass.framebuffer);
+        if (framebuffer == nullptr) return status_type::SUCCESS;
+
+        return framebuffer->end_pass(pass.actions);
     }
 
     status render_context::execute_config_blending(const configure_blending* cmd)
@@ -381,6 +498,22 @@ namespace stardraw::gl45
         return texture->clear(cmd->mipmap_level, cmd->clear_vlaues);
     }
 
+    status render_context::execute_generate_mipmaps(const generate_mipmaps* cmd)
+    {
+        ZoneScoped;
+
+        texture_state* texture;
+        status find_status = find_texture_state(cmd->texture, &texture);
+        if (find_status.is_error()) return find_status;
+
+        //The driver path reads the base level like a texture update, the compute path through image loads.
+        const GLbitfield read_barriers = cmd->filter == mipmap_filter::DEFAULT ? GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT : GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+        mem_barrier_controller.require_barrier(cmd->texture, read_barriers);
+        mem_barrier_controller.flush_barriers();
+
+        return mipmaps.generate(texture, *cmd, mem_barrier_controller);
+    }
+
     status render_context::execute_compute_dispatch(const dispatch_compute* cmd)
     {
         ZoneScoped;
@@ -392,9 +525,10 @@ namespace stardraw::gl45
         status bind_status = bind_shader(cmd->shader);
         if (bind_status.is_error()) return bind_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        shader->require_barriers(mem_barrier_controller, false, 0);
+        mem_barrier_controller.flush_barriers();
         status result_status = shader->dispatch_compute(cmd->groups_x, cmd->groups_y, cmd->groups_z);
-        shader->flag_barriers(mem_barrier_controller);
+        shader->flag_writes(mem_barrier_controller, false, 0);
 
         return result_status;
     }
@@ -417,21 +551,28 @@ namespace stardraw::gl45
         status bind_status = bind_shader(cmd->shader);
         if (bind_status.is_error()) return bind_status;
 
-        shader->barrier_objects_if_needed(mem_barrier_controller);
+        shader->require_barriers(mem_barrier_controller, false, 0);
+        mem_barrier_controller.flush_barriers();
         status result_status = shader->dispatch_compute_indirect(cmd->indirect_index * sizeof(dispatch_compute_indirect_params));
-        shader->flag_barriers(mem_barrier_controller);
+        shader->flag_writes(mem_barrier_controller, false, 0);
 
         return result_status;
     }
 
-    status render_context::execute_present(const present* cmd) const
+    status render_context::execute_present(const present* cmd)
     {
         //Under OpenGL, there is no specific presentation calls, and presentation is handled entirely by the window refresh.
         //However, we still need to collect performance data and mark the frame boundary.
         ZoneScoped;
         TracyGpuCollect;
+        collect_query_results();
+        update_texture_streaming();
+        publish_background_loads();
+        signals.poll();
+
+        const status pacing_status = frames.end_frame();
         FrameMark;
-        return status_type::SUCCESS;
+        return pacing_status;
     }
 
     status render_context::execute_shader_parameters_upload(const configure_shader* cmd)
@@ -456,15 +597,132 @@ namespace stardraw::gl45
     status render_context::execute_signal(const signal* cmd)
     {
         ZoneScoped;
+        return signals.signal(cmd->value);
+    }
+
+    status render_context::execute_memory_barrier(const memory_barrier* cmd)
+    {
+        ZoneScoped;
+        for (const object_identifier& object : cmd->objects)
+        {
+            mem_barrier_controller.require_barrier(object, GL_ALL_BARRIER_BITS);
+        }
+
+        mem_barrier_controller.flush_barriers();
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_begin_query(const begin_query* cmd)
+    {
+        ZoneScoped;
+        if (active_queries.contains(cmd->query_name)) return {status_type::DUPLICATE, std::format("Query '{0}' has already begun", cmd->query_name)};
+
+        const GLenum target = to_gl_query_target(cmd->query_kind);
+        for (const auto& [name, query] : active_queries)
+        {
+            if (query.target == target) return {status_type::INVALID, std::format("Can't begin query '{0}' while query '{1}' of the same type is active", cmd->query_name, name)};
+        }
+
+        //GL only allows one occlusion query target to be active at once.
+        if (target == GL_SAMPLES_PASSED && active_occlusion_query.has_value()) return {status_type::INVALID, std::format("Can't begin query '{0}' while occlusion query '{1}' is active", cmd->query_name, active_occlusion_query->name)};
+
+        const active_query query = {target, queries.acquire(target)};
         {
             ZoneScopedN("GL calls");
-            if (signals.contains(cmd->signal_name))
-            {
-                glDeleteSync(signals[cmd->signal_name].sync_point);
-            }
+            glBeginQuery(query.target, query.query_id);
+        }
 
-            signals[cmd->signal_name] = {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)};
+        active_queries[cmd->query_name] = query;
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_end_query(const end_query* cmd)
+    {
+        ZoneScoped;
+        if (!active_queries.contains(cmd->query_name)) return {status_type::INVALID, std::format("Query '{0}' has not begun", cmd->query_name)};
+
+        const active_query query = active_queries[cmd->query_name];
+        active_queries.erase(cmd->query_name);
+        {
+            ZoneScopedN("GL calls");
+            glEndQuery(query.target);
         }
+
+        queries.submit({cmd->query_name, pending_query_usage::QUERY_RESULT, query.target, query.query_id});
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_begin_occlusion_query(const begin_occlusion_query* cmd)
+    {
+        ZoneScoped;
+        if (active_occlusion_query.has_value()) return {status_type::INVALID, std::format("Can't begin occlusion query '{0}' while occlusion query '{1}' is active", cmd->query_name, active_occlusion_query->name)};
+        for (const auto& [name, query] : active_queries)
+        {
+            if (query.target == GL_SAMPLES_PASSED) return {status_type::INVALID, std::format("Can't begin occlusion query '{0}' while samples passed query '{1}' is active", cmd->query_name, name)};
+        }
+
+        const GLenum target = cmd->conservative ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+        //Each name keeps its query object, so conditional rendering can use the latest result. It's only replaced if the query type changes.
+        const auto existing = occlusion_queries.find(cmd->query_name);
+        if (existing != occlusion_queries.end() && existing->second.target != target)
+        {
+            queries.release(existing->second.target, existing->second.query_id);
+            occlusion_queries.erase(existing);
+        }
+
+        if (!occlusion_queries.contains(cmd->query_name)) occlusion_queries[cmd->query_name] = {target, queries.acquire(target)};
+
+        {
+            ZoneScopedN("GL calls");
+            glBeginQuery(target, occlusion_queries[cmd->query_name].query_id);
+        }
+
+        active_occlusion_query = object_identifier(cmd->query_name);
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_end_occlusion_query(const end_occlusion_query* cmd)
+    {
+        ZoneScoped;
+        if (!active_occlusion_query.has_value() || active_occlusion_query->name != cmd->query_name) return {status_type::INVALID, std::format("Occlusion query '{0}' has not begun", cmd->query_name)};
+
+        {
+            ZoneScopedN("GL calls");
+            glEndQuery(occlusion_queries[cmd->query_name].target);
+        }
+
+        active_occlusion_query.reset();
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_begin_conditional_render(const begin_conditional_render* cmd)
+    {
+        ZoneScoped;
+        if (conditional_render_active) return {status_type::INVALID, std::format("Can't begin conditional rendering on '{0}' while conditional rendering is already active", cmd->query_name)};
+        if (!occlusion_queries.contains(cmd->query_name)) return {status_type::UNKNOWN, std::format("No occlusion query named '{0}' has been recorded", cmd->query_name)};
+        if (active_occlusion_query.has_value() && active_occlusion_query->name == cmd->query_name) return {status_type::INVALID, std::format("Can't begin conditional rendering on occlusion query '{0}' before it has ended", cmd->query_name)};
+
+        {
+            ZoneScopedN("GL calls");
+            glBeginConditionalRender(occlusion_queries[cmd->query_name].query_id, to_gl_conditional_render_mode(cmd->mode, cmd->inverted));
+        }
+
+        conditional_render_active = true;
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_end_conditional_render(const end_conditional_render* cmd)
+    {
+        ZoneScoped;
+        if (!conditional_render_active) return {status_type::INVALID, "Conditional rendering is not active"};
+
+        {
+            ZoneScopedN("GL calls");
+            glEndConditionalRender();
+        }
+
+        conditional_render_active = false;
         return status_type::SUCCESS;
     }
 }
@@ -42,11 +42,6 @@ namespace stardraw::gl45
         [[nodiscard]] virtual descriptor_type object_type() const = 0;
     };
 
-    struct signal_state
-    {
-        GLsync sync_point;
-    };
-
     class gl_memory_transfer_handle final : public memory_transfer_handle
     {
     public:
@@ -59,6 +54,14 @@ namespace stardraw::gl45
             current_status = memory_transfer_status::COMPLETE;
             return status_type::SUCCESS;
         }
+        status transfer_direct(void*& out_destination) override
+        {
+            ZoneScoped;
+            if (current_status != memory_transfer_status::READY) return {status_type::INVALID, "Transfer has already been called on this handle!"};
+            out_destination = transfer_buffer_ptr;
+            current_status = memory_transfer_status::COMPLETE;
+            return status_type::SUCCESS;
+        }
         memory_transfer_status transfer_status() override
         {
             return current_status;
@@ -0,0 +1,101 @@
+#include "fence_timeline.hpp"
+
+#include <format>
+
+namespace stardraw::gl45
+{
+    fence_timeline::~fence_timeline()
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            for (const pending_fence& fence : pending_fences)
+            {
+                glDeleteSync(fence.sync_point);
+            }
+        }
+    }
+
+    status fence_timeline::signal(u64 value)
+    {
+        ZoneScoped;
+        if (value == 0) value = signalled + 1;
+        if (value <= signalled) return {status_type::INVALID, std::format("Signal values must increase, but {0} was signalled after {1}", value, signalled)};
+
+        GLsync sync_point;
+        {
+            ZoneScopedN("GL calls");
+            sync_point = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        if (sync_point == nullptr) return {status_type::BACKEND_ERROR, std::format("Creating a fence for signal value {0} failed", value)};
+
+        pending_fences.push_back({value, sync_point});
+        signalled = value;
+        return status_type::SUCCESS;
+    }
+
+    void fence_timeline::poll()
+    {
+        ZoneScoped;
+        while (!pending_fences.empty())
+        {
+            GLenum wait_result;
+            {
+                ZoneScopedN("GL calls");
+                wait_result = glClientWaitSync(pending_fences.front().sync_point, 0, 0);
+            }
+            if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED) break;
+            retire_front();
+        }
+    }
+
+    signal_status fence_timeline::wait(const u64 value, const u64 timeout_nanos)
+    {
+        ZoneScoped;
+        if (value > signalled) return signal_status::UNKNOWN_SIGNAL;
+
+        poll();
+        if (completed_value() >= value) return signal_status::SIGNALLED;
+
+        //The first fence at or after the value covers it, as every value up to it was signalled before that fence.
+        GLsync sync_point = nullptr;
+        for (const pending_fence& fence : pending_fences)
+        {
+            if (fence.value < value) continue;
+            sync_point = fence.sync_point;
+            break;
+        }
+        if (timeout_nanos == 0 || sync_point == nullptr) return signal_status::NOT_SIGNALLED;
+
+        GLenum wait_result;
+        {
+            ZoneScopedN("GL calls");
+            //Flush, or the fence might never reach the GPU and the wait would always time out.
+            wait_result = glClientWaitSync(sync_point, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_nanos);
+        }
+
+        switch (wait_result)
+        {
+            case GL_ALREADY_SIGNALED:
+            case GL_CONDITION_SATISFIED:
+            {
+                poll();
+                return signal_status::SIGNALLED;
+            }
+            case GL_TIMEOUT_EXPIRED: return signal_status::TIMED_OUT;
+            default: return signal_status::CONTEXT_ERROR;
+        }
+    }
+
+    void fence_timeline::retire_front()
+    {
+        ZoneScoped;
+        const pending_fence& fence = pending_fences.front();
+        {
+            ZoneScopedN("GL calls");
+            glDeleteSync(fence.sync_point);
+        }
+        completed.store(fence.value, std::memory_order_release);
+        pending_fences.pop_front();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <deque>
+
+#include "common.hpp"
+#include "stardraw/api/commands.hpp"
+
+namespace stardraw::gl45
+{
+    ///A monotonically increasing counter that the GPU advances as it finishes work, backed by GL fence syncs.
+    ///Signalling a value places a fence after every command submitted so far, and the completed value is the highest signalled value whose fence has passed.
+    ///Fences finish in submission order, so only the oldest pending fences ever need checking.
+    class fence_timeline
+    {
+    public:
+        fence_timeline() = default;
+        fence_timeline(const fence_timeline&) = delete;
+        fence_timeline& operator=(const fence_timeline&) = delete;
+        ~fence_timeline();
+
+        ///Place a fence for a value, which must be higher than any value signalled before it. A value of 0 signals the next value.
+        [[nodiscard]] status signal(u64 value);
+
+        ///Retire every fence the GPU has passed and advance the completed value. Never waits for the GPU.
+        void poll();
+
+        ///Wait until the completed value is at least the given value. A timeout of 0 only checks it.
+        [[nodiscard]] signal_status wait(u64 value, u64 timeout_nanos);
+
+        ///Safe to call from any thread. Only advances when the render thread polls or waits.
+        [[nodiscard]] u64 completed_value() const
+        {
+            return completed.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] u64 signalled_value() const
+        {
+            return signalled;
+        }
+
+    private:
+        struct pending_fence
+        {
+            u64 value;
+            GLsync sync_point;
+        };
+
+        void retire_front();
+
+        std::deque<pending_fence> pending_fences;
+        std::atomic<u64> completed = 0;
+        u64 signalled = 0;
+    };
+}
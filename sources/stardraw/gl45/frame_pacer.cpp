@@ -0,0 +1,80 @@
+#include "frame_pacer.hpp"
+
+#include <limits>
+
+namespace stardraw::gl45
+{
+    static u64 nanos_between(const std::chrono::steady_clock::time_point from, const std::chrono::steady_clock::time_point to)
+    {
+        return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    frame_pacer::frame_pacer(const u32 frames_in_flight) : frames_in_flight(frames_in_flight) {}
+
+    status frame_pacer::end_frame()
+    {
+        ZoneScoped;
+        const clock::time_point presented = clock::now();
+        frame++;
+
+        const status fence_status = frames.signal(frame);
+        if (fence_status.is_error()) return fence_status;
+
+        frames.poll();
+        record_finished_frames(presented);
+
+        u64 wait_nanos = 0;
+        if (frames_in_flight != 0 && frame > frames_in_flight)
+        {
+            const u64 required_frame = frame - frames_in_flight;
+            if (frames.completed_value() < required_frame)
+            {
+                ZoneScopedN("Waiting for frames in flight");
+                const signal_status wait_status = frames.wait(required_frame, std::numeric_limits<u64>::max());
+                const clock::time_point waited = clock::now();
+                wait_nanos = nanos_between(presented, waited);
+                record_finished_frames(waited);
+
+                if (wait_status != signal_status::SIGNALLED) return {status_type::BACKEND_ERROR, "Waiting for the GPU to finish an earlier frame failed"};
+            }
+        }
+
+        frame_statistics statistics;
+        statistics.frame = frame;
+        statistics.cpu_frame_nanos = frame == 1 ? 0 : nanos_between(last_present, presented);
+        statistics.cpu_wait_nanos = wait_nanos;
+        statistics.frames_in_flight = static_cast<u32>(frame - frames.completed_value());
+        in_flight_frames.push_back({statistics, presented});
+        last_present = presented;
+
+        //An idle GPU may already have finished this frame.
+        record_finished_frames(clock::now());
+        return status_type::SUCCESS;
+    }
+
+    std::vector<frame_statistics> frame_pacer::collect()
+    {
+        ZoneScoped;
+        std::vector<frame_statistics> collected = std::move(finished_frames);
+        finished_frames.clear();
+        return collected;
+    }
+
+    void frame_pacer::record_finished_frames(const clock::time_point observed)
+    {
+        ZoneScoped;
+        const u64 completed_frame = frames.completed_value();
+        while (!in_flight_frames.empty() && in_flight_frames.front().statistics.frame <= completed_frame)
+        {
+            in_flight_frame& finished = in_flight_frames.front();
+            finished.statistics.gpu_lag_nanos = nanos_between(finished.presented, observed);
+            finished_frames.push_back(finished.statistics);
+            in_flight_frames.pop_front();
+        }
+
+        if (finished_frames.size() > max_finished_frames)
+        {
+            finished_frames.erase(finished_frames.begin(), finished_frames.end() - max_finished_frames);
+        }
+    }
+}
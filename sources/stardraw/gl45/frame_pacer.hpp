@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "common.hpp"
+#include "fence_timeline.hpp"
+#include "stardraw/api/render_context.hpp"
+
+namespace stardraw::gl45
+{
+    ///Fences every frame at present, and holds the CPU back when it gets more than the configured number of frames ahead of the GPU.
+    ///Frame statistics are recorded once the CPU sees a frame's fence has passed, which is at a later present or while present is waiting.
+    class frame_pacer
+    {
+    public:
+        explicit frame_pacer(u32 frames_in_flight);
+
+        ///Fence the frame that is being presented, then wait until no more than frames_in_flight frames are unfinished.
+        [[nodiscard]] status end_frame();
+
+        ///Take the statistics of every frame finished since the last call, oldest first.
+        [[nodiscard]] std::vector<frame_statistics> collect();
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        struct in_flight_frame
+        {
+            frame_statistics statistics;
+            clock::time_point presented;
+        };
+
+        void record_finished_frames(clock::time_point observed);
+
+        ///Statistics are dropped (oldest first) past this point if they're never collected.
+        static constexpr u32 max_finished_frames = 256;
+
+        fence_timeline frames;
+        u32 frames_in_flight;
+        u64 frame = 0;
+        clock::time_point last_present;
+        std::deque<in_flight_frame> in_flight_frames;
+        std::vector<frame_statistics> finished_frames;
+    };
+}
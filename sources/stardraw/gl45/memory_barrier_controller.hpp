@@ -1,28 +1,183 @@
 #pragma once
 
+#include <array>
+#include <unordered_map>
+
+#include "stardraw/api/render_context.hpp"
+#include "stardraw/gl45/common.hpp"
 #include "stardraw/gl45/gl_headers.hpp"
 #include "tracy/Tracy.hpp"
 
 namespace stardraw::gl45
 {
+    ///Barrier bits that can be required after an incoherent write to a buffer (SSBO, atomic counter, etc)
+    constexpr GLbitfield BUFFER_WRITE_BARRIER_BITS = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT
+                                                     | GL_COMMAND_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_TRANSFORM_FEEDBACK_BARRIER_BIT
+                                                     | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT | GL_QUERY_BUFFER_BARRIER_BIT;
+
+    ///Barrier bits that can be required after an incoherent write to a texture (image stores)
+    constexpr GLbitfield TEXTURE_WRITE_BARRIER_BITS = GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+
+    ///Barrier bits that glMemoryBarrierByRegion accepts
+    constexpr GLbitfield REGION_BARRIER_BITS = GL_ATOMIC_COUNTER_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT;
+
+    ///Tracks incoherent shader writes to objects and batches the barriers required before reading them.
+    ///Barriers are accumulated with require_barrier and issued as a single glMemoryBarrier (or glMemoryBarrierByRegion) by flush_barriers,
+    ///which should be called once per draw / dispatch / copy, right before the GL call that performs the reads.
+    ///
+    ///glMemoryBarrier is global, so a barrier for a bit makes *every* earlier write visible for that bit, not just writes to the object being checked.
+    ///This is tracked with write 'epochs' - an object only needs a barrier bit if it was written after the last barrier that included that bit.
     class memory_barrier_controller
     {
     public:
-        inline void barrier_if_needed(const object_identifier& object_id, const GLbitfield barrier_bits)
+        ///Information about where a read or write happened, used to determine if a dependency is local to a framebuffer region.
+        struct access_scope
+        {
+            ///True if the access is only made by a fragment shader stage during a draw.
+            bool fragment_only = false;
+            ///Hash of the framebuffer bound for the draw performing the access (0 for the default framebuffer)
+            u64 framebuffer_hash = 0;
+        };
+
+        explicit memory_barrier_controller(const bool allow_region_barriers = false) : allow_region_barriers(allow_region_barriers) {}
+
+        ///Queue the barrier bits needed before reading an object in a specific way. Nothing is issued until flush_barriers is called.
+        inline void require_barrier(const object_identifier& object_id, const GLbitfield read_bits, const access_scope& read_scope = {})
+        {
+            ZoneScoped;
+            //Reads of objects with no write this read depends on never needed a barrier, so they aren't counted as elided.
+            const auto write_ptr = writes.find(object_id.hash);
+            if (write_ptr == writes.end()) return;
+
+            const write_record& write = write_ptr->second;
+            const GLbitfield dependent_bits = write.bits & read_bits;
+            if (dependent_bits == 0) return;
+
+            const GLbitfield needed_bits = dependent_bits & ~bits_made_visible_since(write.epoch, last_barrier_epochs);
+            if (needed_bits == 0)
+            {
+                stats.barriers_elided++;
+                return;
+            }
+
+            const bool is_region_local = allow_region_barriers && write.scope.fragment_only && read_scope.fragment_only && write.scope.framebuffer_hash == read_scope.framebuffer_hash && (needed_bits & ~REGION_BARRIER_BITS) == 0;
+            if (is_region_local)
+            {
+                //Region barriers only cover fragment -> fragment dependencies, so they're tracked separately and never satisfy a full barrier.
+                const GLbitfield region_bits = needed_bits & ~bits_made_visible_since(write.epoch, last_region_barrier_epochs);
+                if (region_bits == 0)
+                {
+                    stats.barriers_elided++;
+                    return;
+                }
+
+                if (pending_region_bits != 0 || pending_bits != 0) stats.barriers_elided++; //Merged into a barrier that's already queued
+                pending_region_bits |= region_bits;
+                return;
+            }
+
+            if (pending_region_bits != 0 || pending_bits != 0) stats.barriers_elided++; //Merged into a barrier that's already queued
+            pending_bits |= needed_bits;
+        }
+
+        ///Issue all barriers queued by require_barrier as a single call.
+        inline void flush_barriers()
         {
             ZoneScoped;
-            if (!blocking.contains(object_id.hash)) return;
-            const GLbitfield blocking_bits = blocking[object_id.hash] & barrier_bits;
-            if (blocking_bits == 0) return;
+            if (pending_bits != 0)
+            {
+                //A full barrier is a superset of a region barrier, so region requirements can be folded into it.
+                const GLbitfield bits = pending_bits | pending_region_bits;
+                {
+                    ZoneScopedN("GL calls");
+                    glMemoryBarrier(bits);
+                }
+                mark_bits_visible(bits, last_barrier_epochs);
+                mark_bits_visible(bits, last_region_barrier_epochs);
+                stats.barriers_issued++;
+            }
+            else if (pending_region_bits != 0)
+            {
+                {
+                    ZoneScopedN("GL calls");
+                    glMemoryBarrierByRegion(pending_region_bits);
+                }
+                mark_bits_visible(pending_region_bits, last_region_barrier_epochs);
+                stats.region_barriers_issued++;
+            }
 
-            blocking[object_id.hash] &= ~blocking_bits;
-            glMemoryBarrier(blocking_bits);
+            pending_bits = 0;
+            pending_region_bits = 0;
         }
-        inline void flag_barriers(const object_identifier& object_id)
+
+        ///Record an incoherent write to an object. write_bits are the barriers that later reads of the object may need (see BUFFER_WRITE_BARRIER_BITS / TEXTURE_WRITE_BARRIER_BITS)
+        inline void flag_write(const object_identifier& object_id, const GLbitfield write_bits, const access_scope& write_scope = {})
         {
-            blocking[object_id.hash] = u32_max; //All bits
+            ZoneScoped;
+            current_epoch++;
+            write_record& record = writes[object_id.hash];
+
+            //If a previous write to the object hasn't been made visible yet, the pending bits need to be kept
+            //and the write can only be treated as region local if both writes were in the same region.
+            const GLbitfield unresolved_bits = record.bits & ~bits_made_visible_since(record.epoch, last_barrier_epochs);
+            const bool same_region = record.scope.fragment_only && write_scope.fragment_only && record.scope.framebuffer_hash == write_scope.framebuffer_hash;
+
+            record.scope = {(unresolved_bits == 0 || same_region) && write_scope.fragment_only, write_scope.framebuffer_hash};
+            record.bits = write_bits | unresolved_bits;
+            record.epoch = current_epoch;
         }
+
+        ///Forget any writes recorded for an object (for instance, when it is deleted)
+        inline void forget(const object_identifier& object_id)
+        {
+            writes.erase(object_id.hash);
+        }
+
+        [[nodiscard]] inline const barrier_statistics& statistics() const
+        {
+            return stats;
+        }
+
+        inline void reset_statistics()
+        {
+            stats = {};
+        }
+
     private:
-        std::unordered_map<u64, GLbitfield> blocking;
+        struct write_record
+        {
+            GLbitfield bits = 0;
+            u64 epoch = 0;
+            access_scope scope;
+        };
+
+        typedef std::array<u64, sizeof(GLbitfield) * 8> barrier_epochs;
+
+        [[nodiscard]] static inline GLbitfield bits_made_visible_since(const u64 epoch, const barrier_epochs& epochs)
+        {
+            GLbitfield visible = 0;
+            for (u32 bit = 0; bit < epochs.size(); bit++)
+            {
+                if (epochs[bit] >= epoch) visible |= (1u << bit);
+            }
+            return visible;
+        }
+
+        inline void mark_bits_visible(const GLbitfield bits, barrier_epochs& epochs) const
+        {
+            for (u32 bit = 0; bit < epochs.size(); bit++)
+            {
+                if (bits & (1u << bit)) epochs[bit] = current_epoch;
+            }
+        }
+
+        std::unordered_map<u64, write_record> writes;
+        barrier_epochs last_barrier_epochs = {};
+        barrier_epochs last_region_barrier_epochs = {};
+        u64 current_epoch = 0;
+        GLbitfield pending_bits = 0;
+        GLbitfield pending_region_bits = 0;
+        bool allow_region_barriers;
+        barrier_statistics stats;
     };
 }
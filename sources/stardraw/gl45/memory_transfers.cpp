@@ -1,5 +1,7 @@
 #include "render_context.hpp"
 
+#include <algorithm>
+
 #include "api_conversion.hpp"
 #include "stardraw/internal/internal.hpp"
 #include "starlib/utility/string.hpp"
@@ -53,7 +55,8 @@ namespace stardraw::gl45
         status find_status = find_buffer_state(info.target, &buffer);
         if (find_status.is_error()) return find_status;
 
-        mem_barrier_controller.barrier_if_needed(info.target, GL_BUFFER_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(info.target, GL_BUFFER_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.flush_barriers();
 
         switch (info.transfer_type)
         {
@@ -94,9 +97,14 @@ namespace stardraw::gl45
         status find_status = find_texture_state(info.target, &texture);
         if (find_status.is_error()) return find_status;
 
-        mem_barrier_controller.barrier_if_needed(info.target, GL_TEXTURE_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.require_barrier(info.target, GL_TEXTURE_UPDATE_BARRIER_BIT);
+        mem_barrier_controller.flush_barriers();
+
+        const status flush_status = texture->flush_upload(info, handle);
+        if (flush_status.is_error()) return flush_status;
 
-        return texture->flush_upload(info, handle);
+        if (texture->streamed && !std::ranges::contains(streaming_textures, info.target)) streaming_textures.push_back(info.target);
+        return status_type::SUCCESS;
     }
 
     status render_context::execute_aquire(const aquire* cmd) const
@@ -0,0 +1,279 @@
+#include "mipmap_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <string>
+
+#include "api_conversion.hpp"
+
+namespace stardraw::gl45
+{
+    ///Downsamples one mipmap level of every layer into the next, one invocation per destination texel.
+    ///Odd sized levels round down, so the last row / column of destination texels also covers the leftover source texels (up to a 3x3 footprint),
+    ///which keeps MIN / MAX conservative - nothing in the source level is skipped.
+    static constexpr const char* DOWNSAMPLE_SHADER_SOURCE = R"(
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(IMAGE_FORMAT, binding = 0) uniform readonly image2DArray source_level;
+layout(IMAGE_FORMAT, binding = 1) uniform writeonly image2DArray dest_level;
+
+vec4 decode(vec4 value)
+{
+#ifdef SRGB
+    const bvec3 is_low = lessThanEqual(value.rgb, vec3(0.04045));
+    value.rgb = mix(pow((value.rgb + 0.055) / 1.055, vec3(2.4)), value.rgb / 12.92, is_low);
+#endif
+    return value;
+}
+
+vec4 encode(vec4 value)
+{
+#ifdef SRGB
+    const bvec3 is_low = lessThanEqual(value.rgb, vec3(0.0031308));
+    value.rgb = mix(1.055 * pow(value.rgb, vec3(1.0 / 2.4)) - 0.055, value.rgb * 12.92, is_low);
+#endif
+    return value;
+}
+
+void main()
+{
+    const ivec3 dest_coord = ivec3(gl_GlobalInvocationID);
+    const ivec2 dest_size = imageSize(dest_level).xy;
+    if (any(greaterThanEqual(dest_coord.xy, dest_size))) return;
+
+    const ivec2 source_size = imageSize(source_level).xy;
+    const ivec2 first = dest_coord.xy * 2;
+    ivec2 last = min(first + 1, source_size - 1);
+    if (dest_coord.x == dest_size.x - 1) last.x = source_size.x - 1;
+    if (dest_coord.y == dest_size.y - 1) last.y = source_size.y - 1;
+
+    vec4 result = decode(imageLoad(source_level, ivec3(first, dest_coord.z)));
+    for (int y = first.y; y <= last.y; y++)
+    {
+        for (int x = first.x; x <= last.x; x++)
+        {
+            if (x == first.x && y == first.y) continue;
+            const vec4 value = decode(imageLoad(source_level, ivec3(x, y, dest_coord.z)));
+#if defined(FILTER_MIN)
+            result = min(result, value);
+#elif defined(FILTER_MAX)
+            result = max(result, value);
+#else
+            result += value;
+#endif
+        }
+    }
+
+#if !defined(FILTER_MIN) && !defined(FILTER_MAX)
+    const ivec2 footprint = last - first + 1;
+    result /= float(footprint.x * footprint.y);
+#endif
+
+    imageStore(dest_level, dest_coord, encode(result));
+}
+)";
+
+    ///GLSL image format qualifier for the formats the compute filters can write, or nullptr if the format can't be used.
+    static const char* downsample_image_format(const GLenum format)
+    {
+        switch (format)
+        {
+            case GL_R8: return "r8";
+            case GL_RG8: return "rg8";
+            case GL_RGBA8: return "rgba8";
+            case GL_R16F: return "r16f";
+            case GL_RG16F: return "rg16f";
+            case GL_RGBA16F: return "rgba16f";
+            case GL_R32F: return "r32f";
+            case GL_RG32F: return "rg32f";
+            case GL_RGBA32F: return "rgba32f";
+            default: return nullptr;
+        }
+    }
+
+    static const char* downsample_filter_define(const mipmap_filter filter)
+    {
+        switch (filter)
+        {
+            case mipmap_filter::MIN: return "#define FILTER_MIN\n";
+            case mipmap_filter::MAX: return "#define FILTER_MAX\n";
+            default: return "";
+        }
+    }
+
+    mipmap_generator::~mipmap_generator()
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            for (const auto& [key, program] : programs)
+            {
+                glDeleteProgram(program);
+            }
+        }
+    }
+
+    status mipmap_generator::generate(const texture_state* texture, const generate_mipmaps& cmd, memory_barrier_controller& barrier_controller)
+    {
+        ZoneScoped;
+        const std::string& name = texture->texture_id.name;
+        if (cmd.base_level + 1 >= texture->num_texture_mipmap_levels)
+        {
+            return {status_type::RANGE_OVERFLOW, std::format("Texture '{0}' has no mipmap levels after base level {1} to generate", name, cmd.base_level)};
+        }
+
+        const u32 remaining_levels = texture->num_texture_mipmap_levels - cmd.base_level - 1;
+        const u32 level_count = cmd.level_count == 0 ? remaining_levels : cmd.level_count;
+        if (level_count > remaining_levels)
+        {
+            return {status_type::RANGE_OVERFLOW, std::format("Generating {0} mipmap levels after level {1} is out of the bounds of texture '{2}'", level_count, cmd.base_level, name)};
+        }
+
+        if (cmd.layer >= texture->num_texture_array_layers)
+        {
+            return {status_type::RANGE_OVERFLOW, std::format("Layer {0} is out of the bounds of texture '{1}'", cmd.layer, name)};
+        }
+
+        const u32 layers = cmd.layers == 0 ? texture->num_texture_array_layers - cmd.layer : cmd.layers;
+        if (cmd.layer + layers > texture->num_texture_array_layers)
+        {
+            return {status_type::RANGE_OVERFLOW, std::format("Generating mipmaps for {0} layers from layer {1} is out of the bounds of texture '{2}'", layers, cmd.layer, name)};
+        }
+
+        if (texture->num_texture_msaa_samples != 0)
+        {
+            return {status_type::INVALID, std::format("Texture '{0}' is multisampled, and can't have mipmaps generated", name)};
+        }
+
+        if (is_texture_data_type_compressed(texture->data_type) || is_texture_data_type_integer(texture->data_type) || !is_texture_data_type_color_renderable(texture->data_type))
+        {
+            return {status_type::INVALID, std::format("Texture '{0}' data type can't have mipmaps generated (it must be an uncompressed, non-integer color type)", name)};
+        }
+
+        const bool use_compute = cmd.filter != mipmap_filter::DEFAULT;
+        const bool is_srgb = texture->data_type == texture_data_type::SRGBA_U8_NORM;
+        if (use_compute && (texture->shape == texture_shape::_1D || texture->shape == texture_shape::_3D))
+        {
+            return {status_type::UNSUPPORTED, std::format("Texture '{0}' is 1D or 3D, which only supports the DEFAULT mipmap filter", name)};
+        }
+
+        //The compute path writes sRGB textures through a linear RGBA8 view, as sRGB formats can't be used for image stores.
+        const GLenum view_format = use_compute && is_srgb ? GL_RGBA8 : texture->gl_texture_format;
+        if (use_compute && downsample_image_format(view_format) == nullptr)
+        {
+            return {status_type::UNSUPPORTED, std::format("Texture '{0}' data type can't be used with compute mipmap filters (it must have R, RG or RGBA channels of 8-bit normalized, F16 or F32 data)", name)};
+        }
+
+        //Generate through a temporary view of just the requested levels and layers, so the texture's own base / max level (and streaming state) are left alone.
+        //Cubemaps are viewed as 2D arrays so a range of faces can be selected.
+        GLenum view_target = GL_TEXTURE_2D_ARRAY;
+        if (texture->shape == texture_shape::_1D) view_target = GL_TEXTURE_1D_ARRAY;
+        else if (texture->shape == texture_shape::_3D) view_target = GL_TEXTURE_3D;
+
+        GLuint view_id = 0;
+        {
+            ZoneScopedN("GL calls");
+            glGenTextures(1, &view_id);
+            glTextureView(view_id, view_target, texture->gl_texture_id, view_format, cmd.base_level, level_count + 1, cmd.layer, layers);
+        }
+
+        status result_status = status_type::SUCCESS;
+        if (use_compute) result_status = generate_with_compute(texture, cmd, view_id, level_count + 1, layers, barrier_controller);
+        else result_status = generate_with_driver(view_id, level_count + 1);
+
+        {
+            ZoneScopedN("GL calls");
+            glDeleteTextures(1, &view_id);
+        }
+
+        return result_status;
+    }
+
+    status mipmap_generator::generate_with_driver(const GLuint view_id, const u32 levels)
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            glTextureParameteri(view_id, GL_TEXTURE_BASE_LEVEL, 0);
+            glTextureParameteri(view_id, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+            glGenerateTextureMipmap(view_id);
+        }
+        return status_type::SUCCESS;
+    }
+
+    status mipmap_generator::generate_with_compute(const texture_state* texture, const generate_mipmaps& cmd, const GLuint view_id, const u32 levels, const u32 layers, memory_barrier_controller& barrier_controller)
+    {
+        ZoneScoped;
+        const bool is_srgb = texture->data_type == texture_data_type::SRGBA_U8_NORM;
+
+        GLuint program = 0;
+        //Averaging sRGB data is done in linear space. MIN / MAX give the same texel either way, so they skip the conversion.
+        const status program_status = find_program(is_srgb ? GL_RGBA8 : texture->gl_texture_format, cmd.filter, is_srgb && cmd.filter == mipmap_filter::AVERAGE, program);
+        if (program_status.is_error()) return program_status;
+
+        {
+            ZoneScopedN("GL calls");
+            glUseProgram(program);
+        }
+
+        for (u32 level = 1; level < levels; level++)
+        {
+            //Each level reads the one written by the previous dispatch.
+            if (level > 1)
+            {
+                barrier_controller.require_barrier(cmd.texture, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+                barrier_controller.flush_barriers();
+            }
+
+            const u32 dest_width = std::max(texture->size.x >> (cmd.base_level + level), 1u);
+            const u32 dest_height = std::max(texture->size.y >> (cmd.base_level + level), 1u);
+
+            {
+                ZoneScopedN("GL calls");
+                glBindImageTexture(0, view_id, level - 1, GL_TRUE, 0, GL_READ_ONLY, is_srgb ? GL_RGBA8 : texture->gl_texture_format);
+                glBindImageTexture(1, view_id, level, GL_TRUE, 0, GL_WRITE_ONLY, is_srgb ? GL_RGBA8 : texture->gl_texture_format);
+                glDispatchCompute((dest_width + 7) / 8, (dest_height + 7) / 8, layers);
+            }
+
+            barrier_controller.flag_write(cmd.texture, TEXTURE_WRITE_BARRIER_BITS);
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status mipmap_generator::find_program(const GLenum image_format, const mipmap_filter filter, const bool srgb, GLuint& out_program)
+    {
+        ZoneScoped;
+        const u64 key = (static_cast<u64>(image_format) << 32) | (static_cast<u64>(filter) << 1) | (srgb ? 1 : 0);
+        if (const auto program_ptr = programs.find(key); program_ptr != programs.end())
+        {
+            out_program = program_ptr->second;
+            return status_type::SUCCESS;
+        }
+
+        const std::string header = std::format("#version 450\n#define IMAGE_FORMAT {0}\n{1}{2}", downsample_image_format(image_format), downsample_filter_define(filter), srgb ? "#define SRGB\n" : "");
+        const std::array sources = {header.c_str(), DOWNSAMPLE_SHADER_SOURCE};
+
+        GLuint program = 0;
+        GLint success = GL_FALSE;
+        {
+            ZoneScopedN("GL calls");
+            program = glCreateShaderProgramv(GL_COMPUTE_SHADER, static_cast<GLsizei>(sources.size()), sources.data());
+            if (program != 0) glGetProgramiv(program, GL_LINK_STATUS, &success);
+        }
+
+        if (success != GL_TRUE)
+        {
+            {
+                ZoneScopedN("GL calls");
+                glDeleteProgram(program);
+            }
+            return {status_type::BACKEND_ERROR, "Building the mipmap downsampling compute shader failed"};
+        }
+
+        programs[key] = program;
+        out_program = program;
+        return status_type::SUCCESS;
+    }
+}
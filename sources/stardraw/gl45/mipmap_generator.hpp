@@ -0,0 +1,32 @@
+#pragma once
+#include <unordered_map>
+
+#include "common.hpp"
+#include "memory_barrier_controller.hpp"
+#include "object_states/texture_state.hpp"
+#include "stardraw/api/commands.hpp"
+
+namespace stardraw::gl45
+{
+    ///Fills texture mipmap levels, either with glGenerateTextureMipmap or with a downsampling compute shader for the filters the driver doesn't provide.
+    ///Compute programs are built on first use for each image format and filter, and kept for the lifetime of the generator.
+    class mipmap_generator
+    {
+    public:
+        mipmap_generator() = default;
+        mipmap_generator(const mipmap_generator&) = delete;
+        mipmap_generator& operator=(const mipmap_generator&) = delete;
+        ~mipmap_generator();
+
+        ///Generate the mipmap levels requested by a command. Compute filters record their image writes (and the barriers between levels) with the barrier controller.
+        [[nodiscard]] status generate(const texture_state* texture, const generate_mipmaps& cmd, memory_barrier_controller& barrier_controller);
+
+    private:
+        [[nodiscard]] static status generate_with_driver(GLuint view_id, u32 levels);
+        [[nodiscard]] status generate_with_compute(const texture_state* texture, const generate_mipmaps& cmd, GLuint view_id, u32 levels, u32 layers, memory_barrier_controller& barrier_controller);
+        [[nodiscard]] status find_program(GLenum image_format, mipmap_filter filter, bool srgb, GLuint& out_program);
+
+        ///Keyed by image format, filter and sRGB conversion.
+        std::unordered_map<u64, GLuint> programs;
+    };
+}
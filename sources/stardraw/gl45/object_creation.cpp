@@ -1,6 +1,9 @@
 #include "render_context.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <format>
+#include <thread>
 
 #include "api_conversion.hpp"
 #include "object_states/framebuffer_state.hpp"
@@ -27,15 +30,72 @@ namespace stardraw::gl45
     status render_context::create_shader_state(const shader* descriptor)
     {
         ZoneScoped;
+        shader_state* shader;
+        const status build_status = build_shader_state(descriptor, shader);
+        if (build_status.is_error()) return build_status;
+
+        return record_object_state(descriptor->identifier(), shader);
+    }
+
+    status render_context::build_shader_state(const shader* descriptor, shader_state*& out_state) const
+    {
+        ZoneScoped;
+        if (descriptor->variant_library != nullptr)
+        {
+            stardraw::shader resolved = *descriptor;
+            resolved.variant_library = nullptr;
+
+            const status variant_status = descriptor->variant_library->get_variant(descriptor->variant, graphics_api::GL45, resolved.stages);
+            if (variant_status.is_error()) return variant_status;
+            return build_shader_state(&resolved, out_state);
+        }
+
+        if (!descriptor->stages.empty())
+        {
+            const status layout_status = validate_shader_buffer_layouts(descriptor->stages, descriptor->buffer_layouts);
+            if (layout_status.is_error()) return layout_status;
+        }
+
         status shader_create_status = status_type::SUCCESS;
-        shader_state* shader = new shader_state(*descriptor, shader_create_status);
+        shader_state* shader = new shader_state(*descriptor, shader_cache, native_spirv_shaders, shader_create_status);
         if (shader_create_status.is_error())
         {
             delete shader;
             return shader_create_status;
         }
 
-        return record_object_state(descriptor->identifier(), shader);
+        out_state = shader;
+        return status_type::SUCCESS;
+    }
+
+    void render_context::compile_shader_states(const std::vector<shader_state*>& pending_shaders)
+    {
+        ZoneScoped;
+        if (pending_shaders.empty()) return;
+
+        //Transpiling doesn't touch GL, so it can be spread across worker threads. Errors are kept in the shader states and reported when they're used.
+        {
+            ZoneScopedN("Transpile shaders");
+            std::atomic<u32> next_shader = 0;
+            const auto worker = [&pending_shaders, &next_shader]()
+            {
+                for (u32 idx = next_shader++; idx < pending_shaders.size(); idx = next_shader++)
+                {
+                    (void)pending_shaders[idx]->transpile_pending_stages();
+                }
+            };
+
+            const u32 worker_count = std::min<u32>(pending_shaders.size(), std::max(1u, std::thread::hardware_concurrency())) - 1;
+            std::vector<std::jthread> workers;
+            for (u32 idx = 0; idx < worker_count; idx++) workers.emplace_back(worker);
+            worker();
+        }
+
+        //Issue every compile and link before checking any of them, so the driver can work on them all at once.
+        for (shader_state* state : pending_shaders)
+        {
+            state->begin_compile();
+        }
     }
 
     status render_context::create_texture_state(const texture* descriptor)
@@ -325,7 +385,7 @@ namespace stardraw::gl45
         if (v_find_status.is_error()) return v_find_status;
 
         shader_state* shader;
-        status find_status = find_shader_state(descriptor->shader, &shader);
+        status find_status = find_shader_state(descriptor->shader, &shader, false);
         if (find_status.is_error()) return find_status;
 
         //draw specification is a thin wrapper that references shader and vertex specifications
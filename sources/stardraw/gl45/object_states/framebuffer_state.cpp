@@ -111,7 +111,9 @@ namespace stardraw::gl45
     status framebuffer_state::attach_color_texture(const framebuffer_attachment_info& info, const texture_state* texture_state, const u32 attachment_index)
     {
         attached_color_formats[attachment_index] = texture_state->data_type;
-        return attach_texture(info, GL_COLOR_ATTACHMENT0 + attachment_index, texture_state);
+        const status attach_status = attach_texture(info, GL_COLOR_ATTACHMENT0 + attachment_index, texture_state);
+        apply_draw_buffers();
+        return attach_status;
     }
 
     status framebuffer_state::attach_depth_texture(const framebuffer_attachment_info& info, const texture_state* texture_state)
@@ -198,6 +200,9 @@ namespace stardraw::gl45
             glBlitNamedFramebuffer(gl_id, dest_state->gl_id, info.read_x, info.read_y, info.read_x + info.read_width, info.read_y + info.read_height, info.write_x, info.write_y, info.write_x + info.write_width, info.write_y + info.write_height, to_gl_attachment_bitfield(info.components), to_gl_filter_mode(info.filtering));
         }
 
+        //The blit narrowed the destination's draw buffers down to a single attachment.
+        if (info.components != attachment_components::DEPTH && info.components != attachment_components::STENCIL) dest_state->apply_draw_buffers();
+
         return status_type::SUCCESS;
     }
 
@@ -272,14 +277,14 @@ namespace stardraw::gl45
             {
                 {
                     ZoneScopedN("GL calls");
-                    glClearNamedFramebufferiv(gl_id, GL_COLOR, GL_COLOR_ATTACHMENT0 + attachment, reinterpret_cast<const GLint*>(values.channels.data.data()));
+                    glClearNamedFramebufferiv(gl_id, GL_COLOR, attachment, reinterpret_cast<const GLint*>(values.channels.data.data()));
                 }
             }
             else
             {
                 {
                     ZoneScopedN("GL calls");
-                    glClearNamedFramebufferuiv(gl_id, GL_COLOR, GL_COLOR_ATTACHMENT0 + attachment, reinterpret_cast<const GLuint*>(values.channels.data.data()));
+                    glClearNamedFramebufferuiv(gl_id, GL_COLOR, attachment, reinterpret_cast<const GLuint*>(values.channels.data.data()));
                 }
             }
         }
@@ -287,13 +292,123 @@ namespace stardraw::gl45
         {
             {
                 ZoneScopedN("GL calls");
-                glClearNamedFramebufferfv(gl_id, GL_COLOR, GL_COLOR_ATTACHMENT0 + attachment, reinterpret_cast<const GLfloat*>(values.channels.data.data()));
+                glClearNamedFramebufferfv(gl_id, GL_COLOR, attachment, reinterpret_cast<const GLfloat*>(values.channels.data.data()));
+            }
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status framebuffer_state::clear_depth_stencil(const f32 depth_value, const u32 stencil_value) const
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            glClearNamedFramebufferfi(gl_id, GL_DEPTH_STENCIL, 0, depth_value, static_cast<GLint>(stencil_value));
+        }
+        return status_type::SUCCESS;
+    }
+
+    status framebuffer_state::begin_pass(const framebuffer_pass_actions& actions)
+    {
+        ZoneScoped;
+        std::vector<GLenum> invalidated_attachments;
+
+        for (const auto& [attachment, format] : attached_color_formats)
+        {
+            if (attachment >= actions.color.size()) continue;
+            const attachment_actions& color_actions = actions.color[attachment];
+
+            if (color_actions.load == attachment_load_action::CLEAR)
+            {
+                const status clear_status = clear_color(attachment, color_actions.clear_value);
+                if (clear_status.is_error()) return clear_status;
+            }
+            else if (color_actions.load == attachment_load_action::DONT_CARE) invalidated_attachments.push_back(GL_COLOR_ATTACHMENT0 + attachment);
+        }
+
+        const bool has_depth = depth_format != 0;
+        const bool has_stencil = stencil_format != 0;
+        const bool clear_depth_value = has_depth && actions.depth.load == attachment_load_action::CLEAR;
+        const bool clear_stencil_value = has_stencil && actions.stencil.load == attachment_load_action::CLEAR;
+
+        //Combined depth-stencil attachments can clear both in one call.
+        if (clear_depth_value && clear_stencil_value && has_combined_depth_stencil())
+        {
+            const status clear_status = clear_depth_stencil(static_cast<f32>(actions.depth.clear_value.depth), actions.stencil.clear_value.stencil);
+            if (clear_status.is_error()) return clear_status;
+        }
+        else
+        {
+            if (clear_depth_value)
+            {
+                const status clear_status = clear_depth(static_cast<f32>(actions.depth.clear_value.depth));
+                if (clear_status.is_error()) return clear_status;
+            }
+
+            if (clear_stencil_value)
+            {
+                const status clear_status = clear_stencil(actions.stencil.clear_value.stencil);
+                if (clear_status.is_error()) return clear_status;
             }
         }
 
+        if (has_depth && actions.depth.load == attachment_load_action::DONT_CARE) invalidated_attachments.push_back(GL_DEPTH_ATTACHMENT);
+        if (has_stencil && actions.stencil.load == attachment_load_action::DONT_CARE) invalidated_attachments.push_back(GL_STENCIL_ATTACHMENT);
+
+        invalidate_attachments(invalidated_attachments);
+        return status_type::SUCCESS;
+    }
+
+    status framebuffer_state::end_pass(const framebuffer_pass_actions& actions) const
+    {
+        ZoneScoped;
+        std::vector<GLenum> invalidated_attachments;
+
+        for (const auto& [attachment, format] : attached_color_formats)
+        {
+            if (attachment < actions.color.size() && actions.color[attachment].store == attachment_store_action::DONT_CARE) invalidated_attachments.push_back(GL_COLOR_ATTACHMENT0 + attachment);
+        }
+
+        if (depth_format != 0 && actions.depth.store == attachment_store_action::DONT_CARE) invalidated_attachments.push_back(GL_DEPTH_ATTACHMENT);
+        if (stencil_format != 0 && actions.stencil.store == attachment_store_action::DONT_CARE) invalidated_attachments.push_back(GL_STENCIL_ATTACHMENT);
+
+        invalidate_attachments(invalidated_attachments);
         return status_type::SUCCESS;
     }
 
+    void framebuffer_state::apply_draw_buffers() const
+    {
+        ZoneScoped;
+        //Draw buffer i always writes to color attachment i, so clears and shader outputs can use attachment indices directly.
+        std::vector<GLenum> draw_buffers;
+        for (const auto& [attachment, format] : attached_color_formats)
+        {
+            if (draw_buffers.size() <= attachment) draw_buffers.resize(attachment + 1, GL_NONE);
+            draw_buffers[attachment] = GL_COLOR_ATTACHMENT0 + attachment;
+        }
+
+        {
+            ZoneScopedN("GL calls");
+            glNamedFramebufferDrawBuffers(gl_id, static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+        }
+    }
+
+    bool framebuffer_state::has_combined_depth_stencil() const
+    {
+        return depth_format != 0 && depth_format == stencil_format;
+    }
+
+    void framebuffer_state::invalidate_attachments(const std::vector<GLenum>& attachments) const
+    {
+        ZoneScoped;
+        if (attachments.empty()) return;
+        {
+            ZoneScopedN("GL calls");
+            glInvalidateNamedFramebufferData(gl_id, static_cast<GLsizei>(attachments.size()), attachments.data());
+        }
+    }
+
     status framebuffer_state::attach_texture(const framebuffer_attachment_info& info, const GLenum attachment, const texture_state* texture_state)
     {
         ZoneScoped;
@@ -23,9 +23,18 @@ namespace stardraw::gl45
         [[nodiscard]] status clear_depth(f32 value) const;
         [[nodiscard]] status clear_stencil(u32 value) const;
         [[nodiscard]] status clear_color(u32 attachment, const clear_values& values);
+        [[nodiscard]] status clear_depth_stencil(f32 depth_value, u32 stencil_value) const;
+
+        ///Apply the load actions of a pass using the framebuffer. Clears are merged where possible, and don't-care attachments are invalidated in a single call.
+        [[nodiscard]] status begin_pass(const framebuffer_pass_actions& actions);
+        ///Apply the store actions of a pass using the framebuffer, invalidating attachments whose contents aren't needed afterward.
+        [[nodiscard]] status end_pass(const framebuffer_pass_actions& actions) const;
 
     private:
         [[nodiscard]] status attach_texture(const framebuffer_attachment_info& info, const GLenum attachment, const texture_state* texture_state);
+        void apply_draw_buffers() const;
+        [[nodiscard]] bool has_combined_depth_stencil() const;
+        void invalidate_attachments(const std::vector<GLenum>& attachments) const;
 
         GLuint gl_id{};
         bool is_framebuffer_complete = false;
@@ -1,7 +1,7 @@
 #include "shader_state.hpp"
+#include <algorithm>
 #include <format>
 #include <ranges>
-#include <spirv_glsl.hpp>
 #include "stardraw/gl45/api_conversion.hpp"
 #include "stardraw/internal/internal.hpp"
 #include "tracy/Tracy.hpp"
@@ -9,15 +9,56 @@
 
 namespace stardraw::gl45
 {
-    shader_state::shader_state(const shader& desc, status& out_status) : shader_id(desc.identifier())
+    shader_state::shader_state(const shader& desc, const program_binary_cache& cache, const bool native_spirv, status& out_status) : shader_id(desc.identifier()), native_spirv(native_spirv)
     {
         ZoneScoped;
-        out_status = create_from_stages(desc.stages);
+        std::vector<shader_stage> stages = desc.stages;
+        if (!desc.specialization_constants.empty())
+        {
+            for (shader_stage& stage : stages) stage = stage.specialize(desc.specialization_constants);
+        }
+
+        spirv_hash = program_binary_cache::hash_stages(stages);
+        binary_retrievable = cache.is_supported();
+
+        //Cached binaries can be rejected for many reasons (driver updates, stale data, etc), so always fall back to a full compile if we can.
+        if (desc.cache_ptr != nullptr && desc.cache_size > 0)
+        {
+            if (!create_from_cache_data(desc.cache_ptr, desc.cache_size, cache, !stages.empty()).is_error())
+            {
+                out_status = status_type::SUCCESS;
+                return;
+            }
+        }
+
+        if (stages.empty())
+        {
+            out_status = {status_type::INVALID, std::format("Shader '{0}' has no stages to compile, and the provided cache data was rejected", shader_id.name)};
+            return;
+        }
+
+        std::vector<u8> disk_data;
+        if (cache.load(spirv_hash, disk_data) && !create_from_cache_data(disk_data.data(), disk_data.size(), cache, true).is_error())
+        {
+            out_status = status_type::SUCCESS;
+            return;
+        }
+
+        //Compilation is deferred so the render context can transpile pending shaders in parallel, then issue all the GL compiles before checking any of them.
+        pending_stages = std::move(stages);
+        for (const shader_stage& stage : pending_stages)
+        {
+            if (stage.internal != nullptr && stage.internal->type == shader_stage_type::COMPUTE) has_compute_stage = true;
+        }
+
+        current_status = shader_status::COMPILING;
+        out_status = status_type::SUCCESS;
     }
 
     shader_state::~shader_state()
     {
         ZoneScoped;
+        release_pending_objects();
         if (!is_valid()) return;
 
         {
@@ -27,347 +68,463 @@ namespace stardraw::gl45
         shader_program_id = 0;
     }
 
-    bool shader_state::is_valid() const
+    shader_status shader_state::get_status() const
     {
-        return shader_program_id != 0;
+        return current_status;
     }
 
-    status shader_state::make_active() const
+    status shader_state::get_compile_status() const
     {
-        ZoneScoped;
-        if (!is_valid()) return {status_type::BACKEND_ERROR, std::format("Shader object '{0}' not valid!", shader_id.name)};
-
-        {
-            ZoneScopedN("GL calls");
-            glUseProgram(shader_program_id);
-        }
-        return status_type::SUCCESS;
+        return compile_status;
     }
 
-    status shader_state::dispatch_compute(const u32 groups_x, const u32 groups_y, const u32 groups_z) const
+    bool shader_state::needs_transpile() const
     {
-        ZoneScoped;
-        if (!has_compute_stage) return {status_type::INVALID, std::format("Can't dispatch compute stage of shader '{0}' - doesn't have a compute stage!", shader_id.name)};
-        status activate_status = make_active();
-        if (activate_status.is_error()) return activate_status;
-
-        {
-            ZoneScopedN("GL calls");
-            glDispatchCompute(groups_x, groups_y, groups_z);
-        }
-        return status_type::SUCCESS;
+        return current_status == shader_status::COMPILING && pending_program == 0 && pending_sources.empty() && pending_binaries.empty() && !compile_status.is_error();
     }
 
-    status shader_state::dispatch_compute_indirect(const u64 indirect_offset) const
+    status shader_state::transpile_pending_stages()
     {
         ZoneScoped;
-        if (!has_compute_stage) return {status_type::INVALID, std::format("Can't dispatch compute stage of shader '{0}' - doesn't have a compute stage!", shader_id.name)};
-        status activate_status = make_active();
-        if (activate_status.is_error()) return activate_status;
+        //NOTE: Called from worker threads - must not make any GL calls.
+        if (use_precompiled_stages()) return compile_status;
 
+        gl_binding_layout layout;
+        if (native_spirv)
         {
-            ZoneScopedN("GL calls");
-            glDispatchComputeIndirect(static_cast<GLintptr>(indirect_offset));
+            bool supported = false;
+            compile_status = patch_spirv_bindings(pending_stages, shader_id.name, pending_binaries, layout, supported);
+            if (supported)
+            {
+                descriptor_set_binding_offsets = std::move(layout.descriptor_set_binding_offsets);
+                slot_stage_masks = std::move(layout.slot_stage_masks);
+                return compile_status;
+            }
+            use_transpiled_stages();
+            layout = {};
         }
-        return status_type::SUCCESS;
-    }
 
-    status shader_state::upload_parameter(const shader_parameter& parameter)
-    {
-        ZoneScoped;
-        if (!parameter.location.internal->is_valid) return {status_type::UNKNOWN, std::format("Shader parameter location '{1}' not found in shader '{0}'", shader_id.name, parameter.location.internal->path_string)};
-        const auto existing_param = std::ranges::find(parameter_store, parameter);
-        if (existing_param == parameter_store.end()) parameter_store.push_back(parameter);
-        else parameter_store.emplace(existing_param, parameter);
-        return status_type::SUCCESS;
+        compile_status = transpile_spirv_to_glsl(pending_stages, shader_id.name, pending_sources, layout);
+        descriptor_set_binding_offsets = std::move(layout.descriptor_set_binding_offsets);
+        slot_stage_masks = std::move(layout.slot_stage_masks);
+        return compile_status;
     }
 
-    void shader_state::clear_parameters()
+    bool shader_state::use_precompiled_stages()
     {
         ZoneScoped;
-        parameter_store.clear();
-    }
+        if (pending_stages.empty() || pending_stages[0].internal == nullptr) return false;
+        const precompiled_program_data* precompiled = pending_stages[0].internal->precompiled;
+        if (precompiled == nullptr) return false;
 
-    void shader_state::flag_barriers(memory_barrier_controller& barrier_controller) const
-    {
-        ZoneScoped;
-        for (const object_binding& bound_object : bound_objects | std::views::values)
+        bool all_native = native_spirv;
+        for (const shader_stage& stage : pending_stages)
+        {
+            //The stored GLSL has the default constant values baked in, so specialized stages have to be converted again.
+            if (stage.internal == nullptr || stage.internal->precompiled != precompiled || !stage.specialization_constants.empty()) return false;
+            if (stage.internal->api != graphics_api::GL45) return false;
+            if (precompiled->gl45_spirv[stage.internal->precompiled_index].empty()) all_native = false;
+        }
+
+        for (const shader_stage& stage : pending_stages)
         {
-            if (!bound_object.write_access) continue;
-            barrier_controller.flag_barriers(bound_object.identifier);
+            const u32 idx = stage.internal->precompiled_index;
+            if (all_native) pending_binaries.push_back({{}, precompiled->gl45_spirv[idx], std::string(precompiled->gl45_entry_points[idx]), {}, {}});
+            else pending_sources.emplace_back(precompiled->gl45_sources[idx]);
         }
+
+        native_spirv = all_native;
+        descriptor_set_binding_offsets = precompiled->gl45_binding_offsets;
+        slot_stage_masks = precompiled->gl45_slot_stage_masks;
+        compile_status = status_type::SUCCESS;
+        return true;
     }
 
-    descriptor_type shader_state::object_type() const
+    void shader_state::use_transpiled_stages()
     {
-        return descriptor_type::SHADER;
+        native_spirv = false;
+        pending_binaries.clear();
+        descriptor_set_binding_offsets.clear();
+        slot_stage_masks.clear();
+        compile_status = status_type::SUCCESS;
     }
 
-    void shader_state::barrier_objects_if_needed(memory_barrier_controller& barrier_controller) const
+    void shader_state::begin_compile()
     {
         ZoneScoped;
-        for (const object_binding& bound_object : bound_objects | std::views::values)
+        if (current_status != shader_status::COMPILING || pending_program != 0) return;
+
+        if (compile_status.is_error())
         {
-            barrier_controller.barrier_if_needed(bound_object.identifier, bound_object.read_barriers);
+            current_status = shader_status::FAILED;
+            return;
         }
-    }
-
-    status shader_state::create_from_stages(const std::vector<shader_stage>& stages)
-    {
-        ZoneScoped;
-        std::vector<std::string> converted_sources;
-        status convert_status = remap_spirv_stages(stages, converted_sources);
-        if (convert_status.is_error()) return convert_status;
 
-        status stages_compile_status = status_type::SUCCESS;
-        std::vector<GLuint> shader_stages;
-        for (u32 idx = 0; idx < stages.size(); idx++)
+        for (u32 idx = 0; idx < pending_stages.size(); idx++)
         {
-            const shader_stage& stage = stages[idx];
-            if (stage.internal->type == shader_stage_type::COMPUTE)
-            {
-                has_compute_stage = true;
-            }
-            const GLenum shader_type = to_gl_shader_type(stage.internal->type);
+            const GLenum shader_type = to_gl_shader_type(pending_stages[idx].internal->type);
             if (shader_type == 0)
             {
-                stages_compile_status = {status_type::BACKEND_ERROR, std::format("A provided shader stage in the shader '{0}' is not supported on this API!", shader_id.name)};
+                compile_status = {status_type::BACKEND_ERROR, std::format("A provided shader stage in the shader '{0}' is not supported on this API!", shader_id.name)};
                 break;
             }
 
-            const std::string& source = converted_sources[idx];
-            GLuint compiled_stage;
-            const status compile_status = compile_shader_stage(source, shader_type, compiled_stage);
-            if (compile_status.is_error())
+            GLuint shader;
             {
-                stages_compile_status = compile_status;
+                ZoneScopedN("GL calls");
+                shader = glCreateShader(shader_type);
+            }
+            if (shader == 0)
+            {
+                compile_status = {status_type::BACKEND_ERROR, std::format("Creating shader '{0}' failed (glCreateShader)", shader_id.name)};
                 break;
             }
 
-            shader_stages.push_back(compiled_stage);
-        }
-
-        if (stages_compile_status.is_error())
-        {
-            for (const GLuint& compiled_stage : shader_stages)
+            if (native_spirv)
             {
-                {
-                    ZoneScopedN("GL calls");
-                    glDeleteShader(compiled_stage);
-                }
+                const spirv_stage_binary& binary = pending_binaries[idx];
+                ZoneScopedN("GL calls");
+                glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, binary.code.data(), binary.code.size() * sizeof(u32));
+                glSpecializeShader(shader, binary.entry_point.c_str(), binary.constant_ids.size(), binary.constant_ids.data(), binary.constant_values.data());
+            }
+            else
+            {
+                const char* c_str = pending_sources[idx].c_str();
+                ZoneScopedN("GL calls");
+                glShaderSource(shader, 1, &c_str, nullptr);
+                glCompileShader(shader);
             }
 
-            return stages_compile_status;
+            pending_shader_stages.push_back(shader);
         }
 
-        GLuint shader_program;
-        status link_status = link_shader(shader_stages, shader_program);
-
-        for (const GLuint shader : shader_stages)
+        if (!compile_status.is_error())
         {
-            {
-                ZoneScopedN("GL calls");
-                glDeleteShader(shader);
-            }
+            ZoneScopedN("GL calls");
+            pending_program = glCreateProgram();
+            if (pending_program == 0) compile_status = {status_type::BACKEND_ERROR, std::format("Creating shader '{0}' failed (glCreateProgram)", shader_id.name)};
         }
 
-        if (link_status.is_error()) return link_status;
+        if (compile_status.is_error())
+        {
+            release_pending_objects();
+            current_status = shader_status::FAILED;
+            return;
+        }
 
-        shader_program_id = shader_program;
+        //Linking is issued without checking the compile status of the stages - if any failed to compile, linking will fail and we can find out why later.
+        {
+            ZoneScopedN("GL calls");
+            for (const GLuint shader : pending_shader_stages) glAttachShader(pending_program, shader);
+            if (binary_retrievable) glProgramParameteri(pending_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(pending_program);
+        }
 
-        return status_type::SUCCESS;
+        pending_sources.clear();
+        pending_binaries.clear();
     }
 
-
-    status shader_state::remap_spirv_stages(const std::vector<shader_stage>& stages, std::vector<std::string>& out_sources)
+    shader_status shader_state::poll_compile(const program_binary_cache& cache, const bool wait)
     {
-        ZoneScopedN("Convert Slang spirv to opengl-compatible GLSL");
-        for (const shader_stage& stage : stages)
+        ZoneScoped;
+        if (current_status != shader_status::COMPILING) return current_status;
+
+        if (pending_program == 0)
         {
-            if (stage.internal == nullptr) return {status_type::UNEXPECTED, std::format("A provided shader stage for shader '{0}' is invalid!", shader_id.name)};
-            if (stage.internal->api != graphics_api::GL45) return {status_type::INVALID, std::format("A provided shader stage for shader '{0}' is non-GL45!", shader_id.name)};
+            //Not issued yet (or compilation couldn't start) - we can only finish by doing all the work now.
+            if (!wait) return current_status;
+            if (needs_transpile()) (void)transpile_pending_stages();
+            begin_compile();
+            if (current_status != shader_status::COMPILING) return current_status;
         }
 
-        struct stage_compiler
+        if (!wait && (GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile))
         {
-            spirv_cross::CompilerGLSL compiler;
-            std::vector<spirv_cross::Resource> resources_with_binding_sets;
-        };
+            GLint complete = GL_FALSE;
+            {
+                ZoneScopedN("GL calls");
+                glGetProgramiv(pending_program, GL_COMPLETION_STATUS_KHR, &complete);
+            }
+            if (complete != GL_TRUE) return current_status;
+        }
 
-        std::vector<stage_compiler*> stage_compilers;
-        status result_status = status_type::SUCCESS;
+        GLint success = GL_TRUE;
+        {
+            ZoneScopedN("GL calls");
+            glGetProgramiv(pending_program, GL_LINK_STATUS, &success);
+        }
 
-        constexpr spirv_cross::CompilerGLSL::Options options = spirv_cross::CompilerGLSL::Options {
-            .version = 450,
-            .enable_storage_image_qualifier_deduction = false,
-        };
+        if (success != GL_TRUE && native_spirv)
+        {
+            //Driver support for SPIR-V is much less mature than for GLSL, so retry through the transpile path before reporting anything.
+            release_pending_objects();
+            use_transpiled_stages();
+            (void)transpile_pending_stages();
+            begin_compile();
+            return poll_compile(cache, wait);
+        }
 
-        try
+        if (success != GL_TRUE)
         {
-            for (const shader_stage& stage : stages)
+            //Report the first stage that failed to compile if there is one, since its log is far more useful than the link log.
+            for (const GLuint shader : pending_shader_stages)
             {
-                stage_compilers.push_back(new stage_compiler {spirv_cross::CompilerGLSL(static_cast<const u32*>(stage.internal->data), stage.internal->data_size / sizeof(u32)), {}});
+                GLint compiled = GL_TRUE;
+                {
+                    ZoneScopedN("GL calls");
+                    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+                }
+
+                if (compiled == GL_TRUE) continue;
+                compile_status = {status_type::BACKEND_ERROR, std::format("Shader stage compilation for shader '{1}' failed with error: \n {0}", get_shader_log(shader), shader_id.name)};
+                break;
             }
 
-            std::vector<u32> bindings_per_set;
+            if (!compile_status.is_error()) compile_status = {status_type::BACKEND_ERROR, std::format("Shader validation for shader '{1}' failed with error: \n {0}", get_program_log(pending_program), shader_id.name)};
 
-            for (stage_compiler* stage : stage_compilers)
-            {
-                stage->compiler.set_common_options(options);
+            release_pending_objects();
+            current_status = shader_status::FAILED;
+            return current_status;
+        }
 
-                spirv_cross::ShaderResources resources = stage->compiler.get_shader_resources();
+        shader_program_id = pending_program;
+        pending_program = 0;
+        release_pending_objects();
+        pending_stages.clear();
+        current_status = shader_status::READY;
 
-                stage->resources_with_binding_sets.append_range(resources.sampled_images);
-                stage->resources_with_binding_sets.append_range(resources.separate_images);
-                stage->resources_with_binding_sets.append_range(resources.separate_samplers);
-                stage->resources_with_binding_sets.append_range(resources.uniform_buffers);
-                stage->resources_with_binding_sets.append_range(resources.storage_buffers);
-                stage->resources_with_binding_sets.append_range(resources.storage_images);
-                stage->resources_with_binding_sets.append_range(resources.atomic_counters);
+        if (cache.has_directory())
+        {
+            std::vector<u8> cache_data;
+            if (!get_cache_data(cache, cache_data).is_error()) cache.store(spirv_hash, cache_data);
+        }
 
-                for (const spirv_cross::Resource& resource : stage->resources_with_binding_sets)
-                {
-                    const u32 descriptor_set = stage->compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-                    const u32 binding_index = stage->compiler.get_decoration(resource.id, spv::DecorationBinding);
-                    if (descriptor_set >= bindings_per_set.size()) bindings_per_set.resize(descriptor_set + 1);
-                    bindings_per_set[descriptor_set] = std::max(bindings_per_set[descriptor_set], binding_index + 1);
-                }
-            }
+        return current_status;
+    }
 
-            descriptor_set_binding_offsets.resize(bindings_per_set.size());
+    void shader_state::release_pending_objects()
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            for (const GLuint shader : pending_shader_stages) glDeleteShader(shader);
+            if (pending_program != 0) glDeleteProgram(pending_program);
+        }
 
-            u32 binding_offset = 0;
-            for (u32 idx = 0; idx < bindings_per_set.size(); idx++)
-            {
-                descriptor_set_binding_offsets[idx] = binding_offset;
-                binding_offset += bindings_per_set[idx];
-            }
+        pending_shader_stages.clear();
+        pending_program = 0;
+        pending_sources.clear();
+        pending_binaries.clear();
+    }
 
-            for (stage_compiler* stage : stage_compilers)
-            {
-                for (const spirv_cross::Resource& resource : stage->resources_with_binding_sets)
-                {
-                    const u32 descriptor_set = stage->compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-                    const u32 binding_index = stage->compiler.get_decoration(resource.id, spv::DecorationBinding);
-                    stage->compiler.unset_decoration(resource.id, spv::DecorationDescriptorSet);
-                    stage->compiler.set_decoration(resource.id, spv::DecorationBinding, binding_index + descriptor_set_binding_offsets[descriptor_set]);
-                }
+    bool shader_state::is_valid() const
+    {
+        return shader_program_id != 0;
+    }
 
-                //Handle merging sampler states with samplers where possible, transfer binding and name from original sampler.
-                stage->compiler.build_combined_image_samplers();
-                for (const spirv_cross::CombinedImageSampler& combined : stage->compiler.get_combined_image_samplers())
-                {
-                    const std::string tex_name = stage->compiler.get_name(combined.image_id);
-                    const u32 binding = stage->compiler.get_decoration(combined.image_id, spv::Decoration::DecorationBinding);
-                    stage->compiler.set_decoration(combined.combined_id, spv::Decoration::DecorationBinding, binding);
-                    stage->compiler.set_name(combined.combined_id, tex_name);
-                }
+    status shader_state::make_active() const
+    {
+        ZoneScoped;
+        if (!is_valid()) return {status_type::BACKEND_ERROR, std::format("Shader object '{0}' not valid!", shader_id.name)};
 
-                stage->compiler.set_common_options({.version = 450, .emit_push_constant_as_uniform_buffer = true});
+        {
+            ZoneScopedN("GL calls");
+            glUseProgram(shader_program_id);
+        }
+        return status_type::SUCCESS;
+    }
 
-                const std::string source = stage->compiler.compile();
-                if (source.empty())
-                {
-                    result_status = {status_type::BACKEND_ERROR, std::format("Failed to transpile SPIR-V into OpenGL compatible GLSL for shader '{0}'", shader_id.name)};
-                    break;
-                }
+    status shader_state::dispatch_compute(const u32 groups_x, const u32 groups_y, const u32 groups_z) const
+    {
+        ZoneScoped;
+        if (!has_compute_stage) return {status_type::INVALID, std::format("Can't dispatch compute stage of shader '{0}' - doesn't have a compute stage!", shader_id.name)};
+        status activate_status = make_active();
+        if (activate_status.is_error()) return activate_status;
 
-                out_sources.push_back(source);
-            }
-        }
-        catch (std::exception& _)
         {
-            result_status = {status_type::BACKEND_ERROR, std::format("Failed to transpile SPIR-V into OpenGL compatible GLSL for shader '{0}'", shader_id.name)};
+            ZoneScopedN("GL calls");
+            glDispatchCompute(groups_x, groups_y, groups_z);
         }
+        return status_type::SUCCESS;
+    }
+
+    status shader_state::dispatch_compute_indirect(const u64 indirect_offset) const
+    {
+        ZoneScoped;
+        if (!has_compute_stage) return {status_type::INVALID, std::format("Can't dispatch compute stage of shader '{0}' - doesn't have a compute stage!", shader_id.name)};
+        status activate_status = make_active();
+        if (activate_status.is_error()) return activate_status;
 
-        for (const stage_compiler* stage : stage_compilers)
         {
-            delete stage;
+            ZoneScopedN("GL calls");
+            glDispatchComputeIndirect(static_cast<GLintptr>(indirect_offset));
         }
+        return status_type::SUCCESS;
+    }
 
-        return result_status;
+    status shader_state::upload_parameter(const shader_parameter& parameter)
+    {
+        ZoneScoped;
+        if (!parameter.location.is_valid()) return {status_type::UNKNOWN, std::format("Shader parameter location not found in shader '{0}' (last valid location: '{1}')", shader_id.name, parameter.location.path())};
+        const auto existing_param = std::ranges::find(parameter_store, parameter);
+        if (existing_param == parameter_store.end()) parameter_store.push_back(parameter);
+        else parameter_store.emplace(existing_param, parameter);
+        return status_type::SUCCESS;
     }
 
-    status shader_state::link_shader(const std::vector<GLuint>& stages, GLuint& out_shader_id)
+    void shader_state::clear_parameters()
     {
         ZoneScoped;
-        const GLuint program = glCreateProgram();
-        if (program == 0) return {status_type::BACKEND_ERROR, std::format("Creating shader '{0}' failed (glCreateProgram)", shader_id.name)};
+        parameter_store.clear();
+    }
 
-        for (const GLuint shader : stages)
-        {
-            if (shader != 0)
-            {
-                {
-                    ZoneScopedN("GL calls");
-                    glAttachShader(program, shader);
-                }
-            }
-        }
+    status shader_state::get_cache_data(const program_binary_cache& cache, std::vector<u8>& out_data) const
+    {
+        ZoneScoped;
+        if (!is_valid()) return {status_type::BACKEND_ERROR, std::format("Shader object '{0}' not valid!", shader_id.name)};
+        if (!binary_retrievable) return {status_type::UNSUPPORTED, std::format("Can't get cache data for shader '{0}' - the driver does not support program binaries", shader_id.name)};
 
+        GLint binary_length = 0;
         {
             ZoneScopedN("GL calls");
-            glLinkProgram(program);
+            glGetProgramiv(shader_program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
         }
+        if (binary_length <= 0) return {status_type::BACKEND_ERROR, std::format("Can't get cache data for shader '{0}' - the driver did not provide a program binary", shader_id.name)};
 
-        GLint success = GL_TRUE;
+        const u64 offsets_size = descriptor_set_binding_offsets.size() * sizeof(u32);
+        const u64 masks_size = slot_stage_masks.size() * sizeof(u32) * 2;
+        const u64 metadata_size = sizeof(program_cache_header) + offsets_size + masks_size;
+        out_data.resize(metadata_size + binary_length);
+
+        u8* cursor = out_data.data() + sizeof(program_cache_header);
+        memcpy(cursor, descriptor_set_binding_offsets.data(), offsets_size);
+        cursor += offsets_size;
+
+        for (const auto& [slot, mask] : slot_stage_masks)
+        {
+            const u32 pair[2] = {slot, mask};
+            memcpy(cursor, pair, sizeof(pair));
+            cursor += sizeof(pair);
+        }
 
+        GLsizei written_length = 0;
+        GLenum binary_format = 0;
         {
             ZoneScopedN("GL calls");
-            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            glGetProgramBinary(shader_program_id, binary_length, &written_length, &binary_format, cursor);
         }
+        if (written_length <= 0) return {status_type::BACKEND_ERROR, std::format("Can't get cache data for shader '{0}' - the driver did not provide a program binary", shader_id.name)};
+        out_data.resize(metadata_size + written_length);
+
+        const program_cache_header header = {
+            .magic = PROGRAM_CACHE_MAGIC,
+            .version = PROGRAM_CACHE_VERSION,
+            .spirv_hash = spirv_hash,
+            .driver_hash = cache.get_driver_hash(),
+            .binary_format = binary_format,
+            .binary_size = static_cast<u32>(written_length),
+            .has_compute_stage = has_compute_stage,
+            .binding_offset_count = static_cast<u32>(descriptor_set_binding_offsets.size()),
+            .slot_stage_mask_count = static_cast<u32>(slot_stage_masks.size()),
+        };
+        memcpy(out_data.data(), &header, sizeof(header));
 
-        if (success != GL_TRUE)
+        return status_type::SUCCESS;
+    }
+
+    bool shader_state::is_fragment_only_slot(const u32 slot) const
+    {
+        const auto mask_ptr = slot_stage_masks.find(slot);
+        if (mask_ptr == slot_stage_masks.end()) return false;
+        return mask_ptr->second == (1u << static_cast<u32>(shader_stage_type::FRAGMENT));
+    }
+
+    void shader_state::require_barriers(memory_barrier_controller& barrier_controller, const bool is_draw, const u64 framebuffer_hash) const
+    {
+        ZoneScoped;
+        for (const object_binding& bound_object : bound_objects | std::views::values)
         {
-            std::string log = get_program_log(program);
-            {
-                ZoneScopedN("GL calls");
-                glDeleteProgram(program);
-            }
-            return {status_type::BACKEND_ERROR, std::format("Shader validation for shader '{1}' failed with error: \n {0}", log, shader_id.name)};
+            barrier_controller.require_barrier(bound_object.identifier, bound_object.read_barriers, {is_draw && bound_object.fragment_only, framebuffer_hash});
         }
+    }
 
-        out_shader_id = program;
+    void shader_state::flag_writes(memory_barrier_controller& barrier_controller, const bool is_draw, const u64 framebuffer_hash) const
+    {
+        ZoneScoped;
+        for (const object_binding& bound_object : bound_objects | std::views::values)
+        {
+            if (bound_object.write_barriers == 0) continue;
+            barrier_controller.flag_write(bound_object.identifier, bound_object.write_barriers, {is_draw && bound_object.fragment_only, framebuffer_hash});
+        }
+    }
 
-        return status_type::SUCCESS;
+    descriptor_type shader_state::object_type() const
+    {
+        return descriptor_type::SHADER;
     }
 
-    status shader_state::compile_shader_stage(const std::string& source, const GLuint type, GLuint& out_shader_id)
+    status shader_state::create_from_cache_data(const void* data, const u64 size, const program_binary_cache& cache, const bool check_spirv_hash)
     {
         ZoneScoped;
-        GLuint shader;
+        if (!cache.is_supported()) return {status_type::UNSUPPORTED, "The driver does not support program binaries"};
+        if (size < sizeof(program_cache_header)) return {status_type::INVALID, std::format("Cache data for shader '{0}' is too small", shader_id.name)};
+
+        const u8* bytes = static_cast<const u8*>(data);
+        program_cache_header header;
+        memcpy(&header, bytes, sizeof(header));
+
+        if (header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION) return {status_type::INVALID, std::format("Cache data for shader '{0}' is not a recognized program cache", shader_id.name)};
+        if (header.driver_hash != cache.get_driver_hash()) return {status_type::INVALID, std::format("Cache data for shader '{0}' was created by a different driver", shader_id.name)};
+        if (check_spirv_hash && header.spirv_hash != spirv_hash) return {status_type::INVALID, std::format("Cache data for shader '{0}' does not match the provided shader stages", shader_id.name)};
+
+        const u64 offsets_size = header.binding_offset_count * sizeof(u32);
+        const u64 masks_size = header.slot_stage_mask_count * sizeof(u32) * 2;
+        if (size != sizeof(program_cache_header) + offsets_size + masks_size + header.binary_size) return {status_type::INVALID, std::format("Cache data for shader '{0}' is corrupted", shader_id.name)};
+
+        const u8* cursor = bytes + sizeof(program_cache_header);
+        std::vector<u32> cached_binding_offsets(header.binding_offset_count);
+        memcpy(cached_binding_offsets.data(), cursor, offsets_size);
+        cursor += offsets_size;
+
+        std::unordered_map<u32, u32> cached_slot_stage_masks;
+        for (u32 idx = 0; idx < header.slot_stage_mask_count; idx++)
         {
-            ZoneScopedN("GL calls");
-            shader = glCreateShader(type);
+            u32 pair[2];
+            memcpy(pair, cursor, sizeof(pair));
+            cached_slot_stage_masks[pair[0]] = pair[1];
+            cursor += sizeof(pair);
         }
-        if (shader == 0) return {status_type::BACKEND_ERROR, std::format("Creating shader '{0}' failed (glCreateShader)", shader_id.name)};
 
-        const char* c_str = source.c_str();
+        GLuint program;
         {
             ZoneScopedN("GL calls");
-            glShaderSource(shader, 1, &c_str, nullptr);
-            glCompileShader(shader);
+            program = glCreateProgram();
         }
+        if (program == 0) return {status_type::BACKEND_ERROR, std::format("Creating shader '{0}' failed (glCreateProgram)", shader_id.name)};
 
-        GLint success = GL_TRUE;
-
+        GLint success = GL_FALSE;
         {
             ZoneScopedN("GL calls");
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (binary_retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glProgramBinary(program, header.binary_format, cursor, static_cast<GLsizei>(header.binary_size));
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
         }
 
         if (success != GL_TRUE)
         {
-            const std::string log = get_shader_log(shader);
             {
                 ZoneScopedN("GL calls");
-                glDeleteShader(shader);
+                glDeleteProgram(program);
             }
-            return {status_type::BACKEND_ERROR, std::format("Shader stage compilation for shader '{1}' failed with error: \n {0}", log, shader_id.name)};
+            return {status_type::BACKEND_ERROR, std::format("Cached program binary for shader '{0}' was rejected by the driver", shader_id.name)};
         }
 
-        out_shader_id = shader;
-
+        shader_program_id = program;
+        spirv_hash = header.spirv_hash;
+        has_compute_stage = header.has_compute_stage != 0;
+        descriptor_set_binding_offsets = std::move(cached_binding_offsets);
+        slot_stage_masks = std::move(cached_slot_stage_masks);
+        current_status = shader_status::READY;
         return status_type::SUCCESS;
     }
 
@@ -7,6 +7,8 @@
 #include "../common.hpp"
 #include "stardraw/api/commands.hpp"
 #include "../memory_barrier_controller.hpp"
+#include "../program_binary_cache.hpp"
+#include "../spirv_conversion.hpp"
 
 namespace stardraw::gl45
 {
@@ -22,39 +24,59 @@ namespace stardraw::gl45
         struct object_binding
         {
             object_identifier identifier;
-            bool write_access = false;
+            GLbitfield write_barriers = 0; //Barriers that later reads may need if the shader writes to the object, 0 if it's read-only
             GLbitfield read_barriers = 0;
+            bool fragment_only = false; //Only accessed by the fragment stage
         };
 
-        explicit shader_state(const shader& desc, status& out_status);
+        explicit shader_state(const shader& desc, const program_binary_cache& cache, bool native_spirv, status& out_status);
         ~shader_state() override;
 
         [[nodiscard]] bool is_valid() const;
 
+        [[nodiscard]] shader_status get_status() const;
+        ///The error that caused compilation to fail, if the shader status is FAILED.
+        [[nodiscard]] status get_compile_status() const;
+
+        ///Shaders that aren't created from cached data are compiled in steps so that work for many shaders can overlap:
+        ///transpile_pending_stages (threadsafe, no GL calls) -> begin_compile (issues GL compile & link) -> poll_compile (checks for completion)
+        ///With native SPIR-V, 'transpiling' only patches the bindings in the SPIR-V, and the driver loads it with glShaderBinary / glSpecializeShader.
+        ///Stages loaded from a shader archive skip this step entirely, using the GLSL or patched SPIR-V stored in the archive.
+        [[nodiscard]] bool needs_transpile() const;
+        [[nodiscard]] status transpile_pending_stages();
+        void begin_compile();
+        [[nodiscard]] shader_status poll_compile(const program_binary_cache& cache, bool wait);
+
         [[nodiscard]] status make_active() const;
         [[nodiscard]] status dispatch_compute(u32 groups_x, u32 groups_y, u32 groups_z) const;
         [[nodiscard]] status dispatch_compute_indirect(u64 indirect_offset) const;
         [[nodiscard]] status upload_parameter(const shader_parameter& parameter);
         void clear_parameters();
 
-        void flag_barriers(memory_barrier_controller& barrier_controller) const;
+        ///Get a program binary (with the metadata needed to recreate the shader state) that can be passed back via the shader descriptor cache fields.
+        [[nodiscard]] status get_cache_data(const program_binary_cache& cache, std::vector<u8>& out_data) const;
+
+        [[nodiscard]] bool is_fragment_only_slot(u32 slot) const;
+        void require_barriers(memory_barrier_controller& barrier_controller, bool is_draw, u64 framebuffer_hash) const;
+        void flag_writes(memory_barrier_controller& barrier_controller, bool is_draw, u64 framebuffer_hash) const;
 
         [[nodiscard]] descriptor_type object_type() const override;
-        void barrier_objects_if_needed(memory_barrier_controller& barrier_controller) const;
 
         std::vector<u32> descriptor_set_binding_offsets;
         std::vector<shader_parameter> parameter_store;
         std::unordered_map<u32, object_binding> bound_objects;
+        std::unordered_map<u32, u32> slot_stage_masks; //Bitmask of (1 << shader_stage_type) for each stage that uses a binding slot
         bool has_compute_stage = false;
         object_identifier shader_id;
 
     private:
-        [[nodiscard]] status create_from_stages(const std::vector<shader_stage>& stages);
+        [[nodiscard]] status create_from_cache_data(const void* data, u64 size, const program_binary_cache& cache, bool check_spirv_hash);
 
-        [[nodiscard]] status remap_spirv_stages(const std::vector<shader_stage>& stages, std::vector<std::string>& out_sources);
+        ///False if the pending stages aren't all from the same precompiled program (or need specializing), in which case they need converting.
+        [[nodiscard]] bool use_precompiled_stages();
+        void use_transpiled_stages();
 
-        [[nodiscard]] status link_shader(const std::vector<GLuint>& stages, GLuint& out_shader_id);
-        [[nodiscard]] status compile_shader_stage(const std::string& source, const GLuint type, GLuint& out_shader_id);
+        void release_pending_objects();
 
         [[nodiscard]] status validate_program(const GLuint program);
 
@@ -62,5 +84,15 @@ namespace stardraw::gl45
         [[nodiscard]] std::string get_program_log(const GLuint program) const;
 
         GLuint shader_program_id = 0;
+        shader_status current_status = shader_status::READY;
+        status compile_status = status_type::SUCCESS;
+        std::vector<shader_stage> pending_stages;
+        std::vector<std::string> pending_sources;
+        std::vector<spirv_stage_binary> pending_binaries;
+        std::vector<GLuint> pending_shader_stages;
+        GLuint pending_program = 0;
+        u64 spirv_hash = 0;
+        bool binary_retrievable = false;
+        bool native_spirv = false;
     };
 }
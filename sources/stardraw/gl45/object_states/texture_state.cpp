@@ -101,6 +101,13 @@ namespace stardraw::gl45
             }
         }
 
+        streamed = desc.streamed;
+        if (streamed)
+        {
+            completed_mipmap_levels.assign(num_texture_mipmap_levels, false);
+            resident_mipmap_level = num_texture_mipmap_levels;
+        }
+
         texture_sampling_conifg sampling_config = desc.default_sampling_config;
         sampling_config.mipmap_max_level = std::min(sampling_config.mipmap_max_level, num_texture_mipmap_levels - 1);
         out_status = set_sampling_config(sampling_config, is_texture_data_type_integer(desc.format.data_type));
@@ -110,6 +117,12 @@ namespace stardraw::gl45
     {
         ZoneScoped;
 
+        if (desc.streamed)
+        {
+            out_status = {status_type::INVALID, std::format("Texture view '{0}' can't be streamed", desc.identifier().name)};
+            return;
+        }
+
         const status compatibility_status = original->is_view_compatible(desc);
         if (compatibility_status.is_error())
         {
@@ -154,6 +167,10 @@ namespace stardraw::gl45
 
         {
             ZoneScopedN("GL calls");
+            for (const pending_mipmap_upload& upload : pending_mipmap_uploads)
+            {
+                glDeleteSync(upload.fence);
+            }
             glDeleteTextures(1, &gl_texture_id);
         }
     }
@@ -194,6 +211,27 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
+    status texture_state::unpack_compressed_blocks(const u32 mipmap_level, const u32 x, const u32 y, const u32 layer, const u32 width, const u32 height, const u32 layers, const u64 bytes, const u64 pbo_offset) const
+    {
+        ZoneScoped;
+        //Compressed data types are only allowed on 2D textures, 2D array textures and cubemaps (validated on creation). Array layers and cubemap faces are addressed as z.
+        const bool layered = num_texture_array_layers > 1 || shape == texture_shape::CUBE_MAP;
+
+        {
+            ZoneScopedN("GL calls");
+            if (layered)
+            {
+                glCompressedTextureSubImage3D(gl_texture_id, mipmap_level, x, y, layer, width, height, layers, gl_texture_format, bytes, reinterpret_cast<void*>(pbo_offset));
+            }
+            else
+            {
+                glCompressedTextureSubImage2D(gl_texture_id, mipmap_level, x, y, width, height, gl_texture_format, bytes, reinterpret_cast<void*>(pbo_offset));
+            }
+        }
+
+        return status_type::SUCCESS;
+    }
+
     status texture_state::copy_pixels(const texture_state* read_texture, const texture_copy_info& copy_info) const
     {
         ZoneScoped;
@@ -258,7 +296,7 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status texture_state::prepare_upload(transfer_buffer_state* transfer_buffer, const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const
+    status texture_state::validate_upload(const texture_memory_transfer_info& info) const
     {
         ZoneScoped;
 
@@ -270,8 +308,30 @@ namespace stardraw::gl45
         if (info.mipmap_level >= num_texture_mipmap_levels) return {status_type::RANGE_OVERFLOW, std::format("Texture upload mipmap level is outside the bounds of the texture '{0}'", texture_id.name)};
         if (info.layer + info.layers > num_texture_array_layers || info.layers < 1) return {status_type::RANGE_OVERFLOW, std::format("Texture upload array layers are outside the bounds of the texture '{0}'", texture_id.name)};
 
+        if (is_texture_data_type_compressed(data_type))
+        {
+            //Uploads are whole blocks, except where a block overhangs the edge of the mipmap level.
+            const u32 level_width = std::max(size.x >> info.mipmap_level, 1u);
+            const u32 level_height = std::max(size.y >> info.mipmap_level, 1u);
+            const bool width_aligned = info.width % data_block.width == 0 || info.x + info.width == level_width;
+            const bool height_aligned = info.height % data_block.height == 0 || info.y + info.height == level_height;
+
+            if (info.x % data_block.width != 0 || info.y % data_block.height != 0 || !width_aligned || !height_aligned)
+            {
+                return {status_type::INVALID, std::format("Texture upload region isn't aligned to the {0}x{1} compression blocks of texture '{2}'", data_block.width, data_block.height, texture_id.name)};
+            }
+        }
+
         if (info.channels == texture_memory_transfer_info::pixel_channels::STENCIL && !does_texture_data_type_have_stencil(data_type)) return {status_type::INVALID, std::format("Texture upload channels is set to stencil, but texture '{0}' does not contain stencil data!", texture_id.name)};
         if (info.channels == texture_memory_transfer_info::pixel_channels::DEPTH && !does_texture_data_type_have_depth(data_type)) return {status_type::INVALID, std::format("Texture upload channels is set to depth, but texture '{0}' does not contain depth data!", texture_id.name)};
+        return status_type::SUCCESS;
+    }
+
+    status texture_state::prepare_upload(transfer_buffer_state* transfer_buffer, const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const
+    {
+        ZoneScoped;
+        const status validate_status = validate_upload(info);
+        if (validate_status.is_error()) return validate_status;
 
         const u64 bytes = compute_bytes_in_transfer(info);
 
@@ -282,30 +342,107 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status texture_state::flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle) const
+    status texture_state::flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle)
     {
         ZoneScoped;
         const gl_memory_transfer_handle* gl_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
         if (gl_handle == nullptr) return {status_type::INVALID, std::format("Invalid memory transfer handle cast - this is an internal bug! (trying to upload to texture '{0}')", texture_id.name)};
 
+        const status unpack_status = unpack_region(info, gl_handle->transfer_buffer_id, gl_handle->transfer_buffer_address);
+        if (unpack_status.is_error()) return unpack_status;
+
+        if (streamed && is_whole_mipmap_level(info))
         {
             ZoneScopedN("GL calls");
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_handle->transfer_buffer_id);
+            pending_mipmap_uploads.push_back({info.mipmap_level, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
         }
-        status unpack_status = unpack_pixels(info.mipmap_level, info.x, info.y, info.z, info.width, info.height, info.depth, to_gl_channels_format(info.channels), to_gl_memory_transfer_data_type(info.data_type), gl_handle->transfer_buffer_address);
-        if (unpack_status.is_error()) return unpack_status;
+
         return transfer_buffer_state::flush_upload(gl_handle);
     }
 
+    status texture_state::unpack_region(const texture_memory_transfer_info& info, const GLuint pixel_buffer_id, const u64 pbo_offset) const
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer_id);
+        }
+
+        if (is_texture_data_type_compressed(data_type))
+        {
+            //Compressed data is uploaded as-is, so the transfer's channels and data type are ignored.
+            return unpack_compressed_blocks(info.mipmap_level, info.x, info.y, info.layer, info.width, info.height, info.layers, compute_bytes_in_transfer(info), pbo_offset);
+        }
+
+        //Array layers (and cubemap faces) are addressed by the axis after the texture's own axes.
+        u32 y = info.y, height = info.height, z = info.z, depth = info.depth;
+        if (shape == texture_shape::_1D && num_texture_array_layers > 1)
+        {
+            y = info.layer;
+            height = info.layers;
+        }
+        else if (shape != texture_shape::_3D && (num_texture_array_layers > 1 || shape == texture_shape::CUBE_MAP))
+        {
+            z = info.layer;
+            depth = info.layers;
+        }
+
+        return unpack_pixels(info.mipmap_level, info.x, y, z, info.width, height, depth, to_gl_channels_format(info.channels), to_gl_memory_transfer_data_type(info.data_type), pbo_offset);
+    }
+
+    bool texture_state::update_streaming()
+    {
+        ZoneScoped;
+        {
+            ZoneScopedN("GL calls");
+            std::erase_if(pending_mipmap_uploads, [this](const pending_mipmap_upload& upload)
+            {
+                if (glClientWaitSync(upload.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+                glDeleteSync(upload.fence);
+                completed_mipmap_levels[upload.mipmap_level] = true;
+                return true;
+            });
+        }
+
+        //Levels become sampleable smallest first, and only once every smaller level has also arrived.
+        u32 resident_level = resident_mipmap_level;
+        while (resident_level > 0 && completed_mipmap_levels[resident_level - 1]) resident_level--;
+
+        if (resident_level != resident_mipmap_level)
+        {
+            resident_mipmap_level = resident_level;
+            {
+                ZoneScopedN("GL calls");
+                glTextureParameteri(gl_texture_id, GL_TEXTURE_BASE_LEVEL, std::max(sampling_min_mipmap_level, resident_level));
+            }
+        }
+
+        return resident_mipmap_level > 0;
+    }
+
+    bool texture_state::is_whole_mipmap_level(const texture_memory_transfer_info& info) const
+    {
+        const u32 level_width = std::max(size.x >> info.mipmap_level, 1u);
+        const u32 level_height = std::max(size.y >> info.mipmap_level, 1u);
+        const u32 level_depth = std::max(size.z >> info.mipmap_level, 1u);
+
+        if (info.x != 0 || info.y != 0 || info.z != 0 || info.layer != 0) return false;
+        if (info.width != level_width || info.height != level_height || info.depth != level_depth) return false;
+        return info.layers == num_texture_array_layers;
+    }
+
     u64 texture_state::compute_bytes_in_transfer(const texture_memory_transfer_info& info) const
     {
         ZoneScoped;
+        //Partial blocks at the edges of the region still take a whole block. For uncompressed data types, a block is one pixel.
+        const u64 blocks_x = (info.width + data_block.width - 1) / data_block.width;
+        const u64 blocks_y = (info.height + data_block.height - 1) / data_block.height;
         switch (shape)
         {
-            case texture_shape::_1D: return info.width * info.layers * bytes_per_pixel;
-            case texture_shape::_2D: return info.width * info.height * info.layers * bytes_per_pixel;
-            case texture_shape::_3D: return info.width * info.height * info.depth * info.layers * bytes_per_pixel;
-            case texture_shape::CUBE_MAP: return info.width * info.height * info.layers * bytes_per_pixel;
+            case texture_shape::_1D: return blocks_x * info.layers * data_block.bytes;
+            case texture_shape::_2D: return blocks_x * blocks_y * info.layers * data_block.bytes;
+            case texture_shape::_3D: return blocks_x * blocks_y * info.depth * info.layers * data_block.bytes;
+            case texture_shape::CUBE_MAP: return blocks_x * blocks_y * info.layers * data_block.bytes;
             default: return -1;
         }
     }
@@ -317,7 +454,7 @@ namespace stardraw::gl45
         num_texture_array_layers = desc.format.layers;
         shape = desc.format.shape;
         data_type = desc.format.data_type;
-        bytes_per_pixel = bytes_per_texture_data_element(data_type);
+        data_block = texture_data_type_block_info(data_type);
         size = {desc.format.width, desc.format.height, desc.format.depth};
         num_texture_msaa_samples = static_cast<u8>(desc.format.msaa);
 
@@ -354,6 +491,16 @@ namespace stardraw::gl45
             return {status_type::INVALID, std::format("Texture '{0}' shape cannot be an array texture, but has more than 1 texture layer", desc.identifier().name)};
         }
 
+        if (!is_texture_data_type_supported(desc.format.data_type))
+        {
+            return {status_type::UNSUPPORTED, std::format("Texture '{0}' data type isn't supported by the driver", desc.identifier().name)};
+        }
+
+        if (is_texture_data_type_compressed(desc.format.data_type) && (has_msaa || desc.format.shape == texture_shape::_1D || desc.format.shape == texture_shape::_3D))
+        {
+            return {status_type::INVALID, std::format("Texture '{0}' has a compressed data type, which is only supported for 2D textures and cubemaps without MSAA", desc.identifier().name)};
+        }
+
         if (desc.format.shape == texture_shape::CUBE_MAP && num_texture_array_layers % 6 != 0)
         {
             return {status_type::INVALID, std::format("Texture '{0}' is a cubemap array texture, but number of texture layers is not a multiple of 6", desc.identifier().name)};
@@ -456,6 +603,7 @@ namespace stardraw::gl45
         ZoneScoped;
         if (mipmap_level >= num_texture_mipmap_levels) return {status_type::INVALID, std::format("Texture '{0}' does not contain specified mipmap level for image binding", texture_id.name)};
         if (array_layer >= num_texture_array_layers) return {status_type::INVALID, std::format("Texture '{0}' does not contain specified array layer for image binding", texture_id.name)};
+        if (is_texture_data_type_compressed(data_type)) return {status_type::INVALID, std::format("Texture '{0}' has a compressed data type, and can't be bound as an image", texture_id.name)};
 
         {
             ZoneScopedN("GL calls");
@@ -467,7 +615,9 @@ namespace stardraw::gl45
     bool texture_state::is_view_format_compatible(const GLenum source_format, const GLenum view_format)
     {
         ZoneScoped;
-        const std::array<std::vector<GLenum>, 12> compatible_sets = {
+        if (source_format == view_format) return true;
+
+        const std::array<std::vector<GLenum>, 31> compatible_sets = {
             std::vector<GLenum> {GL_RGBA32F, GL_RGBA32UI, GL_RGBA32I},
             {GL_RGB32F, GL_RGB32UI, GL_RGB32I},
             {GL_RGBA16F, GL_RG32F, GL_RGBA16UI, GL_RG32UI, GL_RGBA16I, GL_RG32I, GL_RGBA16, GL_RGBA16_SNORM},
@@ -479,7 +629,27 @@ namespace stardraw::gl45
             {GL_COMPRESSED_RED_RGTC1, GL_COMPRESSED_SIGNED_RED_RGTC1},
             {GL_COMPRESSED_RG_RGTC2, GL_COMPRESSED_SIGNED_RG_RGTC2},
             {GL_COMPRESSED_RGBA_BPTC_UNORM, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM},
-            {GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT}
+            {GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT},
+            {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT},
+            {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT},
+            {GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT},
+            {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT},
+            {GL_COMPRESSED_R11_EAC, GL_COMPRESSED_SIGNED_R11_EAC},
+            {GL_COMPRESSED_RG11_EAC, GL_COMPRESSED_SIGNED_RG11_EAC},
+            {GL_COMPRESSED_RGB8_ETC2, GL_COMPRESSED_SRGB8_ETC2},
+            {GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2},
+            {GL_COMPRESSED_RGBA8_ETC2_EAC, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC},
+            {GL_COMPRESSED_RGBA_ASTC_4x4_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR},
+            {GL_COMPRESSED_RGBA_ASTC_6x6_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR},
+            {GL_COMPRESSED_RGBA_ASTC_8x8_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR},
+            //Depth and stencil formats can only be viewed as themselves.
+            {GL_DEPTH_COMPONENT32F},
+            {GL_DEPTH_COMPONENT32},
+            {GL_DEPTH_COMPONENT24},
+            {GL_DEPTH_COMPONENT16},
+            {GL_DEPTH32F_STENCIL8},
+            {GL_DEPTH24_STENCIL8},
+            {GL_STENCIL_INDEX8},
         };
 
         const auto set_ptr = std::ranges::find_if(compatible_sets, [view_format](const std::vector<GLenum>& set)
@@ -535,9 +705,11 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status texture_state::set_sampling_config(const texture_sampling_conifg& config, const bool is_integer_texture) const
+    status texture_state::set_sampling_config(const texture_sampling_conifg& config, const bool is_integer_texture)
     {
         ZoneScoped;
+        //Kept so that streaming can move the base level as levels arrive without going below the configured minimum.
+        sampling_min_mipmap_level = config.mipmap_min_level;
 
         {
             ZoneScopedN("GL calls");
@@ -556,7 +728,9 @@ namespace stardraw::gl45
                 glTextureParameterf(gl_texture_id, GL_TEXTURE_MAX_ANISOTROPY, static_cast<float>(config.anisotropy_level));
             }
 
-            glTextureParameteri(gl_texture_id, GL_TEXTURE_BASE_LEVEL, config.mipmap_min_level);
+            //Streamed textures can't sample below their resident level, which starts at the smallest level.
+            const u32 resident_level = std::min(resident_mipmap_level, num_texture_mipmap_levels - 1);
+            glTextureParameteri(gl_texture_id, GL_TEXTURE_BASE_LEVEL, streamed ? std::max(sampling_min_mipmap_level, resident_level) : sampling_min_mipmap_level);
             glTextureParameteri(gl_texture_id, GL_TEXTURE_MAX_LEVEL, config.mipmap_max_level);
             glTextureParameterf(gl_texture_id, GL_TEXTURE_LOD_BIAS, config.mipmap_bias);
 
@@ -578,6 +752,11 @@ namespace stardraw::gl45
             return {status_type::RANGE_OVERFLOW, std::format("Mipmap level out of the bounds of the texture '{0}'", texture_id.name)};
         }
 
+        if (is_texture_data_type_compressed(data_type))
+        {
+            return {status_type::INVALID, std::format("Texture '{0}' has a compressed data type, and can't be cleared", texture_id.name)};
+        }
+
         {
             ZoneScopedN("GL calls");
             if (is_texture_data_type_integer(data_type))
@@ -16,10 +16,18 @@ namespace stardraw::gl45
         ~texture_state() override;
 
         [[nodiscard]] status unpack_pixels(u32 mipmap_level, u32 x, u32 y, u32 z, u32 width, u32 height, u32 depth, GLenum format, GLenum gl_data_type, u64 pbo_offset) const;
+        [[nodiscard]] status unpack_compressed_blocks(u32 mipmap_level, u32 x, u32 y, u32 layer, u32 width, u32 height, u32 layers, u64 bytes, u64 pbo_offset) const;
         [[nodiscard]] status copy_pixels(const texture_state* read_texture, const texture_copy_info& copy_info) const;
 
+        [[nodiscard]] status validate_upload(const texture_memory_transfer_info& info) const;
         [[nodiscard]] status prepare_upload(transfer_buffer_state* transfer_buffer, const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const;
-        [[nodiscard]] status flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle) const;
+        [[nodiscard]] status flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle);
+        ///Upload a validated region from a pixel buffer (or from client memory, if pixel_buffer_id is 0 and pbo_offset is a pointer).
+        [[nodiscard]] status unpack_region(const texture_memory_transfer_info& info, GLuint pixel_buffer_id, u64 pbo_offset) const;
+        [[nodiscard]] u64 compute_bytes_in_transfer(const texture_memory_transfer_info& info) const;
+
+        ///Advance the sampled base level of a streamed texture past any uploads the GPU has finished. Returns whether the texture is still streaming.
+        [[nodiscard]] bool update_streaming();
 
         [[nodiscard]] bool is_valid() const;
         [[nodiscard]] status bind_to_texture_slot(u32 slot) const;
@@ -27,7 +35,7 @@ namespace stardraw::gl45
         [[nodiscard]] static bool is_view_format_compatible(GLenum source_format, GLenum view_format);
         [[nodiscard]] static bool is_view_target_compatible(GLenum source_target, GLenum view_target);
         [[nodiscard]] status is_view_compatible(const texture& view_descriptor) const;
-        [[nodiscard]] status set_sampling_config(const texture_sampling_conifg& config, bool is_integer_texture) const;
+        [[nodiscard]] status set_sampling_config(const texture_sampling_conifg& config, bool is_integer_texture);
         [[nodiscard]] status clear(u32 mipmap_level, const clear_values& clear_values) const;
 
         [[nodiscard]] texture_shape get_shape() const;
@@ -46,13 +54,29 @@ namespace stardraw::gl45
 
         glm::vec<3, u32> size = {0, 0, 0};
         u32 num_texture_mipmap_levels = 0;
-        u32 bytes_per_pixel = 0;
+        texture_data_block data_block = {1, 1, 0};
 
         texture_shape shape = texture_shape::_2D;
         texture_data_type data_type = texture_data_type::R_U8_NORM;
         object_identifier texture_id;
+
+        bool streamed = false;
+        ///Lowest mipmap level of a streamed texture that can be sampled, or num_texture_mipmap_levels if no level has arrived yet.
+        u32 resident_mipmap_level = 0;
     private:
-        [[nodiscard]] u64 compute_bytes_in_transfer(const texture_memory_transfer_info& info) const;
+        ///A whole mipmap level upload to a streamed texture, which may not have finished on the GPU yet.
+        struct pending_mipmap_upload
+        {
+            u32 mipmap_level;
+            GLsync fence;
+        };
+
+        [[nodiscard]] bool is_whole_mipmap_level(const texture_memory_transfer_info& info) const;
+
+        std::vector<pending_mipmap_upload> pending_mipmap_uploads;
+        std::vector<bool> completed_mipmap_levels;
+        u32 sampling_min_mipmap_level = 0;
+
         status initalize_and_validate_texture_descriptor(const texture& desc);
     };
 }
@@ -0,0 +1,116 @@
+#include "program_binary_cache.hpp"
+
+#include <format>
+#include <fstream>
+#include <thread>
+
+#include "stardraw/internal/internal.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw::gl45
+{
+    static u64 hash_gl_string(const GLenum name, const u64 hash)
+    {
+        const GLubyte* string;
+        {
+            ZoneScopedN("GL calls");
+            string = glGetString(name);
+        }
+        if (string == nullptr) return hash;
+        return stable_hash(string, strlen(reinterpret_cast<const char*>(string)), hash);
+    }
+
+    void program_binary_cache::initialize(const std::filesystem::path& cache_directory)
+    {
+        ZoneScoped;
+        GLint format_count = 0;
+        {
+            ZoneScopedN("GL calls");
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        }
+
+        supported = format_count > 0;
+        driver_hash = hash_gl_string(GL_VERSION, hash_gl_string(GL_RENDERER, hash_gl_string(GL_VENDOR, STABLE_HASH_SEED)));
+        directory = cache_directory;
+
+        if (!directory.empty())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            if (error) directory.clear();
+        }
+    }
+
+    bool program_binary_cache::is_supported() const
+    {
+        return supported;
+    }
+
+    bool program_binary_cache::has_directory() const
+    {
+        return supported && !directory.empty();
+    }
+
+    u64 program_binary_cache::get_driver_hash() const
+    {
+        return driver_hash;
+    }
+
+    u64 program_binary_cache::hash_stages(const std::vector<shader_stage>& stages)
+    {
+        ZoneScoped;
+        u64 hash = STABLE_HASH_SEED;
+        for (const shader_stage& stage : stages)
+        {
+            if (stage.internal == nullptr) continue;
+            hash = stable_hash(&stage.internal->type, sizeof(shader_stage_type), hash);
+            hash = stable_hash(stage.internal->data, stage.internal->data_size, hash);
+            hash = stable_hash(stage.specialization_constants.data(), stage.specialization_constants.size() * sizeof(shader_specialization_constant), hash);
+        }
+        return hash;
+    }
+
+    bool program_binary_cache::load(const u64 spirv_hash, std::vector<u8>& out_data) const
+    {
+        ZoneScoped;
+        if (!has_directory()) return false;
+
+        std::ifstream file(path_for(spirv_hash), std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+
+        const std::streamsize size = file.tellg();
+        if (size < static_cast<std::streamsize>(sizeof(program_cache_header))) return false;
+
+        out_data.resize(size);
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(out_data.data()), size));
+    }
+
+    void program_binary_cache::store(const u64 spirv_hash, const std::vector<u8>& data) const
+    {
+        ZoneScoped;
+        if (!has_directory() || data.empty()) return;
+
+        //Write to a temporary file first so an interrupted write never leaves a truncated binary behind.
+        //The render and loader threads can store the same program at once, so each writes its own temporary file and the last rename wins.
+        const std::filesystem::path final_path = path_for(spirv_hash);
+        std::filesystem::path temp_path = final_path;
+        temp_path += std::format(".{0}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) return;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, final_path, error);
+        if (error) std::filesystem::remove(temp_path, error);
+    }
+
+    std::filesystem::path program_binary_cache::path_for(const u64 spirv_hash) const
+    {
+        return directory / std::format("{0:016x}-{1:016x}.glprog", spirv_hash, driver_hash);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+#include "common.hpp"
+#include "stardraw/api/shaders.hpp"
+
+namespace stardraw::gl45
+{
+    ///Header stored at the start of every cached program binary.
+    #pragma pack(push, 1)
+    struct program_cache_header
+    {
+        u32 magic;
+        u32 version;
+        u64 spirv_hash;
+        u64 driver_hash;
+        u32 binary_format;
+        u32 binary_size;
+        u32 has_compute_stage;
+        u32 binding_offset_count;
+        u32 slot_stage_mask_count;
+    };
+    #pragma pack(pop)
+
+    constexpr u32 PROGRAM_CACHE_MAGIC = 0x50445453; //'STDP'
+    constexpr u32 PROGRAM_CACHE_VERSION = 1;
+
+    ///Persistent storage for linked GL program binaries (glGetProgramBinary) so shaders can skip transpiling, compiling and linking.
+    ///Binaries are keyed by a hash of the SPIR-V (and specialization constants) for all stages, and are only valid for the exact driver (vendor / renderer / version) that produced them.
+    class program_binary_cache
+    {
+    public:
+        ///Must be called once GL is loaded. An empty directory disables the on-disk cache.
+        void initialize(const std::filesystem::path& cache_directory);
+
+        ///False if the driver doesn't support any program binary formats, in which case nothing will be cached.
+        [[nodiscard]] bool is_supported() const;
+        [[nodiscard]] bool has_directory() const;
+        [[nodiscard]] u64 get_driver_hash() const;
+
+        [[nodiscard]] static u64 hash_stages(const std::vector<shader_stage>& stages);
+
+        [[nodiscard]] bool load(u64 spirv_hash, std::vector<u8>& out_data) const;
+        void store(u64 spirv_hash, const std::vector<u8>& data) const;
+
+    private:
+        [[nodiscard]] std::filesystem::path path_for(u64 spirv_hash) const;
+
+        std::filesystem::path directory;
+        u64 driver_hash = 0;
+        bool supported = false;
+    };
+}
@@ -0,0 +1,88 @@
+#include "query_pool.hpp"
+
+#include <algorithm>
+
+namespace stardraw::gl45
+{
+    query_pool::~query_pool()
+    {
+        ZoneScoped;
+        for (const pending_query& query : pending_queries)
+        {
+            release(query.target, query.query_id);
+            if (query.end_query_id != 0) release(query.target, query.end_query_id);
+        }
+
+        {
+            ZoneScopedN("GL calls");
+            for (const auto& [target, queries] : free_queries)
+            {
+                glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+            }
+        }
+    }
+
+    GLuint query_pool::acquire(const GLenum target)
+    {
+        ZoneScoped;
+        std::vector<GLuint>& queries = free_queries[target];
+        if (!queries.empty())
+        {
+            const GLuint query_id = queries.back();
+            queries.pop_back();
+            return query_id;
+        }
+
+        GLuint query_id = 0;
+        {
+            ZoneScopedN("GL calls");
+            glCreateQueries(target, 1, &query_id);
+        }
+        return query_id;
+    }
+
+    void query_pool::release(const GLenum target, const GLuint query_id)
+    {
+        free_queries[target].push_back(query_id);
+    }
+
+    void query_pool::submit(const pending_query& query)
+    {
+        pending_queries.push_back(query);
+    }
+
+    bool query_pool::is_pending(const std::string& name, const pending_query_usage usage) const
+    {
+        return std::ranges::any_of(pending_queries, [&](const pending_query& query) { return query.usage == usage && query.name == name; });
+    }
+
+    void query_pool::collect(const std::function<void(const pending_query& query, u64 result)>& on_result)
+    {
+        ZoneScoped;
+        std::erase_if(pending_queries, [&](const pending_query& query)
+        {
+            ZoneScopedN("GL calls");
+            //Timestamp pairs finish in order, so only the end timestamp needs checking.
+            const GLuint last_query_id = query.end_query_id != 0 ? query.end_query_id : query.query_id;
+
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(last_query_id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE) return false;
+
+            u64 result = 0;
+            glGetQueryObjectui64v(query.query_id, GL_QUERY_RESULT, &result);
+
+            if (query.end_query_id != 0)
+            {
+                u64 end_result = 0;
+                glGetQueryObjectui64v(query.end_query_id, GL_QUERY_RESULT, &end_result);
+                result = end_result - result;
+                release(query.target, query.end_query_id);
+            }
+
+            release(query.target, query.query_id);
+            on_result(query, result);
+            return true;
+        });
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+
+namespace stardraw::gl45
+{
+    ///What a pending query's result is used for.
+    enum class pending_query_usage : u8
+    {
+        QUERY_RESULT, COMMAND_BUFFER_TIMING,
+    };
+
+    ///A query that has ended on the CPU side, but may not have finished on the GPU yet.
+    struct pending_query
+    {
+        std::string name;
+        pending_query_usage usage;
+        GLenum target;
+        GLuint query_id;
+        ///Only used for timestamp pairs (target GL_TIMESTAMP), in which case the result is the time between the two timestamps.
+        GLuint end_query_id = 0;
+    };
+
+    ///A query between its begin and end commands.
+    struct active_query
+    {
+        GLenum target;
+        GLuint query_id;
+    };
+
+    ///Pools GL query objects, so measuring every frame doesn't create and delete queries, and reads back their results without stalling.
+    ///Results are only read once GL_QUERY_RESULT_AVAILABLE is set, so they usually arrive a few frames after the query ends.
+    class query_pool
+    {
+    public:
+        query_pool() = default;
+        query_pool(const query_pool&) = delete;
+        query_pool& operator=(const query_pool&) = delete;
+        ~query_pool();
+
+        [[nodiscard]] GLuint acquire(GLenum target);
+        void release(GLenum target, GLuint query_id);
+
+        ///Track an ended query until its result is available.
+        void submit(const pending_query& query);
+
+        [[nodiscard]] bool is_pending(const std::string& name, pending_query_usage usage) const;
+
+        ///Pass every available result to on_result (in submission order) and return their queries to the pool. Never waits for the GPU.
+        void collect(const std::function<void(const pending_query& query, u64 result)>& on_result);
+
+    private:
+        std::unordered_map<GLenum, std::vector<GLuint>> free_queries;
+        std::vector<pending_query> pending_queries;
+    };
+}
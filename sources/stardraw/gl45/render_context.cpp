@@ -1,6 +1,7 @@
 #include "render_context.hpp"
 
 #include <format>
+#include <ranges>
 
 #include "api_conversion.hpp"
 #include "object_states/framebuffer_state.hpp"
@@ -24,7 +25,7 @@ namespace stardraw::gl45
         return has_loaded_glad;
     }
 
-    render_context::render_context(const render_context_config& config, status& out_status) : backend_validation_enabled(config.enable_backend_validation)
+    render_context::render_context(const render_context_config& config, status& out_status) : frames(config.frames_in_flight), mem_barrier_controller(config.framebuffer_region_barriers), backend_validation_enabled(config.enable_backend_validation), time_command_buffers(config.time_command_buffers)
     {
         ZoneScoped;
         out_status = status_type::SUCCESS;
@@ -34,6 +35,25 @@ namespace stardraw::gl45
             out_status = {status_type::BACKEND_ERROR, "Failed to initialize GL loader (GLAD) - try verifying the loader function you provided?"};
         }
 
+        if (!out_status.is_error())
+        {
+            shader_cache.initialize(config.shader_cache_directory);
+            native_spirv_shaders = config.native_spirv_shaders && GLAD_GL_ARB_gl_spirv;
+            indirect_count_draws = GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+
+            //Let the driver use as many threads as it likes for compiling shaders
+            if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            else if (GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+            if (config.gl_loader_context_make_current)
+            {
+                loader = std::make_unique<background_loader>(config, shader_cache, [this](const shader* descriptor, shader_state*& out_state)
+                {
+                    return build_shader_state(descriptor, out_state);
+                });
+            }
+        }
+
         validation_message_callback = config.validation_message_callback;
         if (config.enable_backend_validation)
         {
@@ -43,6 +63,16 @@ namespace stardraw::gl45
         TracyGpuContext;
     }
 
+    render_context::~render_context()
+    {
+        ZoneScoped;
+        //Occlusion queries (and queries that never ended) keep their query objects, so hand them back for the pool to delete.
+        for (const active_query& query : occlusion_queries | std::views::values) queries.release(query.target, query.query_id);
+        for (const active_query& query : active_queries | std::views::values) queries.release(query.target, query.query_id);
+        occlusion_queries.clear();
+        active_queries.clear();
+    }
+
     [[nodiscard]] status render_context::execute_command_buffer(const std::string_view& name)
     {
         ZoneScoped;
@@ -50,10 +80,39 @@ namespace stardraw::gl45
         if (!command_lists.contains(std::string(name))) return status_type::UNKNOWN;
         const command_list& refren = command_lists[std::string(name)];
 
+        pending_query timing = {std::string(name), pending_query_usage::COMMAND_BUFFER_TIMING, GL_TIMESTAMP, 0, 0};
+        if (time_command_buffers)
+        {
+            timing.query_id = queries.acquire(GL_TIMESTAMP);
+            timing.end_query_id = queries.acquire(GL_TIMESTAMP);
+            ZoneScopedN("GL calls");
+            glQueryCounter(timing.query_id, GL_TIMESTAMP);
+        }
+
         for (const starlib::polymorphic<command>& cmd : refren)
         {
             const status result = execute_command(cmd.ptr());
-            if (result.is_error()) return result;
+            if (result.is_error())
+            {
+                if (time_command_buffers)
+                {
+                    queries.release(GL_TIMESTAMP, timing.query_id);
+                    queries.release(GL_TIMESTAMP, timing.end_query_id);
+                }
+                return result;
+            }
+        }
+
+        const status pass_status = end_framebuffer_pass();
+        if (pass_status.is_error()) return pass_status;
+
+        if (time_command_buffers)
+        {
+            {
+                ZoneScopedN("GL calls");
+                glQueryCounter(timing.end_query_id, GL_TIMESTAMP);
+            }
+            queries.submit(timing);
         }
 
         return status_from_last_gl_error();
@@ -68,6 +127,9 @@ namespace stardraw::gl45
             if (result.is_error()) return result;
         }
 
+        const status pass_status = end_framebuffer_pass();
+        if (pass_status.is_error()) return pass_status;
+
         return status_from_last_gl_error();
     }
 
@@ -90,12 +152,23 @@ namespace stardraw::gl45
     [[nodiscard]] status render_context::create_objects(const descriptor_list&& descriptors)
     {
         ZoneScoped;
+        //Objects are created in order, but compiling shaders waits until the whole list is created, so their (slow) compilation overlaps.
+        std::vector<shader_state*> pending_shaders;
+        status create_status = status_type::SUCCESS;
         for (const starlib::polymorphic<descriptor>& descriptor : descriptors)
         {
-            const status create_status = create_object(descriptor.ptr());
-            if (create_status.is_error()) return create_status;
+            create_status = create_object(descriptor.ptr());
+            if (create_status.is_error()) break;
+            if (descriptor.ptr()->type() != descriptor_type::SHADER) continue;
+
+            shader_state* state = find_object_state<shader_state, descriptor_type::SHADER>(descriptor.ptr()->identifier());
+            if (state != nullptr && state->needs_transpile()) pending_shaders.push_back(state);
         }
 
+        //Shaders created before a failure stay in the context, so they're compiled either way.
+        compile_shader_states(pending_shaders);
+        if (create_status.is_error()) return create_status;
+
         return status_from_last_gl_error();
     }
 
@@ -108,33 +181,241 @@ namespace stardraw::gl45
 
         delete objects[type][identifier.hash];
         objects[type].erase(identifier.hash);
+        mem_barrier_controller.forget(identifier);
 
         return status_from_last_gl_error();
     }
 
-    [[nodiscard]] signal_status render_context::check_signal(const std::string_view& name)
+    [[nodiscard]] u64 render_context::completed_signal_value() const
+    {
+        return signals.completed_value();
+    }
+
+    [[nodiscard]] u64 render_context::last_signal_value() const
+    {
+        return signals.signalled_value();
+    }
+
+    [[nodiscard]] signal_status render_context::check_signal(const u64 value)
     {
         ZoneScoped;
-        return wait_signal(name, 0);
+        return wait_signal(value, 0);
     }
 
-    [[nodiscard]] signal_status render_context::wait_signal(const std::string_view& name, const u64 timeout)
+    [[nodiscard]] status render_context::get_shader_cache_data(const std::string_view& name, std::vector<u8>& out_data)
     {
         ZoneScoped;
-        if (!signals.contains(std::string(name)))
+        shader_state* shader;
+        const status find_status = find_shader_state(object_identifier(name), &shader);
+        if (find_status.is_error()) return find_status;
+        return shader->get_cache_data(shader_cache, out_data);
+    }
+
+    [[nodiscard]] shader_status render_context::check_shader(const std::string_view& name)
+    {
+        ZoneScoped;
+        shader_state* shader = find_object_state<shader_state, descriptor_type::SHADER>(object_identifier(name));
+        if (shader == nullptr) return shader_status::UNKNOWN_SHADER;
+        return shader->poll_compile(shader_cache, false);
+    }
+
+    [[nodiscard]] barrier_statistics render_context::get_barrier_statistics() const
+    {
+        return mem_barrier_controller.statistics();
+    }
+
+    void render_context::reset_barrier_statistics()
+    {
+        mem_barrier_controller.reset_statistics();
+    }
+
+    [[nodiscard]] query_status render_context::get_query_result(const std::string_view& name, u64& out_result)
+    {
+        ZoneScoped;
+        collect_query_results();
+
+        const std::string query_name = std::string(name);
+        if (query_results.contains(query_name))
         {
-            return signal_status::UNKNOWN_SIGNAL;
+            out_result = query_results[query_name];
+            return query_status::AVAILABLE;
         }
 
-        const signal_state& state = signals[std::string(name)];
-        const GLenum status = glClientWaitSync(state.sync_point, 0, timeout);
-        switch (status)
+        if (active_queries.contains(query_name) || queries.is_pending(query_name, pending_query_usage::QUERY_RESULT)) return query_status::PENDING;
+        return query_status::UNKNOWN_QUERY;
+    }
+
+    [[nodiscard]] std::unordered_map<std::string, command_buffer_timing> render_context::get_command_buffer_timings()
+    {
+        ZoneScoped;
+        collect_query_results();
+        return command_buffer_timings;
+    }
+
+    void render_context::reset_command_buffer_timings()
+    {
+        command_buffer_timings.clear();
+    }
+
+    [[nodiscard]] std::vector<frame_statistics> render_context::collect_frame_statistics()
+    {
+        ZoneScoped;
+        return frames.collect();
+    }
+
+    status render_context::get_texture_resident_level(const std::string_view& name, u32& out_level)
+    {
+        ZoneScoped;
+        texture_state* texture;
+        const status find_status = find_texture_state(object_identifier(name), &texture);
+        if (find_status.is_error()) return find_status;
+
+        out_level = texture->streamed ? texture->resident_mipmap_level : 0;
+        return status_type::SUCCESS;
+    }
+
+    status render_context::load_objects_async(const std::string_view& name, background_load&& load)
+    {
+        ZoneScoped;
+        if (loader == nullptr) return {status_type::UNSUPPORTED, "Background loading needs a loader context (see render_context_config::gl_loader_context_make_current)"};
+
+        const std::string load_name = std::string(name);
+        if (background_loads.contains(load_name)) return {status_type::DUPLICATE, std::format("A background load named '{0}' hasn't been checked since it was queued", name)};
+
+        //Variant libraries aren't thread safe, so variants are resolved here and the loader thread only sees plain stages.
+        for (starlib::polymorphic<descriptor>& descriptor : load.descriptors)
+        {
+            if (descriptor.ptr()->type() != descriptor_type::SHADER) continue;
+            const shader* shader_descriptor = dynamic_cast<const shader*>(descriptor.ptr());
+            if (shader_descriptor->variant_library == nullptr) continue;
+
+            shader resolved = *shader_descriptor;
+            resolved.variant_library = nullptr;
+            const status variant_status = shader_descriptor->variant_library->get_variant(shader_descriptor->variant, graphics_api::GL45, resolved.stages);
+            if (variant_status.is_error()) return variant_status;
+            descriptor = resolved;
+        }
+
+        const status queue_status = loader->queue(load_name, std::move(load));
+        if (queue_status.is_error()) return queue_status;
+
+        background_loads[load_name] = std::nullopt;
+        return status_type::SUCCESS;
+    }
+
+    status render_context::check_load(const std::string_view& name, load_status& out_status)
+    {
+        ZoneScoped;
+        publish_background_loads();
+
+        const auto load_ptr = background_loads.find(std::string(name));
+        if (load_ptr == background_loads.end())
+        {
+            out_status = load_status::UNKNOWN_LOAD;
+            return {status_type::UNKNOWN, std::format("No background load named '{0}'", name)};
+        }
+
+        if (!load_ptr->second.has_value())
         {
-            case GL_ALREADY_SIGNALED: return signal_status::SIGNALLED;
-            case GL_TIMEOUT_EXPIRED: return signal_status::TIMED_OUT;
-            case GL_CONDITION_SATISFIED: return signal_status::SIGNALLED;
-            default: return signal_status::NOT_SIGNALLED;
+            out_status = load_status::PENDING;
+            return status_type::SUCCESS;
         }
+
+        const status result = load_ptr->second.value();
+        background_loads.erase(load_ptr);
+        out_status = result.is_error() ? load_status::FAILED : load_status::COMPLETE;
+        return result;
+    }
+
+    void render_context::publish_background_loads()
+    {
+        ZoneScoped;
+        if (loader == nullptr) return;
+
+        loader->collect([this](finished_load& load)
+        {
+            status publish_status = load.result;
+            u32 recorded_count = 0;
+            std::vector<std::pair<descriptor_type, std::string>> deferred_objects;
+
+            if (!publish_status.is_error())
+            {
+                for (const auto& [identifier, state] : load.states)
+                {
+                    publish_status = record_object_state(identifier, state);
+                    if (publish_status.is_error()) break;
+                    recorded_count++;
+                }
+            }
+
+            if (!publish_status.is_error())
+            {
+                for (const starlib::polymorphic<descriptor>& descriptor : load.deferred_descriptors)
+                {
+                    publish_status = create_object(descriptor.ptr());
+                    if (publish_status.is_error()) break;
+                    deferred_objects.emplace_back(descriptor.ptr()->type(), descriptor.ptr()->identifier().name);
+                }
+            }
+
+            //A load is published whole or not at all.
+            if (publish_status.is_error())
+            {
+                for (const auto& [type, name] : deferred_objects)
+                {
+                    (void)delete_object(type, name);
+                }
+
+                for (u32 state_idx = 0; state_idx < load.states.size(); state_idx++)
+                {
+                    const auto& [identifier, state] = load.states[state_idx];
+                    if (state_idx < recorded_count) objects[state->object_type()].erase(identifier.hash);
+                    delete state;
+                }
+            }
+
+            background_loads[load.name] = publish_status;
+        });
+    }
+
+    void render_context::update_texture_streaming()
+    {
+        ZoneScoped;
+        std::erase_if(streaming_textures, [this](const object_identifier& identifier)
+        {
+            texture_state* texture = find_object_state<texture_state, descriptor_type::TEXTURE>(identifier);
+            return texture == nullptr || !texture->update_streaming();
+        });
+    }
+
+    void render_context::collect_query_results()
+    {
+        ZoneScoped;
+        queries.collect([this](const pending_query& query, const u64 result)
+        {
+            switch (query.usage)
+            {
+                case pending_query_usage::QUERY_RESULT:
+                {
+                    query_results[query.name] = result;
+                    break;
+                }
+                case pending_query_usage::COMMAND_BUFFER_TIMING:
+                {
+                    command_buffer_timing& timing = command_buffer_timings[query.name];
+                    timing.last_nanos = result;
+                    timing.total_nanos += result;
+                    timing.executions++;
+                    break;
+                }
+            }
+        });
+    }
+
+    [[nodiscard]] signal_status render_context::wait_signal(const u64 value, const u64 timeout)
+    {
+        ZoneScoped;
+        return signals.wait(value, timeout);
     }
 
 
@@ -168,8 +449,16 @@ namespace stardraw::gl45
             case command_type::CLEAR_WINDOW: return execute_clear_window(dynamic_cast<const clear_window*>(cmd));
             case command_type::CLEAR_FRAMEBUFFER: return execute_clear_framebuffer(dynamic_cast<const clear_framebuffer*>(cmd));
             case command_type::CLEAR_TEXTURE: return execute_clear_texture(dynamic_cast<const clear_texture*>(cmd));
+            case command_type::GENERATE_MIPMAPS: return execute_generate_mipmaps(dynamic_cast<const generate_mipmaps*>(cmd));
             case command_type::CONFIG_SHADER: return execute_shader_parameters_upload(dynamic_cast<const configure_shader*>(cmd));
             case command_type::SIGNAL: return execute_signal(dynamic_cast<const signal*>(cmd));
+            case command_type::MEMORY_BARRIER: return execute_memory_barrier(dynamic_cast<const memory_barrier*>(cmd));
+            case command_type::BEGIN_QUERY: return execute_begin_query(dynamic_cast<const begin_query*>(cmd));
+            case command_type::END_QUERY: return execute_end_query(dynamic_cast<const end_query*>(cmd));
+            case command_type::BEGIN_OCCLUSION_QUERY: return execute_begin_occlusion_query(dynamic_cast<const begin_occlusion_query*>(cmd));
+            case command_type::END_OCCLUSION_QUERY: return execute_end_occlusion_query(dynamic_cast<const end_occlusion_query*>(cmd));
+            case command_type::BEGIN_CONDITIONAL_RENDER: return execute_begin_conditional_render(dynamic_cast<const begin_conditional_render*>(cmd));
+            case command_type::END_CONDITIONAL_RENDER: return execute_end_conditional_render(dynamic_cast<const end_conditional_render*>(cmd));
             case command_type::PRESENT: return execute_present(dynamic_cast<const present*>(cmd));
             case command_type::COMPUTE_DISPATCH: return execute_compute_dispatch(dynamic_cast<const dispatch_compute*>(cmd));
             case command_type::COMPUTE_DISPATCH_INDIRECT: return execute_compute_dispatch_indirect(dynamic_cast<const dispatch_compute_indirect*>(cmd));
@@ -247,10 +536,12 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status render_context::find_shader_state(const object_identifier& identifier, shader_state** out_state) {
+    status render_context::find_shader_state(const object_identifier& identifier, shader_state** out_state, const bool require_ready) {
         *out_state = find_object_state<shader_state, descriptor_type::SHADER>(identifier);
         if (*out_state == nullptr) return { status_type::UNKNOWN, std::format("No shader with name '{0}' in context", identifier.name) };
-        if (!(*out_state)->is_valid()) return{ status_type::INVALID, std::format("Shader '{0}' is in an invalid state", identifier.name) };
+        if (require_ready) (void)(*out_state)->poll_compile(shader_cache, true);
+        if ((*out_state)->get_status() == shader_status::FAILED) return (*out_state)->get_compile_status();
+        if (require_ready && !(*out_state)->is_valid()) return{ status_type::INVALID, std::format("Shader '{0}' is in an invalid state", identifier.name) };
         return status_type::SUCCESS;
     }
 
@@ -1,4 +1,6 @@
 #pragma once
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 
@@ -9,6 +11,11 @@
 #include "object_states/texture_sampler_state.hpp"
 #include "object_states/texture_state.hpp"
 #include "object_states/vertex_specification_state.hpp"
+#include "background_loader.hpp"
+#include "fence_timeline.hpp"
+#include "frame_pacer.hpp"
+#include "mipmap_generator.hpp"
+#include "query_pool.hpp"
 #include "stardraw/api/render_context.hpp"
 
 namespace stardraw::gl45
@@ -21,15 +28,32 @@ namespace stardraw::gl45
     {
     public:
         explicit render_context(const render_context_config& config, status& out_status);
+        ~render_context() override;
         [[nodiscard]] status execute_command_buffer(const std::string_view& name) override;
         [[nodiscard]] status execute_command_buffer(const command_list&& commands) override;
         [[nodiscard]] status create_command_buffer(const std::string_view& name, const command_list&& commands) override;
         [[nodiscard]] status delete_command_buffer(const std::string_view& name) override;
         [[nodiscard]] status create_objects(const descriptor_list&& descriptors) override;
         [[nodiscard]] status delete_object(const descriptor_type type, const std::string_view& name) override;
+        [[nodiscard]] status get_shader_cache_data(const std::string_view& name, std::vector<u8>& out_data) override;
+        [[nodiscard]] shader_status check_shader(const std::string_view& name) override;
 
-        [[nodiscard]] signal_status check_signal(const std::string_view& name) override;
-        [[nodiscard]] signal_status wait_signal(const std::string_view& name, u64 timeout) override;
+        [[nodiscard]] u64 completed_signal_value() const override;
+        [[nodiscard]] u64 last_signal_value() const override;
+        [[nodiscard]] signal_status check_signal(u64 value) override;
+        [[nodiscard]] signal_status wait_signal(u64 value, u64 timeout) override;
+
+        [[nodiscard]] barrier_statistics get_barrier_statistics() const override;
+        void reset_barrier_statistics() override;
+
+        [[nodiscard]] query_status get_query_result(const std::string_view& name, u64& out_result) override;
+        [[nodiscard]] std::unordered_map<std::string, command_buffer_timing> get_command_buffer_timings() override;
+        void reset_command_buffer_timings() override;
+        [[nodiscard]] std::vector<frame_statistics> collect_frame_statistics() override;
+        [[nodiscard]] status get_texture_resident_level(const std::string_view& name, u32& out_level) override;
+
+        [[nodiscard]] status load_objects_async(const std::string_view& name, background_load&& load) override;
+        [[nodiscard]] status check_load(const std::string_view& name, load_status& out_status) override;
 
         [[nodiscard]] status prepare_buffer_memory_transfer(const buffer_memory_transfer_info& info, memory_transfer_handle*& out_handle) override;
         [[nodiscard]] status flush_buffer_memory_transfer(memory_transfer_handle* handle) override;
@@ -57,16 +81,26 @@ namespace stardraw::gl45
         [[nodiscard]] static status execute_clear_window(const clear_window* cmd);
         [[nodiscard]] status execute_clear_framebuffer(const clear_framebuffer* cmd);
         [[nodiscard]] status execute_clear_texture(const clear_texture* cmd);
+        [[nodiscard]] status execute_generate_mipmaps(const generate_mipmaps* cmd);
         [[nodiscard]] status execute_compute_dispatch(const dispatch_compute* cmd);
         [[nodiscard]] status execute_compute_dispatch_indirect(const dispatch_compute_indirect* cmd);
-        [[nodiscard]] status execute_present(const present* cmd) const;
+        [[nodiscard]] status execute_present(const present* cmd);
         [[nodiscard]] status execute_aquire(const aquire* cmd) const;
         [[nodiscard]] status execute_shader_parameters_upload(const configure_shader* cmd);
         [[nodiscard]] status execute_signal(const signal* cmd);
+        [[nodiscard]] status execute_memory_barrier(const memory_barrier* cmd);
+        [[nodiscard]] status execute_begin_query(const begin_query* cmd);
+        [[nodiscard]] status execute_end_query(const end_query* cmd);
+        [[nodiscard]] status execute_begin_occlusion_query(const begin_occlusion_query* cmd);
+        [[nodiscard]] status execute_end_occlusion_query(const end_occlusion_query* cmd);
+        [[nodiscard]] status execute_begin_conditional_render(const begin_conditional_render* cmd);
+        [[nodiscard]] status execute_end_conditional_render(const end_conditional_render* cmd);
 
         [[nodiscard]] status create_object(const descriptor* descriptor);
         [[nodiscard]] status create_buffer_state(const buffer* descriptor);
         [[nodiscard]] status create_shader_state(const shader* descriptor);
+        [[nodiscard]] status build_shader_state(const shader* descriptor, shader_state*& out_state) const;
+        void compile_shader_states(const std::vector<shader_state*>& pending_shaders);
         [[nodiscard]] status create_texture_state(const texture* descriptor);
         [[nodiscard]] status create_texture_sampler_state(const sampler* descriptor);
         [[nodiscard]] status create_framebuffer_state(const framebuffer* descriptor);
@@ -83,10 +117,18 @@ namespace stardraw::gl45
         [[nodiscard]] status bind_shader_buffer_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value);
         [[nodiscard]] status bind_shader_data_parameter(shader_state* shader, const shader_parameter_location& location, shader_parameter_value& value);
 
+        [[nodiscard]] status find_indirect_count_buffer(const std::optional<object_identifier>& count_buffer, u64 count_address, buffer_state** out_state);
+        [[nodiscard]] GLsizei read_indirect_draw_count(const buffer_state* count_state, u64 count_address, u32 max_draw_count) const;
+
         [[nodiscard]] status find_and_validate_attachment_texture(const framebuffer_attachment_info& attachment, u32& lowest_msaa_level, u32& highest_msaa_level, bool& any_texture_layered, bool& any_texture_not_layered, texture_state** texture_out);
 
         [[nodiscard]] status record_object_state(const object_identifier& identifier, object_state* state);
         [[nodiscard]] status status_from_last_gl_error() const;
+        [[nodiscard]] u64 active_framebuffer_hash() const;
+        void collect_query_results();
+        void update_texture_streaming();
+        void publish_background_loads();
+        [[nodiscard]] status end_framebuffer_pass();
 
         template <typename state_type, descriptor_type object_type>
         [[nodiscard]] state_type* find_object_state(const object_identifier& identifier)
@@ -107,7 +149,7 @@ namespace stardraw::gl45
         }
 
         [[nodiscard]] status find_buffer_state(const object_identifier& identifier, buffer_state** out_state);
-        [[nodiscard]] status find_shader_state(const object_identifier& identifier, shader_state** out_state);
+        [[nodiscard]] status find_shader_state(const object_identifier& identifier, shader_state** out_state, bool require_ready = true);
         [[nodiscard]] status find_root_texture_state(const object_identifier& identifier, texture_state** out_state);
         [[nodiscard]] status find_texture_state(const object_identifier& identifier, texture_state** out_state);
         [[nodiscard]] status find_texture_sampler_state(const object_identifier& identifier, texture_sampler_state** out_state);
@@ -121,12 +163,38 @@ namespace stardraw::gl45
 
         std::unordered_map<std::string, command_list> command_lists;
         std::unordered_map<descriptor_type, std::unordered_map<u64, object_state*>> objects;
-        std::unordered_map<std::string, signal_state> signals;
+        fence_timeline signals;
+        frame_pacer frames;
         std::unordered_map<memory_transfer_handle*, buffer_memory_transfer_info> buffer_transfers;
         std::unordered_map<memory_transfer_handle*, texture_memory_transfer_info> texture_transfers;
+        std::vector<object_identifier> streaming_textures;
         memory_barrier_controller mem_barrier_controller;
+        query_pool queries;
+        mipmap_generator mipmaps;
+        std::unordered_map<std::string, active_query> active_queries;
+        std::unordered_map<std::string, u64> query_results;
+        std::unordered_map<std::string, command_buffer_timing> command_buffer_timings;
+        std::unordered_map<std::string, active_query> occlusion_queries;
+        std::optional<object_identifier> active_occlusion_query;
+        bool conditional_render_active = false;
+        program_binary_cache shader_cache;
+        ///Only created if the config provides a loader context. Declared after the shader cache, which it uses.
+        std::unique_ptr<background_loader> loader;
+        ///Result of each background load, or nullopt while it's pending.
+        std::unordered_map<std::string, std::optional<status>> background_loads;
         draw_specification_state* active_draw_specification = nullptr;
+
+        ///A framebuffer pass started by configure_draw with pass actions, whose store actions are applied when it ends.
+        struct framebuffer_pass
+        {
+            object_identifier framebuffer;
+            framebuffer_pass_actions actions;
+        };
+        std::optional<framebuffer_pass> active_pass;
         bool backend_validation_enabled;
+        bool native_spirv_shaders = false;
+        bool indirect_count_draws = false;
+        bool time_command_buffers = false;
         std::function<void(const std::string message)> validation_message_callback;
     };
 }
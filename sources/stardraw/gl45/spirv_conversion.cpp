@@ -0,0 +1,259 @@
+#include "spirv_conversion.hpp"
+
+#include <algorithm>
+#include <format>
+#include <spirv_glsl.hpp>
+
+#include "stardraw/internal/internal.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw::gl45
+{
+    static std::vector<spirv_cross::Resource> get_resources_with_binding_sets(const spirv_cross::ShaderResources& resources)
+    {
+        std::vector<spirv_cross::Resource> resources_with_binding_sets;
+        resources_with_binding_sets.append_range(resources.sampled_images);
+        resources_with_binding_sets.append_range(resources.separate_images);
+        resources_with_binding_sets.append_range(resources.separate_samplers);
+        resources_with_binding_sets.append_range(resources.uniform_buffers);
+        resources_with_binding_sets.append_range(resources.storage_buffers);
+        resources_with_binding_sets.append_range(resources.storage_images);
+        resources_with_binding_sets.append_range(resources.atomic_counters);
+        return resources_with_binding_sets;
+    }
+
+    static void count_bindings_per_set(const spirv_cross::Compiler& compiler, const std::vector<spirv_cross::Resource>& resources, std::vector<u32>& bindings_per_set)
+    {
+        for (const spirv_cross::Resource& resource : resources)
+        {
+            const u32 descriptor_set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+            const u32 binding_index = compiler.get_decoration(resource.id, spv::DecorationBinding);
+            if (descriptor_set >= bindings_per_set.size()) bindings_per_set.resize(descriptor_set + 1);
+            bindings_per_set[descriptor_set] = std::max(bindings_per_set[descriptor_set], binding_index + 1);
+        }
+    }
+
+    //GL has no descriptor sets, so the bindings of each set are laid out one after the other.
+    static std::vector<u32> get_descriptor_set_binding_offsets(const std::vector<u32>& bindings_per_set)
+    {
+        std::vector<u32> binding_offsets(bindings_per_set.size());
+
+        u32 binding_offset = 0;
+        for (u32 idx = 0; idx < bindings_per_set.size(); idx++)
+        {
+            binding_offsets[idx] = binding_offset;
+            binding_offset += bindings_per_set[idx];
+        }
+
+        return binding_offsets;
+    }
+
+    status patch_spirv_bindings(const std::vector<shader_stage>& stages, const std::string_view& shader_name, std::vector<spirv_stage_binary>& out_binaries, gl_binding_layout& out_layout, bool& out_supported)
+    {
+        ZoneScopedN("Patch Slang spirv bindings for opengl");
+        out_supported = true;
+        for (const shader_stage& stage : stages)
+        {
+            if (stage.internal == nullptr) return {status_type::UNEXPECTED, std::format("A provided shader stage for shader '{0}' is invalid!", shader_name)};
+            if (stage.internal->api != graphics_api::GL45) return {status_type::INVALID, std::format("A provided shader stage for shader '{0}' is non-GL45!", shader_name)};
+        }
+
+        struct stage_reflection
+        {
+            spirv_cross::Compiler compiler;
+            std::vector<spirv_cross::Resource> resources_with_binding_sets;
+        };
+
+        std::vector<std::unique_ptr<stage_reflection>> stage_reflections;
+
+        try
+        {
+            std::vector<u32> bindings_per_set;
+
+            for (const shader_stage& stage : stages)
+            {
+                stage_reflection* reflection = stage_reflections.emplace_back(new stage_reflection {spirv_cross::Compiler(static_cast<const u32*>(stage.internal->data), stage.internal->data_size / sizeof(u32)), {}}).get();
+                const spirv_cross::ShaderResources resources = reflection->compiler.get_shader_resources();
+
+                //GL can't consume separate images / samplers or push constants from SPIR-V - those need SPIRV-Cross to rewrite them as GLSL.
+                if (!resources.separate_images.empty() || !resources.separate_samplers.empty() || !resources.push_constant_buffers.empty())
+                {
+                    out_supported = false;
+                    return status_type::SUCCESS;
+                }
+
+                reflection->resources_with_binding_sets = get_resources_with_binding_sets(resources);
+                count_bindings_per_set(reflection->compiler, reflection->resources_with_binding_sets, bindings_per_set);
+            }
+
+            out_layout.descriptor_set_binding_offsets = get_descriptor_set_binding_offsets(bindings_per_set);
+
+            for (u32 idx = 0; idx < stage_reflections.size(); idx++)
+            {
+                const stage_reflection* reflection = stage_reflections[idx].get();
+                const u32* data = static_cast<const u32*>(stages[idx].internal->data);
+                std::vector<u32> words(data, data + stages[idx].internal->data_size / sizeof(u32));
+
+                const spirv_cross::SmallVector<spirv_cross::EntryPoint> entry_points = reflection->compiler.get_entry_points_and_stages();
+                if (entry_points.empty()) return {status_type::INVALID, std::format("A provided shader stage for shader '{0}' has no entry point!", shader_name)};
+
+                //Same flattening as the transpile path, but done by patching the decoration literals in place.
+                const u32 stage_bit = 1u << static_cast<u32>(stages[idx].internal->type);
+                for (const spirv_cross::Resource& resource : reflection->resources_with_binding_sets)
+                {
+                    const u32 descriptor_set = reflection->compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+                    const u32 binding_index = reflection->compiler.get_decoration(resource.id, spv::DecorationBinding);
+                    const u32 flattened_binding = binding_index + out_layout.descriptor_set_binding_offsets[descriptor_set];
+                    out_layout.slot_stage_masks[flattened_binding] |= stage_bit;
+
+                    u32 word_offset;
+                    if (reflection->compiler.get_binary_offset_for_decoration(resource.id, spv::DecorationBinding, word_offset)) words[word_offset] = flattened_binding;
+                    if (reflection->compiler.get_binary_offset_for_decoration(resource.id, spv::DecorationDescriptorSet, word_offset)) words[word_offset] = 0;
+                }
+
+                spirv_stage_binary& binary = out_binaries.emplace_back(std::move(words), std::span<const u32>(), entry_points[0].name);
+                binary.code = binary.words;
+
+                //glSpecializeShader rejects ids the module doesn't declare, so only pass the constants the stage actually has.
+                for (const spirv_cross::SpecializationConstant& constant : reflection->compiler.get_specialization_constants())
+                {
+                    const auto value = std::ranges::find(stages[idx].specialization_constants, constant.constant_id, &shader_specialization_constant::id);
+                    if (value == stages[idx].specialization_constants.end()) continue;
+                    binary.constant_ids.push_back(value->id);
+                    binary.constant_values.push_back(value->value_bits);
+                }
+            }
+        }
+        catch (std::exception& _)
+        {
+            return {status_type::BACKEND_ERROR, std::format("Failed to patch SPIR-V bindings for shader '{0}'", shader_name)};
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status transpile_spirv_to_glsl(const std::vector<shader_stage>& stages, const std::string_view& shader_name, std::vector<std::string>& out_sources, gl_binding_layout& out_layout)
+    {
+        ZoneScopedN("Convert Slang spirv to opengl-compatible GLSL");
+        for (const shader_stage& stage : stages)
+        {
+            if (stage.internal == nullptr) return {status_type::UNEXPECTED, std::format("A provided shader stage for shader '{0}' is invalid!", shader_name)};
+            if (stage.internal->api != graphics_api::GL45) return {status_type::INVALID, std::format("A provided shader stage for shader '{0}' is non-GL45!", shader_name)};
+        }
+
+        struct stage_compiler
+        {
+            spirv_cross::CompilerGLSL compiler;
+            std::vector<spirv_cross::Resource> resources_with_binding_sets;
+        };
+
+        std::vector<stage_compiler*> stage_compilers;
+        status result_status = status_type::SUCCESS;
+
+        constexpr spirv_cross::CompilerGLSL::Options options = spirv_cross::CompilerGLSL::Options {
+            .version = 450,
+            .enable_storage_image_qualifier_deduction = false,
+        };
+
+        try
+        {
+            for (const shader_stage& stage : stages)
+            {
+                stage_compilers.push_back(new stage_compiler {spirv_cross::CompilerGLSL(static_cast<const u32*>(stage.internal->data), stage.internal->data_size / sizeof(u32)), {}});
+            }
+
+            std::vector<u32> bindings_per_set;
+
+            for (stage_compiler* stage : stage_compilers)
+            {
+                stage->compiler.set_common_options(options);
+
+                stage->resources_with_binding_sets = get_resources_with_binding_sets(stage->compiler.get_shader_resources());
+                count_bindings_per_set(stage->compiler, stage->resources_with_binding_sets, bindings_per_set);
+            }
+
+            out_layout.descriptor_set_binding_offsets = get_descriptor_set_binding_offsets(bindings_per_set);
+
+            for (u32 idx = 0; idx < stage_compilers.size(); idx++)
+            {
+                stage_compiler* stage = stage_compilers[idx];
+                const u32 stage_bit = 1u << static_cast<u32>(stages[idx].internal->type);
+                for (const spirv_cross::Resource& resource : stage->resources_with_binding_sets)
+                {
+                    const u32 descriptor_set = stage->compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+                    const u32 binding_index = stage->compiler.get_decoration(resource.id, spv::DecorationBinding);
+                    const u32 flattened_binding = binding_index + out_layout.descriptor_set_binding_offsets[descriptor_set];
+                    stage->compiler.unset_decoration(resource.id, spv::DecorationDescriptorSet);
+                    stage->compiler.set_decoration(resource.id, spv::DecorationBinding, flattened_binding);
+                    out_layout.slot_stage_masks[flattened_binding] |= stage_bit;
+                }
+
+                //Handle merging sampler states with samplers where possible, transfer binding and name from original sampler.
+                stage->compiler.build_combined_image_samplers();
+                for (const spirv_cross::CombinedImageSampler& combined : stage->compiler.get_combined_image_samplers())
+                {
+                    const std::string tex_name = stage->compiler.get_name(combined.image_id);
+                    const u32 binding = stage->compiler.get_decoration(combined.image_id, spv::Decoration::DecorationBinding);
+                    stage->compiler.set_decoration(combined.combined_id, spv::Decoration::DecorationBinding, binding);
+                    stage->compiler.set_name(combined.combined_id, tex_name);
+                }
+
+                //Overriding the default value is enough, since specialization constants are emitted as macros defaulting to the constant's value.
+                for (const spirv_cross::SpecializationConstant& constant : stage->compiler.get_specialization_constants())
+                {
+                    const auto value = std::ranges::find(stages[idx].specialization_constants, constant.constant_id, &shader_specialization_constant::id);
+                    if (value == stages[idx].specialization_constants.end()) continue;
+                    stage->compiler.get_constant(constant.id).m.c[0].r[0].u32 = value->value_bits;
+                }
+
+                stage->compiler.set_common_options({.version = 450, .emit_push_constant_as_uniform_buffer = true});
+
+                const std::string source = stage->compiler.compile();
+                if (source.empty())
+                {
+                    result_status = {status_type::BACKEND_ERROR, std::format("Failed to transpile SPIR-V into OpenGL compatible GLSL for shader '{0}'", shader_name)};
+                    break;
+                }
+
+                out_sources.push_back(source);
+            }
+        }
+        catch (std::exception& _)
+        {
+            result_status = {status_type::BACKEND_ERROR, std::format("Failed to transpile SPIR-V into OpenGL compatible GLSL for shader '{0}'", shader_name)};
+        }
+
+        for (const stage_compiler* stage : stage_compilers)
+        {
+            delete stage;
+        }
+
+        return result_status;
+    }
+
+    status precompile_program(const std::vector<shader_stage>& stages, const std::string_view& shader_name, precompiled_program_output& out_output)
+    {
+        ZoneScoped;
+        gl_binding_layout layout;
+        const status transpile_status = transpile_spirv_to_glsl(stages, shader_name, out_output.sources, layout);
+        if (transpile_status.is_error()) return transpile_status;
+
+        out_output.binding_offsets = std::move(layout.descriptor_set_binding_offsets);
+        out_output.slot_stage_masks = std::move(layout.slot_stage_masks);
+
+        //Patching only succeeds for stages that use the same resources as the transpiled GLSL, so both share the flattened layout above.
+        std::vector<spirv_stage_binary> binaries;
+        gl_binding_layout patched_layout;
+        bool supported = false;
+        const status patch_status = patch_spirv_bindings(stages, shader_name, binaries, patched_layout, supported);
+        if (patch_status.is_error() || !supported) return status_type::SUCCESS;
+
+        for (const spirv_stage_binary& binary : binaries)
+        {
+            out_output.binaries.emplace_back(binary.code.begin(), binary.code.end());
+            out_output.entry_points.push_back(binary.entry_point);
+        }
+
+        return status_type::SUCCESS;
+    }
+}
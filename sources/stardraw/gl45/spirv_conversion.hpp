@@ -0,0 +1,44 @@
+#pragma once
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "stardraw/api/shaders.hpp"
+
+namespace stardraw
+{
+    struct precompiled_program_output;
+}
+
+namespace stardraw::gl45
+{
+    ///GL has no descriptor sets, so the bindings of each set are laid out one after the other.
+    struct gl_binding_layout
+    {
+        std::vector<u32> descriptor_set_binding_offsets;
+        std::unordered_map<u32, u32> slot_stage_masks; //Bitmask of (1 << shader_stage_type) for each stage that uses a binding slot
+    };
+
+    ///SPIR-V for a single stage, ready to be passed to glShaderBinary / glSpecializeShader.
+    struct spirv_stage_binary
+    {
+        ///Storage for patched code. Empty if the code lives elsewhere (for instance, in a shader archive).
+        std::vector<u32> words;
+        std::span<const u32> code;
+        std::string entry_point;
+        std::vector<GLuint> constant_ids;
+        std::vector<GLuint> constant_values;
+    };
+
+    ///Transpile SPIR-V stages into GLSL with flattened bindings. Makes no GL calls, so it's safe to call from any thread.
+    [[nodiscard]] status transpile_spirv_to_glsl(const std::vector<shader_stage>& stages, const std::string_view& shader_name, std::vector<std::string>& out_sources, gl_binding_layout& out_layout);
+
+    ///Patch the bindings of SPIR-V stages in place so GL can load them directly. Makes no GL calls, so it's safe to call from any thread.
+    ///out_supported is false if the stages use features that GL can't load from SPIR-V, in which case they need transpiling instead.
+    [[nodiscard]] status patch_spirv_bindings(const std::vector<shader_stage>& stages, const std::string_view& shader_name, std::vector<spirv_stage_binary>& out_binaries, gl_binding_layout& out_layout, bool& out_supported);
+
+    ///Transpile and patch stages ahead of time for a shader archive. Binaries are left empty if GL can't load the stages as SPIR-V.
+    [[nodiscard]] status precompile_program(const std::vector<shader_stage>& stages, const std::string_view& shader_name, precompiled_program_output& out_output);
+}
@@ -120,9 +120,9 @@ namespace stardraw::gl45
         const u32 actual_slot = binding_info.slot + shader->descriptor_set_binding_offsets[binding_info.set];
 
         //To bind a sampler, we make sure the location is *explicitly* pointed at the texture variable, not something contained inside the texture.
-        if (binding_info.binding_type_ptr != location.internal->offset_ptr)
+        if (!binding_info.is_binding)
         {
-            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a sampler bound to it!", location.internal->path_string)};
+            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a sampler bound to it!", location.path())};
         }
 
         texture_sampler_state* sampler;
@@ -139,18 +139,18 @@ namespace stardraw::gl45
         const u32 actual_slot = binding_info.slot + shader->descriptor_set_binding_offsets[binding_info.set];
 
         //To bind a texture, we make sure the location is *explicitly* pointed at the texture variable, not something contained inside the texture.
-        if (binding_info.binding_type_ptr != location.internal->offset_ptr)
+        if (!binding_info.is_binding)
         {
-            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.internal->path_string)};
+            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.path())};
         }
 
         texture_shape resource_shape;
 
-        switch (binding_info.binding_type_ptr->getKind())
+        switch (binding_info.binding_kind)
         {
             case slang::TypeReflection::Kind::Resource:
             {
-                const u32 shape = binding_info.binding_type_ptr->getResourceShape() & ~SlangResourceShape::SLANG_TEXTURE_COMBINED_FLAG;
+                const u32 shape = binding_info.binding_shape & ~SlangResourceShape::SLANG_TEXTURE_COMBINED_FLAG;
                 switch (shape)
                 {
                     case SlangResourceShape::SLANG_TEXTURE_1D_ARRAY:
@@ -178,24 +178,24 @@ namespace stardraw::gl45
                     }
                     default:
                     {
-                        return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.internal->path_string)};
+                        return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.path())};
                     }
                 }
                 break;
             }
             default:
             {
-                return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.internal->path_string)};
+                return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a texture bound to it!", location.path())};
             }
         }
 
         texture_state* texture;
         status find_status = find_texture_state(value.opaque_reference, &texture);
         if (find_status.is_error()) return find_status;
-        if (texture->get_shape() != resource_shape) return {status_type::INVALID, std::format("Texture object '{0}' can't be bound to location '{1}' - wrong texture shape!", value.opaque_reference.name, location.internal->path_string)};
+        if (texture->get_shape() != resource_shape) return {status_type::INVALID, std::format("Texture object '{0}' can't be bound to location '{1}' - wrong texture shape!", value.opaque_reference.name, location.path())};
 
         status bind_status = status_type::SUCCESS;
-        const SlangResourceAccess access = binding_info.binding_type_ptr->getResourceAccess();
+        const SlangResourceAccess access = binding_info.binding_access;
         GLenum gl_access = GL_READ_WRITE;
         if (access == SLANG_RESOURCE_ACCESS_READ) gl_access = GL_READ_ONLY;
         else if (access == SLANG_RESOURCE_ACCESS_WRITE) gl_access = GL_WRITE_ONLY;
@@ -210,7 +210,9 @@ namespace stardraw::gl45
         }
 
         if (bind_status.is_error()) return bind_status;
-        shader->bound_objects[actual_slot] = {value.opaque_reference, as_image && gl_access != GL_READ_ONLY, GL_TEXTURE_FETCH_BARRIER_BIT};
+        const GLbitfield read_barrier = as_image ? GL_SHADER_IMAGE_ACCESS_BARRIER_BIT : GL_TEXTURE_FETCH_BARRIER_BIT;
+        const GLbitfield write_barriers = (as_image && gl_access != GL_READ_ONLY) ? TEXTURE_WRITE_BARRIER_BITS : 0;
+        shader->bound_objects[actual_slot] = {value.opaque_reference, write_barriers, read_barrier, shader->is_fragment_only_slot(actual_slot)};
         return status_type::SUCCESS;
     }
 
@@ -223,12 +225,12 @@ namespace stardraw::gl45
         SlangResourceAccess access;
 
         //To bind a buffer, we make sure the location is *explicitly* pointed at the buffer variable, not something contained inside the buffer.
-        if (binding_info.binding_type_ptr != location.internal->offset_ptr)
+        if (!binding_info.is_binding)
         {
-            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a buffer bound to it!", location.internal->path_string)};
+            return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a buffer bound to it!", location.path())};
         }
 
-        switch (binding_info.binding_type_ptr->getKind())
+        switch (binding_info.binding_kind)
         {
             case slang::TypeReflection::Kind::ParameterBlock:
             case slang::TypeReflection::Kind::ConstantBuffer:
@@ -247,8 +249,8 @@ namespace stardraw::gl45
 
             case slang::TypeReflection::Kind::Resource:
             {
-                const SlangResourceShape shape = binding_info.binding_type_ptr->getResourceShape();
-                access = binding_info.binding_type_ptr->getResourceAccess();
+                const SlangResourceShape shape = binding_info.binding_shape;
+                access = binding_info.binding_access;
                 if (shape == SLANG_STRUCTURED_BUFFER || shape == SLANG_BYTE_ADDRESS_BUFFER)
                 {
                     binding_type = GL_SHADER_STORAGE_BUFFER;
@@ -258,7 +260,7 @@ namespace stardraw::gl45
             }
             default:
             {
-                return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a buffer bound to it!", location.internal->path_string)};
+                return {status_type::INVALID, std::format("The shader parameter location '{0}' cannot have a buffer bound to it!", location.path())};
             }
         }
 
@@ -268,8 +270,8 @@ namespace stardraw::gl45
 
         status bind_status = buffer->bind_to_slot(binding_type, actual_slot);
         const GLbitfield read_barrier = (binding_type == GL_SHADER_STORAGE_BUFFER ? GL_SHADER_STORAGE_BARRIER_BIT : GL_UNIFORM_BARRIER_BIT);
-        const bool has_write_access = access != SLANG_RESOURCE_ACCESS_READ;
-        shader->bound_objects[actual_slot] = {value.opaque_reference, has_write_access, read_barrier};
+        const GLbitfield write_barriers = access != SLANG_RESOURCE_ACCESS_READ ? BUFFER_WRITE_BARRIER_BITS : 0;
+        shader->bound_objects[actual_slot] = {value.opaque_reference, write_barriers, read_barrier, shader->is_fragment_only_slot(actual_slot)};
         if (bind_status.is_error()) return bind_status;
         return status_type::SUCCESS;
     }
@@ -282,7 +284,7 @@ namespace stardraw::gl45
 
         if (!shader->bound_objects.contains(actual_slot))
         {
-            return {status_type::INVALID, std::format("Can't apply shader parameter value; the shader does not have a buffer bound to store data at '{0}'", location.internal->path_string)};
+            return {status_type::INVALID, std::format("Can't apply shader parameter value; the shader does not have a buffer bound to store data at '{0}'", location.path())};
         }
 
         const std::string implicit_buffer_id = "<implicit shader parameter transfer buffer>";
@@ -312,6 +314,6 @@ namespace stardraw::gl45
             if (create_status.is_error()) return create_status;
         }
 
-        return transfer_buffer_memory_immediate({shader->bound_objects[actual_slot].identifier, object_identifier(implicit_buffer_id), location.internal->byte_address, value.bytes.size(), buffer_memory_transfer_info::type::UPLOAD_TRANSFER_BUFFER}, value.bytes.data());
+        return transfer_buffer_memory_immediate({shader->bound_objects[actual_slot].identifier, object_identifier(implicit_buffer_id), binding_info.byte_address, value.bytes.size(), buffer_memory_transfer_info::type::UPLOAD_TRANSFER_BUFFER}, value.bytes.data());
     }
 }
@@ -0,0 +1,135 @@
+#include <format>
+
+#include "../api/indirect_culling.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    static constexpr std::string_view culling_shader_source = R"(
+struct culling_constants
+{
+    float4 frustum_planes[6];
+    uint instance_count;
+};
+
+ConstantBuffer<culling_constants> constants;
+StructuredBuffer<float4> instance_bounds;
+StructuredBuffer<uint> source_commands;
+RWStructuredBuffer<uint> output_commands;
+RWStructuredBuffer<uint> draw_count;
+
+[shader("compute")]
+[numthreads(1, 1, 1)]
+void reset_count()
+{
+    draw_count[0] = 0;
+}
+
+[shader("compute")]
+[numthreads(GROUP_SIZE, 1, 1)]
+void cull_instances(uint3 thread_id : SV_DispatchThreadID)
+{
+    const uint instance = thread_id.x;
+    if (instance >= constants.instance_count) return;
+
+    const float4 bounds = instance_bounds[instance];
+    for (uint plane = 0; plane < 6; plane++)
+    {
+        if (dot(constants.frustum_planes[plane].xyz, bounds.xyz) + constants.frustum_planes[plane].w < -bounds.w) return;
+    }
+
+    uint slot;
+    InterlockedAdd(draw_count[0], 1, slot);
+    for (uint word = 0; word < COMMAND_WORDS; word++)
+    {
+        output_commands[slot * COMMAND_WORDS + word] = source_commands[instance * COMMAND_WORDS + word];
+    }
+}
+)";
+
+    static std::string reset_shader_name(const std::string_view& name)
+    {
+        return std::format("<indirect culling '{0}' count reset>", name);
+    }
+
+    static status create_compute_stage(const shader_compiler_context* compiler, const shader_module& module, const std::string_view& entry_point_name, const graphics_api& api, shader_stage& out_stage)
+    {
+        ZoneScoped;
+        const shader_entry_point entry_point = {module, std::string(entry_point_name)};
+
+        shader_program program;
+        const status link_status = compiler->link_shader_program({entry_point}, program);
+        if (link_status.is_error()) return link_status;
+
+        return compiler->create_shader_stage(program, entry_point, api, out_stage);
+    }
+
+    status indirect_culling_shader::create(const shader_compiler_context* compiler, const graphics_api& api, const bool indexed, indirect_culling_shader& out_shader)
+    {
+        ZoneScoped;
+        if (compiler == nullptr) return {status_type::INVALID, "Indirect culling shader requires a compiler context"};
+
+        out_shader.indexed = indexed;
+        const std::vector<shader_macro> macros = {
+            {"GROUP_SIZE", std::to_string(group_size)},
+            {"COMMAND_WORDS", std::to_string(out_shader.command_size() / sizeof(u32))},
+        };
+
+        shader_module module;
+        const status load_status = compiler->load_shader_module(culling_shader_source, macros, module);
+        if (load_status.is_error()) return load_status;
+
+        const status reset_status = create_compute_stage(compiler, module, "reset_count", api, out_shader.reset_stage);
+        if (reset_status.is_error()) return reset_status;
+
+        return create_compute_stage(compiler, module, "cull_instances", api, out_shader.cull_stage);
+    }
+
+    descriptor_list indirect_culling_shader::descriptors(const std::string_view& name) const
+    {
+        ZoneScoped;
+        shader cull_shader = shader(name, {cull_stage});
+        cull_shader.buffer_layouts.push_back(indirect_culling_constants_layout::for_buffer("constants"));
+
+        descriptor_list result;
+        result.push_back(shader(reset_shader_name(name), {reset_stage}));
+        result.push_back(cull_shader);
+        return result;
+    }
+
+    status indirect_culling_shader::record(const std::string_view& name, const indirect_culling_config& config, command_list& out_commands) const
+    {
+        ZoneScoped;
+        if (cull_stage.internal == nullptr) return {status_type::INVALID, "Indirect culling shader has not been created"};
+
+        const std::string reset_name = reset_shader_name(name);
+        out_commands.push_back(configure_shader(reset_name, {
+            {reset_stage.locate("draw_count"), shader_parameter_value::buffer(config.count_buffer.name)},
+        }));
+        out_commands.push_back(dispatch_compute(reset_name, 1, 1, 1));
+
+        if (config.instance_count == 0) return status_type::SUCCESS;
+
+        const shader_parameter_location constants = cull_stage.locate("constants");
+        out_commands.push_back(configure_shader(name, {
+            {constants, shader_parameter_value::buffer(config.constants_buffer.name)},
+            {constants.field("frustum_planes"), shader_parameter_value::vectors<4>(config.frustum_planes)},
+            {constants.field("instance_count"), shader_parameter_value::vector(config.instance_count)},
+            {cull_stage.locate("instance_bounds"), shader_parameter_value::buffer(config.instance_bounds_buffer.name)},
+            {cull_stage.locate("source_commands"), shader_parameter_value::buffer(config.source_commands_buffer.name)},
+            {cull_stage.locate("output_commands"), shader_parameter_value::buffer(config.output_commands_buffer.name)},
+            {cull_stage.locate("draw_count"), shader_parameter_value::buffer(config.count_buffer.name)},
+        }));
+        out_commands.push_back(dispatch_compute(name, (config.instance_count + group_size - 1) / group_size, 1, 1));
+
+        return status_type::SUCCESS;
+    }
+
+    u32 indirect_culling_shader::command_size() const
+    {
+        //Matches the GL / Vulkan indirect command structures: 5 words for indexed draws, 4 otherwise.
+        return (indexed ? 5 : 4) * sizeof(u32);
+    }
+}
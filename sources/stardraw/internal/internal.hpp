@@ -1,5 +1,7 @@
 #pragma once
 #include <slang.h>
+#include <span>
+#include <unordered_map>
 
 #include "internal.hpp"
 #include "stardraw/api/shaders.hpp"
@@ -12,40 +14,132 @@ namespace stardraw
     {
         i64 set;
         i64 slot;
-        //The binding type that the location exists inside
+        //Kind, shape and access of the binding type that the location exists inside
         //May not always be the same as the actual variable the location references -
         //for instance, for plain data, it will be the containing buffer variable.
-        slang::TypeLayoutReflection* binding_type_ptr;
+        slang::TypeReflection::Kind binding_kind;
+        SlangResourceShape binding_shape;
+        SlangResourceAccess binding_access;
+        //True if the location references the binding variable itself, rather than something inside it.
+        bool is_binding;
+        //Offset of the location within the containing buffer, for plain data.
+        u64 byte_address;
     };
 
-    struct shader_parameter_location::shader_parameter_location_internal
+    struct transparent_string_hash
     {
-        slang::VariableLayoutReflection* root_ptr = nullptr;
-        slang::TypeLayoutReflection* offset_ptr = nullptr;
-        u64 root_idx = 0;
-        u64 byte_address = 0;
-        u64 binding_range = 0;
-        u64 binding_range_index = 0;
-        std::string path_string = "???";
-        bool is_valid = true;
-        bool operator==(const shader_parameter_location_internal&) const = default;
+        using is_transparent = void;
+        std::size_t operator()(const std::string_view& string) const noexcept
+        {
+            return std::hash<std::string_view>()(string);
+        }
+    };
+
+    typedef std::unordered_map<std::string, u32, transparent_string_hash, std::equal_to<>> reflection_name_map;
+
+    //Entries only hold plain values (no Slang reflection pointers), so they can be stored in and loaded from shader archives.
+    struct shader_reflection_entry
+    {
+        std::string path;
+        slang::TypeReflection::Kind binding_kind;
+        SlangResourceShape binding_shape;
+        SlangResourceAccess binding_access;
+        bool is_binding;
+        i64 set;
+        i64 slot;
+        u64 byte_address;
+        u64 size;
+
+        //Entry for the first element, if the location is array-like
+        u32 element_entry = u32_max;
+        u32 element_count = 0;
+        u64 element_stride = 0;
+
+        reflection_name_map fields;
     };
 
+    struct shader_buffer_info
+    {
+        //-1 for unsized buffers
+        i64 size;
+        memory_layout_info layout;
+    };
+
+    struct shader_reflection_index
+    {
+        std::vector<shader_reflection_entry> entries;
+        reflection_name_map roots;
+        std::unordered_map<std::string, shader_buffer_info, transparent_string_hash, std::equal_to<>> buffers;
+    };
+
+    ///Backend data for all the stages of a program, prepared ahead of time by a shader archive so backends can skip converting SPIR-V.
+    ///Per-stage data points into the archive's memory mapping.
+    struct precompiled_program_data
+    {
+        //GL has no descriptor sets, so the bindings of each set are laid out one after the other.
+        std::vector<u32> gl45_binding_offsets;
+        std::unordered_map<u32, u32> gl45_slot_stage_masks;
+
+        std::vector<std::string_view> gl45_sources;
+        //SPIR-V with flattened bindings, empty for stages GL can't load as SPIR-V.
+        std::vector<std::span<const u32>> gl45_spirv;
+        std::vector<std::string_view> gl45_entry_points;
+    };
+
+    ///Backend data generated for a program's stages when writing a shader archive. Read back into precompiled_program_data when the archive is opened.
+    struct precompiled_program_output
+    {
+        std::vector<u32> binding_offsets;
+        std::unordered_map<u32, u32> slot_stage_masks;
+
+        //Per stage, or empty if the backend has nothing of that kind to precompile.
+        std::vector<std::string> sources;
+        std::vector<std::vector<u32>> binaries;
+        std::vector<std::string> entry_points;
+    };
+
+    ///Generate the backend data for a program whose stages all target the same API. APIs with nothing to precompile leave the output empty.
+    ///Dispatches to the backend the same way render contexts are created, so API-level code never depends on a backend directly.
+    [[nodiscard]] status precompile_shader_program(const graphics_api& api, const std::vector<shader_stage>& stages, const std::string_view& program_name, precompiled_program_output& out_output);
+
     struct shader_stage::shader_stage_internal
     {
         void* data;
-        slang::ShaderReflection* reflection;
+        const shader_reflection_index* parameters;
         u32 data_size;
         shader_stage_type type;
         graphics_api api;
 
+        //Set for stages loaded from a shader archive, in which case the data is owned by the archive.
+        const precompiled_program_data* precompiled = nullptr;
+        u32 precompiled_index = 0;
+
         ~shader_stage_internal()
         {
-            free(data);
+            if (precompiled == nullptr) free(data);
         }
     };
 
     binding_location_info vk_binding_for_location(const shader_parameter_location& location);
+
+    constexpr u64 STABLE_HASH_SEED = 0xcbf29ce484222325;
+
+    ///FNV-1a, used instead of std::hash where hashes need to be stable between runs and builds (for instance, on-disk cache keys).
+    inline u64 stable_hash(const void* data, const u64 size, u64 hash = STABLE_HASH_SEED)
+    {
+        const u8* bytes = static_cast<const u8*>(data);
+        for (u64 idx = 0; idx < size; idx++)
+        {
+            hash ^= bytes[idx];
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
+
+    inline u64 stable_hash(const std::string_view& string, const u64 hash = STABLE_HASH_SEED)
+    {
+        return stable_hash(string.data(), string.size(), hash);
+    }
 }
 
 template <>
@@ -53,7 +147,7 @@ struct std::hash<stardraw::shader_parameter_location>
 {
     std::size_t operator()(const stardraw::shader_parameter_location& key) const noexcept
     {
-        return hash<starlib::u32>()(key.internal->binding_range_index + key.internal->binding_range + key.internal->byte_address + key.internal->root_idx);
+        return hash<const void*>()(key.reflection) ^ hash<starlib::u64>()((static_cast<starlib::u64>(key.entry) << 32 | key.array_index) + key.element_offset);
     }
 };
 
@@ -0,0 +1,119 @@
+#include "mapped_file.hpp"
+
+#include <format>
+
+#include "tracy/Tracy.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stardraw
+{
+    mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+#ifdef _WIN32
+    status mapped_file::open(const std::filesystem::path& path)
+    {
+        ZoneScoped;
+        close();
+
+        file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+        {
+            file_handle = nullptr;
+            return {status_type::UNKNOWN, std::format("Couldn't open file '{0}'", path.string())};
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+        {
+            close();
+            return {status_type::INVALID, std::format("Couldn't map file '{0}' - it's empty or its size can't be read", path.string())};
+        }
+
+        mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle != nullptr) mapping = static_cast<const u8*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+        if (mapping == nullptr)
+        {
+            close();
+            return {status_type::BACKEND_ERROR, std::format("Couldn't map file '{0}'", path.string())};
+        }
+
+        mapped_size = file_size.QuadPart;
+        return status_type::SUCCESS;
+    }
+
+    void mapped_file::close()
+    {
+        ZoneScoped;
+        if (mapping != nullptr) UnmapViewOfFile(mapping);
+        if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+        if (file_handle != nullptr) CloseHandle(file_handle);
+
+        mapping = nullptr;
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+        mapped_size = 0;
+    }
+#else
+    status mapped_file::open(const std::filesystem::path& path)
+    {
+        ZoneScoped;
+        close();
+
+        file_descriptor = ::open(path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) return {status_type::UNKNOWN, std::format("Couldn't open file '{0}'", path.string())};
+
+        struct stat file_info {};
+        if (fstat(file_descriptor, &file_info) != 0 || file_info.st_size == 0)
+        {
+            close();
+            return {status_type::INVALID, std::format("Couldn't map file '{0}' - it's empty or its size can't be read", path.string())};
+        }
+
+        void* address = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            close();
+            return {status_type::BACKEND_ERROR, std::format("Couldn't map file '{0}'", path.string())};
+        }
+
+        mapping = static_cast<const u8*>(address);
+        mapped_size = file_info.st_size;
+        return status_type::SUCCESS;
+    }
+
+    void mapped_file::close()
+    {
+        ZoneScoped;
+        if (mapping != nullptr) munmap(const_cast<u8*>(mapping), mapped_size);
+        if (file_descriptor >= 0) ::close(file_descriptor);
+
+        mapping = nullptr;
+        file_descriptor = -1;
+        mapped_size = 0;
+    }
+#endif
+
+    const u8* mapped_file::data() const
+    {
+        return mapping;
+    }
+
+    u64 mapped_file::size() const
+    {
+        return mapped_size;
+    }
+}
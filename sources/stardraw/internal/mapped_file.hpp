@@ -0,0 +1,37 @@
+#pragma once
+#include <filesystem>
+
+#include "starlib/general/status.hpp"
+#include "starlib/general/stdint.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    ///Read-only memory mapping of a whole file. Pages are only read from disk when they're first touched.
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        ~mapped_file();
+
+        [[nodiscard]] status open(const std::filesystem::path& path);
+        void close();
+
+        [[nodiscard]] const u8* data() const;
+        [[nodiscard]] u64 size() const;
+
+    private:
+        const u8* mapping = nullptr;
+        u64 mapped_size = 0;
+
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#else
+        int file_descriptor = -1;
+#endif
+    };
+}
@@ -1,42 +1,155 @@
 #include "../api/memory_transfer.hpp"
 
+#include <cstring>
+
 #include "tracy/Tracy.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define STARDRAW_LAYOUT_SSE2 1
+#endif
+
 namespace stardraw
 {
     using namespace starlib;
-    void* layout_memory(const memory_layout_info& layout, const void* data, const u64 data_size)
+
+    memory_layout_plan plan_memory_layout(const memory_layout_info& layout)
     {
         ZoneScoped;
-        if (data == nullptr) return nullptr;
-        if (layout.packed_size == 0 || layout.padded_size == 0) return nullptr;
+        memory_layout_plan plan {layout.packed_size, layout.padded_size, {}};
 
-        const u64 element_count = data_size / layout.packed_size;
-        const u8* in_bytes = static_cast<const u8*>(data);
-        u8* output = static_cast<u8*>(malloc(layout.padded_size * element_count));
-        if (layout.padded_size == layout.packed_size)
+        u64 packed_offset = 0;
+        u64 padded_offset = 0;
+
+        for (const memory_layout_info::pad& pad : layout.pads)
         {
-            memcpy(output, in_bytes, layout.padded_size * element_count);
-            return output;
+            if (pad.address > padded_offset)
+            {
+                plan.runs.push_back({packed_offset, padded_offset, pad.address - padded_offset});
+                packed_offset += pad.address - padded_offset;
+            }
+            padded_offset = pad.address + pad.size;
         }
 
-        for (u64 idx = 0; idx < element_count; idx++)
+        //Data after the last pad still needs copying.
+        if (padded_offset < layout.padded_size && packed_offset < layout.packed_size)
+        {
+            plan.runs.push_back({packed_offset, padded_offset, layout.packed_size - packed_offset});
+        }
+
+        return plan;
+    }
+
+    static void copy_bytes(u8* destination, const u8* source, const u64 size)
+    {
+        //Constant sizes let the compiler replace the memcpy with a couple of moves.
+        switch (size)
+        {
+            case 4: memcpy(destination, source, 4); return;
+            case 8: memcpy(destination, source, 8); return;
+            case 12: memcpy(destination, source, 12); return;
+            case 16: memcpy(destination, source, 16); return;
+            default: memcpy(destination, source, size);
+        }
+    }
+
+    template <u64 size>
+    static void copy_strided(u8* destination, const u8* source, const u64 count, const u64 destination_stride, const u64 source_stride)
+    {
+        for (u64 idx = 0; idx < count; idx++)
+        {
+            memcpy(destination + idx * destination_stride, source + idx * source_stride, size);
+        }
+    }
+
+    ///vec3 -> vec4 style strides. Copies whole 16 byte blocks, so every element but the last also writes (or reads) 4 bytes past its data.
+    ///That's only ever padding in the destination, or the start of the next element which is overwritten straight after.
+    static void copy_12_bytes_strided(u8* destination, const u8* source, const u64 count, const u64 destination_stride, const u64 source_stride)
+    {
+        if (count == 0) return;
+#ifdef STARDRAW_LAYOUT_SSE2
+        //Only the last element can touch memory outside of the source or destination, unless both strides already cover 16 bytes.
+        const u64 block_count = source_stride >= 16 && destination_stride >= 16 ? count : count - 1;
+
+        for (u64 idx = 0; idx < block_count; idx++)
+        {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + idx * source_stride));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + idx * destination_stride), value);
+        }
+
+        copy_strided<12>(destination + block_count * destination_stride, source + block_count * source_stride, count - block_count, destination_stride, source_stride);
+        return;
+#endif
+        copy_strided<12>(destination, source, count, destination_stride, source_stride);
+    }
+
+    ///Runs the copy plan in either direction. to_padded selects packed -> padded (layout) or padded -> packed (readback).
+    static void execute_plan(const memory_layout_plan& plan, const u8* source, u8* destination, const u64 element_count, const bool to_padded)
+    {
+        ZoneScoped;
+        const u64 source_stride = to_padded ? plan.packed_size : plan.padded_size;
+        const u64 destination_stride = to_padded ? plan.padded_size : plan.packed_size;
+
+        if (plan.packed_size == plan.padded_size)
+        {
+            memcpy(destination, source, plan.packed_size * element_count);
+            return;
+        }
+
+        //Single runs at the start of each element (vec3 -> vec4, a struct with only trailing padding, etc) get their own strided kernels.
+        if (plan.runs.size() == 1 && plan.runs[0].packed_offset == 0 && plan.runs[0].padded_offset == 0)
         {
-            const u64 base_read_address = layout.packed_size * idx;
-            const u64 base_write_address = layout.padded_size * idx;
+            switch (plan.runs[0].size)
+            {
+                case 4: copy_strided<4>(destination, source, element_count, destination_stride, source_stride); return;
+                case 8: copy_strided<8>(destination, source, element_count, destination_stride, source_stride); return;
+                case 12: copy_12_bytes_strided(destination, source, element_count, destination_stride, source_stride); return;
+                case 16: copy_strided<16>(destination, source, element_count, destination_stride, source_stride); return;
+                default: break;
+            }
+        }
 
-            u64 current_write_offset = 0;
-            u64 current_read_offset = 0;
+        for (u64 idx = 0; idx < element_count; idx++)
+        {
+            const u8* element_source = source + idx * source_stride;
+            u8* element_destination = destination + idx * destination_stride;
 
-            for (const memory_layout_info::pad& pad : layout.pads)
+            for (const memory_layout_plan::copy_run& run : plan.runs)
             {
-                const u64 size_to_pad_start = pad.address - current_write_offset;
-                memcpy(output + base_write_address + current_write_offset, in_bytes + base_read_address + current_read_offset, size_to_pad_start);
-                current_write_offset = pad.address + pad.size;
-                current_read_offset += size_to_pad_start;
+                const u64 source_offset = to_padded ? run.packed_offset : run.padded_offset;
+                const u64 destination_offset = to_padded ? run.padded_offset : run.packed_offset;
+                copy_bytes(element_destination + destination_offset, element_source + source_offset, run.size);
             }
         }
+    }
 
+    void* layout_memory(const memory_layout_info& layout, const void* data, const u64 data_size)
+    {
+        ZoneScoped;
+        if (data == nullptr) return nullptr;
+        if (layout.packed_size == 0 || layout.padded_size == 0) return nullptr;
+
+        const u64 element_count = data_size / layout.packed_size;
+        void* output = malloc(layout.padded_size * element_count);
+        layout_memory(plan_memory_layout(layout), data, data_size, output);
         return output;
     }
+
+    void layout_memory(const memory_layout_plan& plan, const void* data, const u64 data_size, void* destination)
+    {
+        ZoneScoped;
+        if (data == nullptr || destination == nullptr) return;
+        if (plan.packed_size == 0 || plan.padded_size == 0) return;
+
+        execute_plan(plan, static_cast<const u8*>(data), static_cast<u8*>(destination), data_size / plan.packed_size, true);
+    }
+
+    void pack_memory(const memory_layout_plan& plan, const void* padded_data, const u64 padded_data_size, void* destination)
+    {
+        ZoneScoped;
+        if (padded_data == nullptr || destination == nullptr) return;
+        if (plan.packed_size == 0 || plan.padded_size == 0) return;
+
+        execute_plan(plan, static_cast<const u8*>(padded_data), static_cast<u8*>(destination), padded_data_size / plan.padded_size, false);
+    }
 }
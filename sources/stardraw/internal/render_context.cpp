@@ -1,4 +1,5 @@
 #include "stardraw/gl45/render_context.hpp"
+#include "stardraw/gl45/spirv_conversion.hpp"
 
 namespace stardraw
 {
@@ -26,4 +27,14 @@ namespace stardraw
 
         return out_status;
     }
+
+    status precompile_shader_program(const graphics_api& api, const std::vector<shader_stage>& stages, const std::string_view& program_name, precompiled_program_output& out_output)
+    {
+        ZoneScoped;
+        switch (api)
+        {
+            case graphics_api::GL45: return gl45::precompile_program(stages, program_name, out_output);
+            default: return status_type::SUCCESS;
+        }
+    }
 }
@@ -0,0 +1,384 @@
+#include "../api/render_graph.hpp"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <unordered_set>
+
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    ///Textures may only share storage via views if their data types are view-compatible.
+    ///Colour formats are compatible within the same size class, depth / stencil formats are only compatible with themselves.
+    static u32 alias_format_class(const texture_data_type data_type)
+    {
+        switch (data_type)
+        {
+            case texture_data_type::DEPTH_F32:
+            case texture_data_type::DEPTH_U32_NORM:
+            case texture_data_type::DEPTH_U24_NORM:
+            case texture_data_type::DEPTH_U16_NORM:
+            case texture_data_type::DEPTH_U32_NORM_STENCIL_U8:
+            case texture_data_type::DEPTH_U24_NORM_STENCIL_U8:
+            case texture_data_type::STENCIL_U8: return 1000 + static_cast<u32>(data_type);
+
+            case texture_data_type::R_U8_NORM:
+            case texture_data_type::R_U8:
+            case texture_data_type::R_I8: return 1;
+
+            case texture_data_type::RG_U8_NORM:
+            case texture_data_type::RG_U8:
+            case texture_data_type::RG_I8:
+            case texture_data_type::R_U16:
+            case texture_data_type::R_I16:
+            case texture_data_type::R_F16: return 2;
+
+            case texture_data_type::RGB_U8_NORM:
+            case texture_data_type::SRGB_U8_NORM:
+            case texture_data_type::RGB_U8:
+            case texture_data_type::RGB_I8: return 3;
+
+            case texture_data_type::RGBA_U8_NORM:
+            case texture_data_type::SRGBA_U8_NORM:
+            case texture_data_type::RGBA_U8:
+            case texture_data_type::RGBA_I8:
+            case texture_data_type::RG_U16:
+            case texture_data_type::RG_I16:
+            case texture_data_type::RG_F16:
+            case texture_data_type::R_U32:
+            case texture_data_type::R_I32:
+            case texture_data_type::R_F32: return 4;
+
+            case texture_data_type::RGB_U16:
+            case texture_data_type::RGB_I16:
+            case texture_data_type::RGB_F16: return 6;
+
+            case texture_data_type::RGBA_U16:
+            case texture_data_type::RGBA_I16:
+            case texture_data_type::RGBA_F16:
+            case texture_data_type::RG_U32:
+            case texture_data_type::RG_I32:
+            case texture_data_type::RG_F32: return 8;
+
+            case texture_data_type::RGB_U32:
+            case texture_data_type::RGB_I32:
+            case texture_data_type::RGB_F32: return 12;
+
+            case texture_data_type::RGBA_U32:
+            case texture_data_type::RGBA_I32:
+            case texture_data_type::RGBA_F32: return 16;
+
+            default: break; //Compressed formats only alias with the exact same format.
+        }
+
+        return 2000 + static_cast<u32>(data_type);
+    }
+
+    static bool can_alias(const texture_format& a, const texture_format& b)
+    {
+        return a.shape == b.shape && a.msaa == b.msaa && a.width == b.width && a.height == b.height && a.depth == b.depth && a.layers == b.layers && a.mipmap_levels == b.mipmap_levels && alias_format_class(a.data_type) == alias_format_class(b.data_type);
+    }
+
+    status render_graph::add_transient_texture(const std::string_view& name, const texture_format& format, const texture_sampling_conifg& sampling_config)
+    {
+        ZoneScoped;
+        const object_identifier identifier = object_identifier(name);
+        if (transient_texture_indices.contains(identifier.hash) || transient_framebuffer_indices.contains(identifier.hash)) return {status_type::DUPLICATE, std::format("A transient object named '{0}' already exists in render graph '{1}'", name, graph_name)};
+        if (format.view_texture_base_mipmap != 0 || format.view_texture_base_layer != 0) return {status_type::INVALID, std::format("Transient texture '{0}' in render graph '{1}' can't be a texture view", name, graph_name)};
+
+        transient_texture_indices[identifier.hash] = transient_textures.size();
+        transient_textures.push_back({std::string(name), format, sampling_config});
+        return status_type::SUCCESS;
+    }
+
+    status render_graph::add_transient_framebuffer(const framebuffer& descriptor)
+    {
+        ZoneScoped;
+        const object_identifier& identifier = descriptor.identifier();
+        if (transient_texture_indices.contains(identifier.hash) || transient_framebuffer_indices.contains(identifier.hash)) return {status_type::DUPLICATE, std::format("A transient object named '{0}' already exists in render graph '{1}'", identifier.name, graph_name)};
+
+        std::vector<framebuffer_attachment_info> attachments = descriptor.color_attachments;
+        if (descriptor.depth_attachment.has_value()) attachments.push_back(descriptor.depth_attachment.value());
+        if (descriptor.stencil_attachment.has_value()) attachments.push_back(descriptor.stencil_attachment.value());
+
+        for (const framebuffer_attachment_info& attachment : attachments)
+        {
+            if (!transient_texture_indices.contains(attachment.texture.hash)) return {status_type::INVALID, std::format("Transient framebuffer '{0}' in render graph '{1}' attaches '{2}', which is not a transient texture", identifier.name, graph_name, attachment.texture.name)};
+        }
+
+        transient_framebuffer_indices[identifier.hash] = transient_framebuffers.size();
+        transient_framebuffers.push_back(descriptor);
+        return status_type::SUCCESS;
+    }
+
+    status render_graph::add_pass(const render_graph_pass& pass)
+    {
+        ZoneScoped;
+        for (const render_graph_pass& existing : passes)
+        {
+            if (existing.name == pass.name) return {status_type::DUPLICATE, std::format("A pass named '{0}' already exists in render graph '{1}'", pass.name, graph_name)};
+        }
+
+        passes.push_back(pass);
+        return status_type::SUCCESS;
+    }
+
+    void render_graph::clear()
+    {
+        ZoneScoped;
+        passes.clear();
+        transient_textures.clear();
+        transient_framebuffers.clear();
+        transient_texture_indices.clear();
+        transient_framebuffer_indices.clear();
+    }
+
+    status render_graph::release(render_context* context)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to render graph release"};
+
+        //Delete in reverse creation order so views and framebuffers go before the storage they reference.
+        for (const created_object& object : created_objects | std::views::reverse)
+        {
+            const status delete_status = context->delete_object(object.type, object.name);
+            if (delete_status.is_error()) return delete_status;
+        }
+
+        created_objects.clear();
+        return status_type::SUCCESS;
+    }
+
+    std::vector<u64> render_graph::expand_objects(const std::vector<object_identifier>& objects) const
+    {
+        std::vector<u64> expanded;
+        for (const object_identifier& object : objects)
+        {
+            expanded.push_back(object.hash);
+
+            const auto framebuffer_ptr = transient_framebuffer_indices.find(object.hash);
+            if (framebuffer_ptr == transient_framebuffer_indices.end()) continue;
+
+            const framebuffer& descriptor = transient_framebuffers[framebuffer_ptr->second];
+            for (const framebuffer_attachment_info& attachment : descriptor.color_attachments) expanded.push_back(attachment.texture.hash);
+            if (descriptor.depth_attachment.has_value()) expanded.push_back(descriptor.depth_attachment->texture.hash);
+            if (descriptor.stencil_attachment.has_value()) expanded.push_back(descriptor.stencil_attachment->texture.hash);
+        }
+
+        return expanded;
+    }
+
+    bool render_graph::is_transient(const u64 object_hash) const
+    {
+        return transient_texture_indices.contains(object_hash) || transient_framebuffer_indices.contains(object_hash);
+    }
+
+    status render_graph::compile(render_context* context, command_list& out_commands, render_graph_compile_info* out_info)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to render graph compile"};
+
+        const u32 pass_count = passes.size();
+        std::vector<std::vector<u64>> pass_reads(pass_count);
+        std::vector<std::vector<u64>> pass_writes(pass_count);
+        for (u32 idx = 0; idx < pass_count; idx++)
+        {
+            pass_reads[idx] = expand_objects(passes[idx].reads);
+            pass_writes[idx] = expand_objects(passes[idx].writes);
+        }
+
+        //Walk backwards from passes with externally visible results, keeping anything that produces an object a kept pass reads.
+        std::vector<bool> keep_pass(pass_count, false);
+        std::unordered_set<u64> needed_objects;
+        for (i64 idx = pass_count - 1; idx >= 0; idx--)
+        {
+            bool keep = passes[idx].has_side_effects;
+            for (const u64 written : pass_writes[idx])
+            {
+                if (!is_transient(written) || needed_objects.contains(written)) keep = true;
+            }
+
+            if (!keep) continue;
+            keep_pass[idx] = true;
+            needed_objects.insert_range(pass_reads[idx]);
+        }
+
+        //Determine the lifetime of each transient texture over the kept passes.
+        constexpr u32 unused = u32_max;
+        std::vector<u32> first_use(transient_textures.size(), unused);
+        std::vector<u32> last_use(transient_textures.size(), unused);
+        std::vector<u32> first_write(transient_textures.size(), unused);
+        std::unordered_set<u64> used_framebuffers;
+
+        for (u32 idx = 0; idx < pass_count; idx++)
+        {
+            if (!keep_pass[idx]) continue;
+
+            for (const u64 written : pass_writes[idx])
+            {
+                if (transient_framebuffer_indices.contains(written)) used_framebuffers.insert(written);
+                const auto texture_ptr = transient_texture_indices.find(written);
+                if (texture_ptr == transient_texture_indices.end()) continue;
+
+                const u32 texture_idx = texture_ptr->second;
+                if (first_use[texture_idx] == unused) first_use[texture_idx] = idx;
+                if (first_write[texture_idx] == unused) first_write[texture_idx] = idx;
+                last_use[texture_idx] = idx;
+            }
+
+            for (const u64 read : pass_reads[idx])
+            {
+                if (transient_framebuffer_indices.contains(read)) used_framebuffers.insert(read);
+                const auto texture_ptr = transient_texture_indices.find(read);
+                if (texture_ptr == transient_texture_indices.end()) continue;
+
+                const u32 texture_idx = texture_ptr->second;
+                if (first_write[texture_idx] == unused)
+                {
+                    return {status_type::INVALID, std::format("Pass '{0}' in render graph '{1}' reads transient texture '{2}' before any pass writes to it", passes[idx].name, graph_name, transient_textures[texture_idx].name)};
+                }
+                if (first_use[texture_idx] == unused) first_use[texture_idx] = idx;
+                last_use[texture_idx] = idx;
+            }
+        }
+
+        //Greedily assign transient textures to storage, reusing storage whose previous occupant is no longer used.
+        struct storage_slot
+        {
+            texture_format format;
+            u32 free_after_pass;
+            i64 last_occupant = -1;
+        };
+
+        std::vector<storage_slot> storage_slots;
+        std::vector<u32> assigned_storage(transient_textures.size(), unused);
+        std::vector<i64> previous_occupant(transient_textures.size(), -1);
+
+        std::vector<u32> lifetime_order;
+        for (u32 idx = 0; idx < transient_textures.size(); idx++)
+        {
+            if (first_use[idx] != unused) lifetime_order.push_back(idx);
+        }
+        std::ranges::sort(lifetime_order, [&first_use](const u32 a, const u32 b) { return first_use[a] < first_use[b]; });
+
+        for (const u32 texture_idx : lifetime_order)
+        {
+            const texture_format& format = transient_textures[texture_idx].format;
+            for (u32 slot_idx = 0; slot_idx < storage_slots.size(); slot_idx++)
+            {
+                storage_slot& slot = storage_slots[slot_idx];
+                if (slot.free_after_pass >= first_use[texture_idx] || !can_alias(slot.format, format)) continue;
+
+                assigned_storage[texture_idx] = slot_idx;
+                previous_occupant[texture_idx] = slot.last_occupant;
+                slot.free_after_pass = last_use[texture_idx];
+                slot.last_occupant = texture_idx;
+                break;
+            }
+
+            if (assigned_storage[texture_idx] != unused) continue;
+            assigned_storage[texture_idx] = storage_slots.size();
+            storage_slots.push_back({format, last_use[texture_idx], texture_idx});
+        }
+
+        //(Re)create the transient objects
+        const status release_status = release(context);
+        if (release_status.is_error()) return release_status;
+
+        descriptor_list descriptors;
+        std::vector<created_object> objects_to_create;
+        for (u32 slot_idx = 0; slot_idx < storage_slots.size(); slot_idx++)
+        {
+            const std::string storage_name = std::format("<render graph '{0}' transient storage {1}>", graph_name, slot_idx);
+            descriptors.push_back(texture(storage_name, storage_slots[slot_idx].format, texture_sampling_configs::none));
+            objects_to_create.push_back({descriptor_type::TEXTURE, storage_name});
+        }
+
+        for (const u32 texture_idx : lifetime_order)
+        {
+            const transient_texture& transient = transient_textures[texture_idx];
+            const std::string storage_name = std::format("<render graph '{0}' transient storage {1}>", graph_name, assigned_storage[texture_idx]);
+            descriptors.push_back(texture(transient.name, transient.format, transient.sampling_config, storage_name));
+            objects_to_create.push_back({descriptor_type::TEXTURE, transient.name});
+        }
+
+        for (const framebuffer& transient : transient_framebuffers)
+        {
+            if (!used_framebuffers.contains(transient.identifier().hash)) continue;
+            descriptors.push_back(transient);
+            objects_to_create.push_back({descriptor_type::FRAMEBUFFER, transient.identifier().name});
+        }
+
+        const status create_status = context->create_objects(std::move(descriptors));
+        if (create_status.is_error())
+        {
+            //Objects are created in order, so clean up whatever was created before the failure.
+            for (const created_object& object : objects_to_create | std::views::reverse)
+            {
+                (void)context->delete_object(object.type, object.name);
+            }
+            return create_status;
+        }
+        created_objects = objects_to_create;
+
+        //Build the command list, inserting barriers for objects written by earlier passes and for storage handed over between aliases.
+        render_graph_compile_info info;
+        info.transient_textures = lifetime_order.size();
+        info.transient_storage_textures = storage_slots.size();
+
+        std::unordered_map<u64, object_identifier> written_objects;
+        out_commands.clear();
+        for (u32 idx = 0; idx < pass_count; idx++)
+        {
+            if (!keep_pass[idx])
+            {
+                info.passes_culled++;
+                continue;
+            }
+
+            std::vector<object_identifier> barrier_objects;
+            const auto add_barrier_if_written = [&written_objects, &barrier_objects](const u64 object)
+            {
+                const auto written_ptr = written_objects.find(object);
+                if (written_ptr != written_objects.end() && !std::ranges::contains(barrier_objects, written_ptr->second)) barrier_objects.push_back(written_ptr->second);
+            };
+
+            for (const u64 read : pass_reads[idx]) add_barrier_if_written(read);
+            for (const u64 written : pass_writes[idx]) add_barrier_if_written(written);
+
+            for (const u32 texture_idx : lifetime_order)
+            {
+                if (first_use[texture_idx] != idx || previous_occupant[texture_idx] < 0) continue;
+                const object_identifier previous = object_identifier(transient_textures[previous_occupant[texture_idx]].name);
+                if (written_objects.contains(previous.hash) && !std::ranges::contains(barrier_objects, previous)) barrier_objects.push_back(previous);
+            }
+
+            if (!barrier_objects.empty())
+            {
+                out_commands.push_back(memory_barrier(barrier_objects));
+                info.memory_barriers++;
+            }
+
+            out_commands.append_range(passes[idx].commands);
+            info.passes_compiled++;
+
+            for (const object_identifier& written : passes[idx].writes)
+            {
+                written_objects[written.hash] = written;
+                const auto framebuffer_ptr = transient_framebuffer_indices.find(written.hash);
+                if (framebuffer_ptr == transient_framebuffer_indices.end()) continue;
+
+                const framebuffer& descriptor = transient_framebuffers[framebuffer_ptr->second];
+                for (const framebuffer_attachment_info& attachment : descriptor.color_attachments) written_objects[attachment.texture.hash] = attachment.texture;
+                if (descriptor.depth_attachment.has_value()) written_objects[descriptor.depth_attachment->texture.hash] = descriptor.depth_attachment->texture;
+                if (descriptor.stencil_attachment.has_value()) written_objects[descriptor.stencil_attachment->texture.hash] = descriptor.stencil_attachment->texture;
+            }
+        }
+
+        if (out_info != nullptr) *out_info = info;
+        return status_type::SUCCESS;
+    }
+}
@@ -0,0 +1,177 @@
+#include "../api/render_target_pool.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    status render_target_pool::acquire(render_context* context, const texture_format& format, pooled_render_target& out_target)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to render target pool acquire"};
+
+        //Prefer the most recently used match, so the least recently used targets are the ones left to age out.
+        pooled_target* best_match = nullptr;
+        for (pooled_target& target : targets)
+        {
+            if (target.in_use || target.format != format) continue;
+            if (best_match == nullptr || target.last_used_frame > best_match->last_used_frame) best_match = &target;
+        }
+
+        if (best_match != nullptr)
+        {
+            best_match->in_use = true;
+            best_match->last_used_frame = frame;
+            stats.acquired_targets++;
+            stats.targets_reused++;
+            out_target = best_match->target;
+            return status_type::SUCCESS;
+        }
+
+        pooled_target created;
+        const status create_status = create_target(context, format, created);
+        if (create_status.is_error()) return create_status;
+
+        targets.push_back(created);
+        stats.allocated_targets++;
+        stats.acquired_targets++;
+        stats.targets_created++;
+        stats.allocated_bytes += created.bytes;
+        stats.high_water_bytes = std::max(stats.high_water_bytes, stats.allocated_bytes);
+
+        out_target = created.target;
+        return status_type::SUCCESS;
+    }
+
+    status render_target_pool::end_frame(render_context* context)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to render target pool end frame"};
+
+        for (pooled_target& target : targets)
+        {
+            target.in_use = false;
+        }
+
+        stats.acquired_targets = 0;
+        frame++;
+        return trim(context);
+    }
+
+    status render_target_pool::release(render_context* context)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to render target pool release"};
+
+        while (!targets.empty())
+        {
+            const status delete_status = delete_target(context, targets.size() - 1);
+            if (delete_status.is_error()) return delete_status;
+        }
+
+        stats.acquired_targets = 0;
+        return status_type::SUCCESS;
+    }
+
+    render_target_pool_statistics render_target_pool::statistics() const
+    {
+        return stats;
+    }
+
+    void render_target_pool::reset_high_water_mark()
+    {
+        stats.high_water_bytes = stats.allocated_bytes;
+    }
+
+    status render_target_pool::create_target(render_context* context, const texture_format& format, pooled_target& out_target)
+    {
+        ZoneScoped;
+        const u64 target_id = next_target_id++;
+        const std::string texture_name = std::format("<render target pool '{0}' texture {1}>", pool_name, target_id);
+        const std::string framebuffer_name = std::format("<render target pool '{0}' framebuffer {1}>", pool_name, target_id);
+
+        //Attach the whole texture (every layer) at mip 0, as the attachment a render target is normally drawn into.
+        const framebuffer_attachment_info attachment = {object_identifier(texture_name), 0, 0, true};
+        const bool depth = does_texture_data_type_have_depth(format.data_type);
+        const bool stencil = does_texture_data_type_have_stencil(format.data_type);
+
+        descriptor_list descriptors;
+        descriptors.push_back(texture(texture_name, format, texture_sampling_configs::none));
+        if (depth || stencil)
+        {
+            descriptors.push_back(framebuffer(framebuffer_name, {}, depth ? std::optional(attachment) : std::nullopt, stencil ? std::optional(attachment) : std::nullopt));
+        }
+        else
+        {
+            descriptors.push_back(framebuffer(framebuffer_name, {attachment}));
+        }
+
+        const status create_status = context->create_objects(std::move(descriptors));
+        if (create_status.is_error())
+        {
+            //The texture may have been created before the framebuffer failed.
+            (void)context->delete_object(descriptor_type::TEXTURE, texture_name);
+            return create_status;
+        }
+
+        out_target = {format, {object_identifier(texture_name), object_identifier(framebuffer_name)}, texture_format_bytes(format), frame, true};
+        return status_type::SUCCESS;
+    }
+
+    status render_target_pool::trim(render_context* context)
+    {
+        ZoneScoped;
+        u64 unused_bytes = 0;
+        for (const pooled_target& target : targets)
+        {
+            if (!target.in_use) unused_bytes += target.bytes;
+        }
+
+        //Delete least recently used first, until the remaining unused targets are within both limits.
+        while (true)
+        {
+            u32 oldest_idx = targets.size();
+            for (u32 target_idx = 0; target_idx < targets.size(); target_idx++)
+            {
+                const pooled_target& target = targets[target_idx];
+                if (target.in_use) continue;
+                if (oldest_idx == targets.size() || target.last_used_frame < targets[oldest_idx].last_used_frame) oldest_idx = target_idx;
+            }
+
+            if (oldest_idx == targets.size()) break;
+
+            const pooled_target& oldest = targets[oldest_idx];
+            const bool too_old = frame - oldest.last_used_frame > max_unused_frames;
+            if (!too_old && unused_bytes <= max_unused_bytes) break;
+
+            unused_bytes -= oldest.bytes;
+            const status delete_status = delete_target(context, oldest_idx);
+            if (delete_status.is_error()) return delete_status;
+            stats.targets_trimmed++;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status render_target_pool::delete_target(render_context* context, const u32 target_idx)
+    {
+        ZoneScoped;
+        const pooled_target& target = targets[target_idx];
+
+        //The framebuffer references the texture, so it goes first.
+        const status framebuffer_status = context->delete_object(descriptor_type::FRAMEBUFFER, target.target.framebuffer.name);
+        if (framebuffer_status.is_error()) return framebuffer_status;
+
+        const status texture_status = context->delete_object(descriptor_type::TEXTURE, target.target.texture.name);
+        if (texture_status.is_error()) return texture_status;
+
+        stats.allocated_targets--;
+        stats.allocated_bytes -= target.bytes;
+        targets.erase(targets.begin() + target_idx);
+        return status_type::SUCCESS;
+    }
+}
@@ -0,0 +1,470 @@
+#include "../api/shader_archive.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <ranges>
+#include <unordered_set>
+
+#include "internal.hpp"
+#include "mapped_file.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    ///Header stored at the start of a shader archive, followed by the program directory and then the program data.
+    #pragma pack(push, 1)
+    struct shader_archive_header
+    {
+        u32 magic;
+        u32 version;
+        u32 program_count;
+        u32 directory_size;
+    };
+    #pragma pack(pop)
+
+    constexpr u32 SHADER_ARCHIVE_MAGIC = 0x41445453; //'STDA'
+    constexpr u32 SHADER_ARCHIVE_VERSION = 1;
+
+    ///Appends values to an archive. Everything written is a multiple of 4 bytes, so SPIR-V words in a mapped archive are always aligned.
+    class archive_writer
+    {
+    public:
+        template <typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(u32) == 0);
+            const u8* value_bytes = reinterpret_cast<const u8*>(&value);
+            bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(T));
+        }
+
+        void write_string(const std::string_view& string)
+        {
+            write(static_cast<u32>(string.size()));
+            bytes.insert(bytes.end(), string.begin(), string.end());
+            bytes.resize((bytes.size() + 3) & ~static_cast<u64>(3));
+        }
+
+        void write_words(const std::span<const u32>& words)
+        {
+            write(static_cast<u32>(words.size()));
+            const u8* word_bytes = reinterpret_cast<const u8*>(words.data());
+            bytes.insert(bytes.end(), word_bytes, word_bytes + words.size_bytes());
+        }
+
+        std::vector<u8> bytes;
+    };
+
+    ///Reads values written by archive_writer. Reading past the end flags the reader as failed and returns empty values instead.
+    class archive_reader
+    {
+    public:
+        archive_reader(const u8* data, const u64 size) : cursor(data), end(data + size) {}
+
+        template <typename T>
+        T read()
+        {
+            T value {};
+            if (!has_bytes(sizeof(T))) return value;
+            memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return value;
+        }
+
+        std::string_view read_string()
+        {
+            const u32 size = read<u32>();
+            const u64 padded_size = (static_cast<u64>(size) + 3) & ~static_cast<u64>(3);
+            if (!has_bytes(padded_size)) return {};
+            const std::string_view string(reinterpret_cast<const char*>(cursor), size);
+            cursor += padded_size;
+            return string;
+        }
+
+        std::span<const u32> read_words()
+        {
+            const u32 count = read<u32>();
+            if (!has_bytes(static_cast<u64>(count) * sizeof(u32))) return {};
+            const std::span<const u32> words(reinterpret_cast<const u32*>(cursor), count);
+            cursor += words.size_bytes();
+            return words;
+        }
+
+        bool failed = false;
+
+    private:
+        bool has_bytes(const u64 count)
+        {
+            if (failed || static_cast<u64>(end - cursor) < count) failed = true;
+            return !failed;
+        }
+
+        const u8* cursor;
+        const u8* end;
+    };
+
+    static void write_name_map(archive_writer& writer, const reflection_name_map& names)
+    {
+        writer.write(static_cast<u32>(names.size()));
+        for (const auto& [name, entry] : names)
+        {
+            writer.write_string(name);
+            writer.write(entry);
+        }
+    }
+
+    static void write_reflection_index(archive_writer& writer, const shader_reflection_index& index)
+    {
+        ZoneScoped;
+        writer.write(static_cast<u32>(index.entries.size()));
+        for (const shader_reflection_entry& entry : index.entries)
+        {
+            writer.write_string(entry.path);
+            writer.write(static_cast<u32>(entry.binding_kind));
+            writer.write(static_cast<u32>(entry.binding_shape));
+            writer.write(static_cast<u32>(entry.binding_access));
+            writer.write(static_cast<u32>(entry.is_binding));
+            writer.write(entry.set);
+            writer.write(entry.slot);
+            writer.write(entry.byte_address);
+            writer.write(entry.size);
+            writer.write(entry.element_entry);
+            writer.write(entry.element_count);
+            writer.write(entry.element_stride);
+            write_name_map(writer, entry.fields);
+        }
+
+        write_name_map(writer, index.roots);
+
+        writer.write(static_cast<u32>(index.buffers.size()));
+        for (const auto& [name, buffer] : index.buffers)
+        {
+            writer.write_string(name);
+            writer.write(buffer.size);
+            writer.write(buffer.layout.packed_size);
+            writer.write(buffer.layout.padded_size);
+            writer.write(static_cast<u32>(buffer.layout.pads.size()));
+            for (const memory_layout_info::pad& pad : buffer.layout.pads) writer.write(pad);
+        }
+    }
+
+    static status write_program(archive_writer& writer, const shader_archive_program& program)
+    {
+        ZoneScoped;
+        if (program.stages.empty()) return {status_type::INVALID, std::format("Shader archive program '{0}' has no stages", program.name)};
+
+        std::vector<const shader_reflection_index*> indexes;
+        bool is_single_api = true;
+
+        for (const shader_stage& stage : program.stages)
+        {
+            if (stage.internal == nullptr) return {status_type::UNEXPECTED, std::format("A shader stage in shader archive program '{0}' is invalid!", program.name)};
+            if (!stage.specialization_constants.empty()) return {status_type::INVALID, std::format("Shader archive program '{0}' has specialized stages - set specialization constants on the shader descriptor instead", program.name)};
+            if (stage.internal->api != program.stages[0].internal->api) is_single_api = false;
+            if (stage.internal->parameters != nullptr && std::ranges::find(indexes, stage.internal->parameters) == indexes.end()) indexes.push_back(stage.internal->parameters);
+        }
+
+        //Backend data is only precompiled for programs whose stages all target the same API.
+        precompiled_program_output precompiled;
+        if (is_single_api)
+        {
+            const status precompile_status = precompile_shader_program(program.stages[0].internal->api, program.stages, program.name, precompiled);
+            if (precompile_status.is_error()) return precompile_status;
+        }
+
+        writer.write(static_cast<u32>(program.stages.size()));
+        writer.write(static_cast<u32>(indexes.size()));
+
+        writer.write_words(precompiled.binding_offsets);
+        writer.write(static_cast<u32>(precompiled.slot_stage_masks.size()));
+        for (const auto& [slot, mask] : precompiled.slot_stage_masks)
+        {
+            writer.write(slot);
+            writer.write(mask);
+        }
+
+        for (const shader_reflection_index* index : indexes)
+        {
+            write_reflection_index(writer, *index);
+        }
+
+        for (u32 idx = 0; idx < program.stages.size(); idx++)
+        {
+            const shader_stage::shader_stage_internal* stage = program.stages[idx].internal.get();
+            const auto index_ptr = std::ranges::find(indexes, stage->parameters);
+
+            writer.write(static_cast<u32>(stage->type));
+            writer.write(static_cast<u32>(stage->api));
+            writer.write(index_ptr == indexes.end() ? u32_max : static_cast<u32>(index_ptr - indexes.begin()));
+            writer.write_words({static_cast<const u32*>(stage->data), stage->data_size / sizeof(u32)});
+            writer.write_string(precompiled.sources.empty() ? std::string_view() : precompiled.sources[idx]);
+            writer.write_words(precompiled.binaries.empty() ? std::span<const u32>() : precompiled.binaries[idx]);
+            writer.write_string(precompiled.entry_points.empty() ? std::string_view() : precompiled.entry_points[idx]);
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status write_shader_archive(const std::filesystem::path& path, const std::vector<shader_archive_program>& programs)
+    {
+        ZoneScoped;
+        archive_writer directory;
+        archive_writer program_data;
+        std::unordered_set<std::string_view> program_names;
+
+        for (const shader_archive_program& program : programs)
+        {
+            if (!program_names.insert(program.name).second) return {status_type::INVALID, std::format("Shader archive program '{0}' is declared more than once", program.name)};
+
+            const u64 program_offset = program_data.bytes.size();
+            const status program_status = write_program(program_data, program);
+            if (program_status.is_error()) return program_status;
+
+            directory.write_string(program.name);
+            directory.write(program_offset);
+            directory.write(program_data.bytes.size() - program_offset);
+        }
+
+        const shader_archive_header header {
+            .magic = SHADER_ARCHIVE_MAGIC,
+            .version = SHADER_ARCHIVE_VERSION,
+            .program_count = static_cast<u32>(programs.size()),
+            .directory_size = static_cast<u32>(directory.bytes.size()),
+        };
+
+        //Write to a temporary file first so an interrupted write never leaves a truncated archive behind.
+        std::filesystem::path temp_path = path;
+        temp_path += ".tmp";
+
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return {status_type::UNKNOWN, std::format("Couldn't open '{0}' to write shader archive", temp_path.string())};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(directory.bytes.data()), static_cast<std::streamsize>(directory.bytes.size()));
+            file.write(reinterpret_cast<const char*>(program_data.bytes.data()), static_cast<std::streamsize>(program_data.bytes.size()));
+            if (!file) return {status_type::UNKNOWN, std::format("Failed writing shader archive '{0}'", temp_path.string())};
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+            return {status_type::UNKNOWN, std::format("Couldn't move shader archive into place at '{0}'", path.string())};
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    struct loaded_archive_program
+    {
+        std::vector<std::unique_ptr<shader_reflection_index>> indexes;
+        precompiled_program_data precompiled;
+        std::vector<shader_stage> stages;
+    };
+
+    struct shader_archive::shader_archive_internal
+    {
+        struct program_range
+        {
+            u64 offset;
+            u64 size;
+        };
+
+        mapped_file file;
+        const u8* program_data = nullptr;
+        std::unordered_map<std::string, program_range, transparent_string_hash, std::equal_to<>> directory;
+
+        std::mutex lock;
+        std::unordered_map<std::string, std::unique_ptr<loaded_archive_program>, transparent_string_hash, std::equal_to<>> loaded_programs;
+    };
+
+    static void read_name_map(archive_reader& reader, reflection_name_map& out_names)
+    {
+        const u32 count = reader.read<u32>();
+        for (u32 idx = 0; idx < count && !reader.failed; idx++)
+        {
+            const std::string_view name = reader.read_string();
+            out_names.emplace(name, reader.read<u32>());
+        }
+    }
+
+    static bool read_reflection_index(archive_reader& reader, shader_reflection_index& out_index)
+    {
+        ZoneScoped;
+        const u32 entry_count = reader.read<u32>();
+        for (u32 idx = 0; idx < entry_count && !reader.failed; idx++)
+        {
+            shader_reflection_entry& entry = out_index.entries.emplace_back();
+            entry.path = reader.read_string();
+            entry.binding_kind = static_cast<slang::TypeReflection::Kind>(reader.read<u32>());
+            entry.binding_shape = static_cast<SlangResourceShape>(reader.read<u32>());
+            entry.binding_access = static_cast<SlangResourceAccess>(reader.read<u32>());
+            entry.is_binding = reader.read<u32>() != 0;
+            entry.set = reader.read<i64>();
+            entry.slot = reader.read<i64>();
+            entry.byte_address = reader.read<u64>();
+            entry.size = reader.read<u64>();
+            entry.element_entry = reader.read<u32>();
+            entry.element_count = reader.read<u32>();
+            entry.element_stride = reader.read<u64>();
+            read_name_map(reader, entry.fields);
+        }
+
+        read_name_map(reader, out_index.roots);
+
+        const u32 buffer_count = reader.read<u32>();
+        for (u32 idx = 0; idx < buffer_count && !reader.failed; idx++)
+        {
+            const std::string_view name = reader.read_string();
+            shader_buffer_info buffer;
+            buffer.size = reader.read<i64>();
+            buffer.layout.packed_size = reader.read<u64>();
+            buffer.layout.padded_size = reader.read<u64>();
+
+            const u32 pad_count = reader.read<u32>();
+            for (u32 pad_idx = 0; pad_idx < pad_count && !reader.failed; pad_idx++)
+            {
+                buffer.layout.pads.push_back(reader.read<memory_layout_info::pad>());
+            }
+
+            out_index.buffers.emplace(name, std::move(buffer));
+        }
+
+        if (reader.failed) return false;
+
+        //Locations index straight into the entries, so make sure a corrupted archive can't send them out of bounds.
+        const u64 entries = out_index.entries.size();
+        const auto is_valid_entry = [entries](const u32 entry) { return entry < entries; };
+        for (const shader_reflection_entry& entry : out_index.entries)
+        {
+            if (entry.element_entry != u32_max && !is_valid_entry(entry.element_entry)) return false;
+            if (!std::ranges::all_of(entry.fields | std::views::values, is_valid_entry)) return false;
+        }
+
+        return std::ranges::all_of(out_index.roots | std::views::values, is_valid_entry);
+    }
+
+    static status read_program(const std::string_view& name, archive_reader& reader, loaded_archive_program& out_program)
+    {
+        ZoneScoped;
+        const u32 stage_count = reader.read<u32>();
+        const u32 index_count = reader.read<u32>();
+
+        precompiled_program_data& precompiled = out_program.precompiled;
+        const std::span<const u32> binding_offsets = reader.read_words();
+        precompiled.gl45_binding_offsets.assign(binding_offsets.begin(), binding_offsets.end());
+
+        const u32 mask_count = reader.read<u32>();
+        for (u32 idx = 0; idx < mask_count && !reader.failed; idx++)
+        {
+            const u32 slot = reader.read<u32>();
+            precompiled.gl45_slot_stage_masks[slot] = reader.read<u32>();
+        }
+
+        for (u32 idx = 0; idx < index_count && !reader.failed; idx++)
+        {
+            if (!read_reflection_index(reader, *out_program.indexes.emplace_back(std::make_unique<shader_reflection_index>()))) reader.failed = true;
+        }
+
+        for (u32 idx = 0; idx < stage_count && !reader.failed; idx++)
+        {
+            const shader_stage stage = shader_stage(std::make_shared<shader_stage::shader_stage_internal>());
+            stage.internal->type = static_cast<shader_stage_type>(reader.read<u32>());
+            stage.internal->api = static_cast<graphics_api>(reader.read<u32>());
+            const u32 index_id = reader.read<u32>();
+
+            const std::span<const u32> spirv = reader.read_words();
+            stage.internal->data = const_cast<u32*>(spirv.data());
+            stage.internal->data_size = spirv.size_bytes();
+            stage.internal->parameters = index_id < out_program.indexes.size() ? out_program.indexes[index_id].get() : nullptr;
+            stage.internal->precompiled = &precompiled;
+            stage.internal->precompiled_index = idx;
+
+            precompiled.gl45_sources.push_back(reader.read_string());
+            precompiled.gl45_spirv.push_back(reader.read_words());
+            precompiled.gl45_entry_points.push_back(reader.read_string());
+
+            out_program.stages.push_back(stage);
+        }
+
+        if (reader.failed) return {status_type::INVALID, std::format("Shader archive program '{0}' is corrupted", name)};
+        return status_type::SUCCESS;
+    }
+
+    status shader_archive::open(const std::filesystem::path& path, shader_archive*& out_archive)
+    {
+        ZoneScoped;
+        std::unique_ptr<shader_archive> archive(new shader_archive());
+        archive->internal = std::make_unique<shader_archive_internal>();
+        mapped_file& file = archive->internal->file;
+
+        const status map_status = file.open(path);
+        if (map_status.is_error()) return map_status;
+
+        if (file.size() < sizeof(shader_archive_header)) return {status_type::INVALID, std::format("'{0}' is too small to be a shader archive", path.string())};
+
+        shader_archive_header header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (header.magic != SHADER_ARCHIVE_MAGIC || header.version != SHADER_ARCHIVE_VERSION) return {status_type::INVALID, std::format("'{0}' is not a recognized shader archive", path.string())};
+        if (header.directory_size > file.size() - sizeof(header)) return {status_type::INVALID, std::format("Shader archive '{0}' is corrupted", path.string())};
+
+        //Only the directory is read up front - programs are parsed when they're first requested.
+        archive_reader reader(file.data() + sizeof(header), header.directory_size);
+        archive->internal->program_data = file.data() + sizeof(header) + header.directory_size;
+        const u64 program_data_size = file.size() - sizeof(header) - header.directory_size;
+
+        for (u32 idx = 0; idx < header.program_count && !reader.failed; idx++)
+        {
+            const std::string_view name = reader.read_string();
+            const u64 offset = reader.read<u64>();
+            const u64 size = reader.read<u64>();
+            if (offset > program_data_size || size > program_data_size - offset) reader.failed = true;
+            archive->internal->directory.emplace(name, shader_archive_internal::program_range {offset, size});
+        }
+
+        if (reader.failed) return {status_type::INVALID, std::format("Shader archive '{0}' is corrupted", path.string())};
+
+        out_archive = archive.release();
+        return status_type::SUCCESS;
+    }
+
+    status shader_archive::get_program(const std::string_view& name, std::vector<shader_stage>& out_stages) const
+    {
+        ZoneScoped;
+        std::scoped_lock guard(internal->lock);
+
+        const auto loaded_ptr = internal->loaded_programs.find(name);
+        if (loaded_ptr != internal->loaded_programs.end())
+        {
+            out_stages = loaded_ptr->second->stages;
+            return status_type::SUCCESS;
+        }
+
+        const auto range_ptr = internal->directory.find(name);
+        if (range_ptr == internal->directory.end()) return {status_type::UNKNOWN, std::format("Shader archive has no program named '{0}'", name)};
+
+        archive_reader reader(internal->program_data + range_ptr->second.offset, range_ptr->second.size);
+        std::unique_ptr<loaded_archive_program> program = std::make_unique<loaded_archive_program>();
+        const status read_status = read_program(name, reader, *program);
+        if (read_status.is_error()) return read_status;
+
+        out_stages = program->stages;
+        internal->loaded_programs.emplace(name, std::move(program));
+        return status_type::SUCCESS;
+    }
+
+    std::vector<std::string_view> shader_archive::program_names() const
+    {
+        std::vector<std::string_view> names;
+        for (const std::string& name : internal->directory | std::views::keys)
+        {
+            names.push_back(name);
+        }
+        return names;
+    }
+
+    shader_archive::shader_archive() = default;
+    shader_archive::~shader_archive() = default;
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <format>
+
+#include "../api/shaders.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    status shader_variant_library::create(shader_variant_library*& out_library, shader_compiler_context* compiler, const std::string_view& source, const std::vector<shader_variant_axis>& axes, const std::vector<std::string>& entry_points)
+    {
+        ZoneScoped;
+        if (compiler == nullptr) return {status_type::INVALID, "Shader variant library requires a compiler context"};
+        if (entry_points.empty()) return {status_type::INVALID, "Shader variant library requires at least one entry point"};
+
+        for (u32 idx = 0; idx < axes.size(); idx++)
+        {
+            const shader_variant_axis& axis = axes[idx];
+            if (axis.values.empty()) return {status_type::INVALID, std::format("Shader variant axis '{0}' has no values", axis.keyword)};
+
+            for (u32 other_idx = 0; other_idx < idx; other_idx++)
+            {
+                if (axes[other_idx].keyword == axis.keyword) return {status_type::INVALID, std::format("Shader variant axis '{0}' is declared more than once", axis.keyword)};
+            }
+        }
+
+        out_library = new shader_variant_library();
+        out_library->compiler = compiler;
+        out_library->source = std::string(source);
+        out_library->axes = axes;
+        out_library->entry_points = entry_points;
+        return status_type::SUCCESS;
+    }
+
+    status shader_variant_library::resolve_variant(const shader_variant_key& key, std::vector<shader_macro>& out_macro_defines) const
+    {
+        ZoneScoped;
+        for (const shader_macro& keyword : key)
+        {
+            const auto axis = std::ranges::find(axes, keyword.name, &shader_variant_axis::keyword);
+            if (axis == axes.end()) return {status_type::INVALID, std::format("Shader variant key uses unknown keyword '{0}'", keyword.name)};
+            if (std::ranges::find(axis->values, keyword.value) == axis->values.end()) return {status_type::INVALID, std::format("'{1}' is not a valid value for shader variant keyword '{0}'", keyword.name, keyword.value)};
+        }
+
+        //Macros are always produced in axis order so that keys giving the same values in different orders (or leaving defaults implicit) resolve identically.
+        out_macro_defines.clear();
+        for (const shader_variant_axis& axis : axes)
+        {
+            const auto keyword = std::ranges::find(key, axis.keyword, &shader_macro::name);
+            out_macro_defines.push_back({axis.keyword, keyword == key.end() ? axis.values[0] : keyword->value});
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status shader_variant_library::get_variant(const shader_variant_key& key, const graphics_api& api, std::vector<shader_stage>& out_stages)
+    {
+        ZoneScoped;
+        std::vector<shader_macro> macro_defines;
+        const status resolve_status = resolve_variant(key, macro_defines);
+        if (resolve_status.is_error()) return resolve_status;
+
+        std::string variant_name;
+        for (const shader_macro& macro : macro_defines)
+        {
+            variant_name += std::format("{0}={1};", macro.name, macro.value);
+        }
+
+        compiled_variant& variant = variants[variant_name];
+
+        for (const auto& [stage_api, stages] : variant.api_stages)
+        {
+            if (stage_api != api) continue;
+            out_stages = stages;
+            return status_type::SUCCESS;
+        }
+
+        //The same variant may already be compiled and linked for a different API, in which case only the stages need creating.
+        if (variant.program.internal == nullptr)
+        {
+            const status load_status = compiler->load_shader_module(source, macro_defines, variant.module);
+            if (load_status.is_error())
+            {
+                variants.erase(variant_name);
+                return load_status;
+            }
+
+            std::vector<shader_entry_point> linked_entry_points;
+            for (const std::string& entry_point : entry_points)
+            {
+                linked_entry_points.push_back({variant.module, entry_point});
+            }
+
+            const status link_status = compiler->link_shader_program(linked_entry_points, variant.program);
+            if (link_status.is_error())
+            {
+                variants.erase(variant_name);
+                return link_status;
+            }
+        }
+
+        std::vector<shader_stage> stages;
+        for (const std::string& entry_point : entry_points)
+        {
+            shader_stage stage;
+            const status stage_status = compiler->create_shader_stage(variant.program, {variant.module, entry_point}, api, stage);
+            if (stage_status.is_error()) return stage_status;
+            stages.push_back(stage);
+        }
+
+        variant.api_stages.emplace_back(api, stages);
+        out_stages = std::move(stages);
+        return status_type::SUCCESS;
+    }
+
+    u64 shader_variant_library::compiled_variant_count() const
+    {
+        return variants.size();
+    }
+}
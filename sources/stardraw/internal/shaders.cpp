@@ -1,21 +1,51 @@
 #include "internal.hpp"
 
+#include <algorithm>
 #include <array>
 #include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <queue>
+#include <ranges>
 #include <slang-com-ptr.h>
 #include <slang.h>
 #include <spirv_glsl.hpp>
 #include <stack>
+#include <thread>
 
 #include "tracy/Tracy.hpp"
 
 namespace stardraw
 {
+    ///The Slang global session is expensive to create, so one is shared by every compiler context in the process.
+    ///Slang requires everything created from a global session (sessions, modules, programs and their reflection) to only be used by one thread at a time,
+    ///so every call into Slang is made while holding the lock. It's recursive so that helpers can take it again from inside a locked call.
+    struct slang_global_session
+    {
+        std::recursive_mutex lock;
+        slang::IGlobalSession* session = nullptr;
+    };
+
+    static slang_global_session& get_global_session()
+    {
+        static slang_global_session global_session;
+        return global_session;
+    }
+
     struct shader_module::shader_module_internal
     {
         Slang::ComPtr<slang::IModule> slang_module;
         std::string name;
+        u64 content_hash = 0; //Stable hash of everything that went into the module, used to key cached shader stages.
+        u64 macro_hash = 0; //Hash of the macro defines the module was compiled with, which decides the sessions it can be linked in.
+
+        ~shader_module_internal()
+        {
+            //Releasing the module is a call into Slang too, and modules can be destroyed from any thread.
+            std::scoped_lock guard(get_global_session().lock);
+            slang_module = nullptr;
+        }
     };
 }
 
@@ -36,22 +66,142 @@ namespace stardraw
     {
         Slang::ComPtr<slang::IComponentType> linked_components;
         std::unordered_map<shader_entry_point, u32> entry_point_indexes;
+        u64 link_hash = 0; //Stable hash of the modules and entry points linked together.
+
+        ~shader_program_internal()
+        {
+            std::scoped_lock guard(get_global_session().lock);
+            linked_components = nullptr;
+        }
+    };
+
+    ///A slang session, along with a hash of the options it was created with.
+    struct slang_session_info
+    {
+        slang::ISession* session = nullptr;
+        u64 options_hash = STABLE_HASH_SEED; //Hash of everything other than the source that affects compiler output (macros, targets and compiler version)
     };
 
+    static starlib::status create_slang_session(slang::IGlobalSession* context, const std::vector<shader_macro>& macro_defines, slang_session_info& out_session);
+
+    static u64 hash_macro_defines(const std::vector<shader_macro>& macro_defines)
+    {
+        u64 hash = STABLE_HASH_SEED;
+        for (const shader_macro& macro : macro_defines)
+        {
+            //Separators are hashed so that, for instance, 'AB=C' and 'A=BC' don't produce the same key.
+            hash = stable_hash(macro.name, hash);
+            hash = stable_hash("=", hash);
+            hash = stable_hash(macro.value, hash);
+            hash = stable_hash(";", hash);
+        }
+        return hash;
+    }
+
     struct shader_compiler_context::shader_compiler_context_internal
     {
         slang::IGlobalSession* context = nullptr;
-        slang::ISession* session = nullptr;
+        std::vector<shader_macro> macro_defines;
+        u64 macro_hash = STABLE_HASH_SEED; //Hash of the macro defines the context was created with
+        u64 options_hash = STABLE_HASH_SEED; //Hash of everything other than the source that affects compiler output (macros, targets and compiler version)
+        std::filesystem::path cache_directory;
+
+        //Everything below is shared between all threads using the context, and guarded by the lock.
+        //Anything that calls into Slang must hold the global session's lock first, and take this one inside it.
+        std::mutex lock;
+        std::unordered_map<u64, slang_session_info> sessions; //Macro defines are per-session in Slang, so there's one session per set of macros.
+        std::unordered_map<u64, std::vector<shader_macro>> macro_sets; //Full macro defines by hash, so sessions can be created for them on first use.
+        std::map<std::pair<u64, slang::ISession*>, Slang::ComPtr<slang::IModule>> imported_modules; //Modules imported from another session, by content hash and the importing session.
         std::vector<Slang::ComPtr<slang::IComponentType>> linked_programs;
+        std::unordered_map<slang::ShaderReflection*, std::unique_ptr<shader_reflection_index>> reflection_indexes; //Shared between all stages created from the same linked program.
 
         ~shader_compiler_context_internal()
         {
             ZoneScoped;
-            if (session != nullptr) session->release();
+            std::scoped_lock global_guard(get_global_session().lock);
+            linked_programs.clear();
+            imported_modules.clear();
+            for (const slang_session_info& session : sessions | std::views::values) session.session->release();
             if (context != nullptr) context->release();
         }
+
+        u64 register_macro_set(const std::vector<shader_macro>& macros)
+        {
+            const u64 hash = hash_macro_defines(macros);
+            std::scoped_lock guard(lock);
+            macro_sets.try_emplace(hash, macros);
+            return hash;
+        }
+
+        ///Get the session for a set of macros registered with register_macro_set, creating it if needed. The global session's lock must be held.
+        status get_session(const u64 macro_set_hash, slang_session_info& out_session)
+        {
+            ZoneScoped;
+            std::scoped_lock guard(lock);
+            const auto existing = sessions.find(macro_set_hash);
+            if (existing != sessions.end())
+            {
+                out_session = existing->second;
+                return status_type::SUCCESS;
+            }
+
+            const auto macros = macro_sets.find(macro_set_hash);
+            if (macros == macro_sets.end()) return {status_type::UNEXPECTED, "Shader compiler has no macro set for the requested session"};
+
+            const status session_status = create_slang_session(context, macros->second, out_session);
+            if (session_status.is_error()) return session_status;
+
+            sessions[macro_set_hash] = out_session;
+            return status_type::SUCCESS;
+        }
+
+        ///Get a module that can be linked in a session, importing it through its serialized IR if it was loaded by a different session. The global session's lock must be held.
+        status import_module(const shader_module& module, slang::ISession* session, Slang::ComPtr<slang::IModule>& out_module)
+        {
+            ZoneScoped;
+            if (module.internal->slang_module->getSession() == session)
+            {
+                out_module = module.internal->slang_module;
+                return status_type::SUCCESS;
+            }
+
+            const std::pair key = {module.internal->content_hash, session};
+            {
+                std::scoped_lock guard(lock);
+                const auto existing = imported_modules.find(key);
+                if (existing != imported_modules.end())
+                {
+                    out_module = existing->second;
+                    return status_type::SUCCESS;
+                }
+            }
+
+            Slang::ComPtr<ISlangBlob> serialized_blob;
+            if (SLANG_FAILED(module.internal->slang_module->serialize(serialized_blob.writeRef()))) return {status_type::BACKEND_ERROR, "Failed to serialize module for use in another session"};
+
+            Slang::ComPtr<slang::IBlob> diagnostics;
+            const char* name = module.internal->name.c_str();
+            const Slang::ComPtr imported(session->loadModuleFromIRBlob(name, name, serialized_blob, diagnostics.writeRef()));
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang module import failed with error: '{0}'", msg)};
+            }
+
+            if (!imported) return {status_type::BACKEND_ERROR, "Slang module import failed with unknown error"};
+
+            std::scoped_lock guard(lock);
+            imported_modules[key] = imported;
+            out_module = imported;
+            return status_type::SUCCESS;
+        }
     };
 
+    ///SPIR-V profile generated for GL45 (target 0). ARB_gl_spirv only guarantees SPIR-V 1.0, so native GL binaries must not use anything newer.
+    ///The GLSL path converts the same SPIR-V with SPIRV-Cross, which reads 1.0 just as well.
+    static constexpr const char* GL45_SPIRV_PROFILE = "spirv_1_0";
+
     int get_target_index_for_api(const graphics_api& api)
     {
         switch (api)
@@ -68,22 +218,165 @@ namespace stardraw
 
     starlib::status cleanup_shader_compiler()
     {
+        ZoneScoped;
+        //Contexts hold their own reference to the global session, so any still alive keep working.
+        slang_global_session& global_session = get_global_session();
+        std::scoped_lock guard(global_session.lock);
+        if (global_session.session != nullptr) global_session.session->release();
+        global_session.session = nullptr;
         return status_type::SUCCESS;
     }
 
-    starlib::status shader_compiler_context::create(shader_compiler_context*& out_context, const std::vector<shader_macro>& macro_defines)
+    ///Header stored at the start of every cached shader stage.
+    #pragma pack(push, 1)
+    struct shader_stage_cache_header
+    {
+        u32 magic;
+        u32 version;
+        u64 key;
+        u32 stage_type;
+        u32 data_size;
+    };
+    #pragma pack(pop)
+
+    constexpr u32 SHADER_STAGE_CACHE_MAGIC = 0x53445453; //'STDS'
+    constexpr u32 SHADER_STAGE_CACHE_VERSION = 1;
+
+    ///Header stored at the start of every cached shader module, followed by its dependencies and then the module's IR.
+    ///Each dependency is a u64 hash of the file's contents when the module was cached, a u32 path length, and the path.
+    #pragma pack(push, 1)
+    struct shader_module_cache_header
+    {
+        u32 magic;
+        u32 version;
+        u32 dependency_count;
+    };
+    #pragma pack(pop)
+
+    constexpr u32 SHADER_MODULE_CACHE_MAGIC = 0x4D445453; //'STDM'
+    constexpr u32 SHADER_MODULE_CACHE_VERSION = 1;
+
+    static bool read_cache_file(const std::filesystem::path& path, std::vector<u8>& out_data)
     {
         ZoneScoped;
-        shader_compiler_context::shader_compiler_context_internal* internal_ctx = new shader_compiler_context::shader_compiler_context_internal();
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+
+        const std::streamsize size = file.tellg();
+        if (size <= 0) return false;
+
+        out_data.resize(size);
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(out_data.data()), size));
+    }
+
+    static void write_cache_file(const std::filesystem::path& path, const void* data, const u64 size)
+    {
+        ZoneScoped;
+        //Write to a temporary file first so an interrupted write (or another context writing the same entry) never leaves a truncated file behind.
+        std::filesystem::path temp_path = path;
+        temp_path += std::format(".{0}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!file) return;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        if (error) std::filesystem::remove(temp_path, error);
+    }
+
+    static bool hash_module_dependency(const std::string& path, u64& out_hash)
+    {
+        ZoneScoped;
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(path, error)) return false;
+
+        std::vector<u8> contents;
+        if (std::filesystem::file_size(path, error) != 0 && !read_cache_file(path, contents)) return false;
+        out_hash = stable_hash(contents.data(), contents.size());
+        return true;
+    }
 
-        const SlangResult result = slang::createGlobalSession(&internal_ctx->context);
-        if (SLANG_FAILED(result))
+    ///Build the header for a cached module, recording the files it imported so edits to them invalidate the cache entry.
+    ///out_dependency_hash combines the contents of every dependency. Returns false if a dependency can't be read, in which case the module shouldn't be cached.
+    static bool write_module_cache_header(slang::IModule* module, const std::string& module_path, std::vector<u8>& out_data, u64& out_dependency_hash)
+    {
+        ZoneScoped;
+        shader_module_cache_header header = {SHADER_MODULE_CACHE_MAGIC, SHADER_MODULE_CACHE_VERSION, 0};
+        out_dependency_hash = STABLE_HASH_SEED;
+        std::vector<u8> dependencies;
+        for (SlangInt32 dependency_idx = 0; dependency_idx < module->getDependencyFileCount(); dependency_idx++)
         {
-            delete internal_ctx;
-            return {status_type::BACKEND_ERROR, "Slang context creation failed"};
+            const std::string path = module->getDependencyFilePath(dependency_idx);
+            if (path == module_path) continue;
+
+            u64 content_hash;
+            if (!hash_module_dependency(path, content_hash)) return false;
+            out_dependency_hash = stable_hash(&content_hash, sizeof(u64), out_dependency_hash);
+
+            const u32 path_size = static_cast<u32>(path.size());
+            const u64 offset = dependencies.size();
+            dependencies.resize(offset + sizeof(u64) + sizeof(u32) + path_size);
+            memcpy(dependencies.data() + offset, &content_hash, sizeof(u64));
+            memcpy(dependencies.data() + offset + sizeof(u64), &path_size, sizeof(u32));
+            memcpy(dependencies.data() + offset + sizeof(u64) + sizeof(u32), path.data(), path_size);
+            header.dependency_count++;
         }
 
+        out_data.resize(sizeof(shader_module_cache_header));
+        memcpy(out_data.data(), &header, sizeof(shader_module_cache_header));
+        out_data.insert(out_data.end(), dependencies.begin(), dependencies.end());
+        return true;
+    }
+
+    ///Check a cached module's header, and that every file it imported is unchanged since it was cached.
+    static bool read_module_cache_header(const std::vector<u8>& data, u64& out_module_offset, u64& out_dependency_hash)
+    {
+        ZoneScoped;
+        out_dependency_hash = STABLE_HASH_SEED;
+        if (data.size() < sizeof(shader_module_cache_header)) return false;
+        shader_module_cache_header header;
+        memcpy(&header, data.data(), sizeof(shader_module_cache_header));
+        if (header.magic != SHADER_MODULE_CACHE_MAGIC || header.version != SHADER_MODULE_CACHE_VERSION) return false;
+
+        u64 offset = sizeof(shader_module_cache_header);
+        for (u32 dependency_idx = 0; dependency_idx < header.dependency_count; dependency_idx++)
+        {
+            if (data.size() < offset + sizeof(u64) + sizeof(u32)) return false;
+            u64 cached_hash;
+            u32 path_size;
+            memcpy(&cached_hash, data.data() + offset, sizeof(u64));
+            memcpy(&path_size, data.data() + offset + sizeof(u64), sizeof(u32));
+            offset += sizeof(u64) + sizeof(u32);
+
+            if (data.size() < offset + path_size) return false;
+            const std::string path(reinterpret_cast<const char*>(data.data() + offset), path_size);
+            offset += path_size;
+
+            u64 current_hash;
+            if (!hash_module_dependency(path, current_hash) || current_hash != cached_hash) return false;
+            out_dependency_hash = stable_hash(&current_hash, sizeof(u64), out_dependency_hash);
+        }
+
+        if (offset >= data.size()) return false;
+        out_module_offset = offset;
+        return true;
+    }
+
+    static starlib::status create_slang_session(slang::IGlobalSession* context, const std::vector<shader_macro>& macro_defines, slang_session_info& out_session)
+    {
+        ZoneScoped;
+        std::scoped_lock guard(get_global_session().lock);
+        out_session.options_hash = stable_hash(context->getBuildTagString());
+        out_session.options_hash = stable_hash(GL45_SPIRV_PROFILE, out_session.options_hash);
+
         std::vector<slang::CompilerOptionEntry> compiler_options;
+        const u64 macro_hash = hash_macro_defines(macro_defines);
+        out_session.options_hash = stable_hash(&macro_hash, sizeof(u64), out_session.options_hash);
         for (const shader_macro& macro : macro_defines)
         {
             compiler_options.push_back(slang::CompilerOptionEntry {
@@ -97,10 +390,10 @@ namespace stardraw
 
         slang::SessionDesc session_desc;
 
-        const static std::array slang_targets = {
+        const std::array slang_targets = {
             slang::TargetDesc {
                 .format = SlangCompileTarget::SLANG_SPIRV,
-                .profile = internal_ctx->context->findProfile("spirv_latest"),
+                .profile = context->findProfile(GL45_SPIRV_PROFILE),
             },
         };
 
@@ -113,11 +406,53 @@ namespace stardraw
         session_desc.searchPaths = nullptr;
         session_desc.searchPathCount = 0;
 
-        const SlangResult session_creation = internal_ctx->context->createSession(session_desc, &internal_ctx->session);
-        if (SLANG_FAILED(session_creation))
+        const SlangResult session_creation = context->createSession(session_desc, &out_session.session);
+        if (SLANG_FAILED(session_creation)) return {status_type::BACKEND_ERROR, "Slang session creation failed"};
+
+        return status_type::SUCCESS;
+    }
+
+    starlib::status shader_compiler_context::create(shader_compiler_context*& out_context, const std::vector<shader_macro>& macro_defines, const std::filesystem::path& cache_directory)
+    {
+        ZoneScoped;
+        shader_compiler_context::shader_compiler_context_internal* internal_ctx = new shader_compiler_context::shader_compiler_context_internal();
+
         {
-            delete internal_ctx;
-            return {status_type::BACKEND_ERROR, "Slang session creation failed"};
+            slang_global_session& global_session = get_global_session();
+            std::scoped_lock guard(global_session.lock);
+            if (global_session.session == nullptr && SLANG_FAILED(slang::createGlobalSession(&global_session.session)))
+            {
+                global_session.session = nullptr;
+                delete internal_ctx;
+                return {status_type::BACKEND_ERROR, "Slang context creation failed"};
+            }
+
+            internal_ctx->context = global_session.session;
+            internal_ctx->context->addRef();
+        }
+
+        internal_ctx->macro_defines = macro_defines;
+        internal_ctx->macro_hash = internal_ctx->register_macro_set(macro_defines);
+
+        //Create the default session up front so configuration errors are reported here.
+        slang_session_info session_info;
+        {
+            std::scoped_lock guard(get_global_session().lock);
+            const status session_status = internal_ctx->get_session(internal_ctx->macro_hash, session_info);
+            if (session_status.is_error())
+            {
+                delete internal_ctx;
+                return session_status;
+            }
+        }
+
+        internal_ctx->options_hash = session_info.options_hash;
+
+        if (!cache_directory.empty())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(cache_directory, error);
+            if (!error) internal_ctx->cache_directory = cache_directory;
         }
 
         out_context = new shader_compiler_context;
@@ -126,13 +461,57 @@ namespace stardraw
     }
 
     status shader_compiler_context::load_shader_module(const std::string_view& source, shader_module& out_shader_module) const
+    {
+        return load_shader_module(source, {}, out_shader_module);
+    }
+
+    status shader_compiler_context::load_shader_module(const std::string_view& source, const std::vector<shader_macro>& additional_macro_defines, shader_module& out_shader_module) const
     {
         ZoneScoped;
-        if (this->internal->session == nullptr) return {status_type::INVALID, "Shader compiler not initialized"};
-        constexpr std::hash<std::string_view> hash;
-        const std::string fake_path = std::format("module_{0}.fakepath", hash(source));
+        if (this->internal->context == nullptr) return {status_type::INVALID, "Shader compiler not initialized"};
+
+        //Macro defines are per-session in Slang, so each distinct set of additional defines gets its own session.
+        u64 macro_hash = internal->macro_hash;
+        if (!additional_macro_defines.empty())
+        {
+            std::vector<shader_macro> macro_defines = internal->macro_defines;
+            macro_defines.insert(macro_defines.end(), additional_macro_defines.begin(), additional_macro_defines.end());
+            macro_hash = internal->register_macro_set(macro_defines);
+        }
+
+        std::scoped_lock global_guard(get_global_session().lock);
+        slang_session_info session_info;
+        const status session_status = internal->get_session(macro_hash, session_info);
+        if (session_status.is_error()) return session_status;
+
+        const u64 content_hash = stable_hash(source, session_info.options_hash);
+        const std::string fake_path = std::format("module_{0:016x}.fakepath", content_hash);
+        const std::filesystem::path cache_path = internal->cache_directory.empty() ? std::filesystem::path() : internal->cache_directory / std::format("{0:016x}.slang-module", content_hash);
+
+        if (!cache_path.empty())
+        {
+            //The key only covers this module's source, so entries also record the modules it imported, and are stale if any of them changed.
+            std::vector<u8> cached_module;
+            u64 module_offset = 0;
+            u64 dependency_hash = STABLE_HASH_SEED;
+            if (read_cache_file(cache_path, cached_module) && read_module_cache_header(cached_module, module_offset, dependency_hash))
+            {
+                Slang::ComPtr<slang::IBlob> diagnostics;
+                Slang::ComPtr<slang::IBlob> cached_blob;
+                cached_blob.attach(slang_createBlob(cached_module.data() + module_offset, cached_module.size() - module_offset));
+                const Slang::ComPtr cached(session_info.session->loadModuleFromIRBlob(fake_path.c_str(), fake_path.c_str(), cached_blob, diagnostics.writeRef()));
+
+                //A stale or corrupt cache entry just falls through to compiling the source again, which replaces it.
+                if (cached && !diagnostics)
+                {
+                    out_shader_module = shader_module(std::make_unique<shader_module::shader_module_internal>(cached, fake_path, stable_hash(&dependency_hash, sizeof(u64), content_hash), macro_hash));
+                    return status_type::SUCCESS;
+                }
+            }
+        }
+
         Slang::ComPtr<slang::IBlob> diagnostics;
-        const Slang::ComPtr module(this->internal->session->loadModuleFromSourceString(fake_path.c_str(), fake_path.c_str(), source.data(), diagnostics.writeRef()));
+        const Slang::ComPtr module(session_info.session->loadModuleFromSourceString(fake_path.c_str(), fake_path.c_str(), source.data(), diagnostics.writeRef()));
 
         if (diagnostics)
         {
@@ -146,7 +525,27 @@ namespace stardraw
             return {status_type::BACKEND_ERROR, std::format("Slang module loading failed with error: '{0}'", msg)};
         }
 
-        out_shader_module = shader_module(std::make_unique<shader_module::shader_module_internal>(module, fake_path));
+        //Imported modules are folded into the module's hash too, so shader stages cached from it are invalidated along with it.
+        //The hash only matters to the module and stage caches, which share the cache directory, so imports aren't read without one.
+        u64 dependency_hash = STABLE_HASH_SEED;
+        if (!cache_path.empty())
+        {
+            std::vector<u8> cache_data;
+            Slang::ComPtr<ISlangBlob> serialized_blob;
+            if (!write_module_cache_header(module, fake_path, cache_data, dependency_hash))
+            {
+                //A module whose imports can't be read isn't cached, so don't leave a partially combined hash behind.
+                dependency_hash = STABLE_HASH_SEED;
+            }
+            else if (SLANG_SUCCEEDED(module->serialize(serialized_blob.writeRef())))
+            {
+                const u8* serialized_ptr = static_cast<const u8*>(serialized_blob->getBufferPointer());
+                cache_data.insert(cache_data.end(), serialized_ptr, serialized_ptr + serialized_blob->getBufferSize());
+                write_cache_file(cache_path, cache_data.data(), cache_data.size());
+            }
+        }
+
+        out_shader_module = shader_module(std::make_unique<shader_module::shader_module_internal>(module, fake_path, stable_hash(&dependency_hash, sizeof(u64), content_hash), macro_hash));
 
         return status_type::SUCCESS;
     }
@@ -154,11 +553,17 @@ namespace stardraw
     status shader_compiler_context::load_shader_module(const void* cache_ptr, const u64 cache_size, shader_module& out_shader_module) const
     {
         ZoneScoped;
-        if (this->internal->session == nullptr) return {status_type::INVALID, "Shader compiler not initialized"};
+        if (this->internal->context == nullptr) return {status_type::INVALID, "Shader compiler not initialized"};
+
+        std::scoped_lock global_guard(get_global_session().lock);
+        slang_session_info session_info;
+        const status session_status = internal->get_session(internal->macro_hash, session_info);
+        if (session_status.is_error()) return session_status;
+
         const std::string fake_path = std::format("module_{0}.fakepath", std::hash<const void*>()(cache_ptr));
         Slang::ComPtr<slang::IBlob> diagnostics;
 
-        const Slang::ComPtr module(this->internal->session->loadModuleFromIRBlob(fake_path.c_str(), fake_path.c_str(), slang_createBlob(cache_ptr, cache_size), diagnostics.writeRef()));
+        const Slang::ComPtr module(session_info.session->loadModuleFromIRBlob(fake_path.c_str(), fake_path.c_str(), slang_createBlob(cache_ptr, cache_size), diagnostics.writeRef()));
 
         if (diagnostics)
         {
@@ -171,7 +576,7 @@ namespace stardraw
             return {status_type::BACKEND_ERROR, std::format("Slang module loading failed with unknwon error")};
         }
 
-        out_shader_module = shader_module(std::make_unique<shader_module::shader_module_internal>(module, fake_path));
+        out_shader_module = shader_module(std::make_unique<shader_module::shader_module_internal>(module, fake_path, stable_hash(cache_ptr, cache_size, internal->options_hash), internal->macro_hash));
 
         return status_type::SUCCESS;
     }
@@ -180,6 +585,7 @@ namespace stardraw
     {
         ZoneScoped;
         if (module.internal == nullptr) return {status_type::UNEXPECTED, "Module is invalid!"};
+        std::scoped_lock global_guard(get_global_session().lock);
         const Slang::ComPtr<slang::IModule> inner_module = module.internal->slang_module;
 
         Slang::ComPtr<ISlangBlob> serialized_blob;
@@ -201,13 +607,27 @@ namespace stardraw
         ZoneScoped;
         std::vector<slang::IComponentType*> shader_components;
         std::unordered_map<shader_entry_point, u32> entry_point_index_map;
+        u64 link_hash = STABLE_HASH_SEED;
+
+        //Link in the session for the modules' macros - modules loaded with other macros are imported into it.
+        u64 macro_hash = internal->macro_hash;
+        if (!entry_points.empty() && entry_points[0].module.internal != nullptr) macro_hash = entry_points[0].module.internal->macro_hash;
+        else if (!additional_modules.empty() && additional_modules[0].internal != nullptr) macro_hash = additional_modules[0].internal->macro_hash;
+
+        std::scoped_lock global_guard(get_global_session().lock);
+        slang_session_info session_info;
+        const status session_status = internal->get_session(macro_hash, session_info);
+        if (session_status.is_error()) return session_status;
+        slang::ISession* session = session_info.session;
 
         for (u32 idx = 0; idx < entry_points.size(); idx++)
         {
             const shader_entry_point& entry_point = entry_points[idx];
 
             if (entry_point.module.internal == nullptr) return {status_type::UNEXPECTED, std::format("Module for entry point '{0}' is invalid!", entry_point.entry_point_name)};
-            const Slang::ComPtr<slang::IModule> inner_module = entry_point.module.internal->slang_module;
+            Slang::ComPtr<slang::IModule> inner_module;
+            const status import_status = internal->import_module(entry_point.module, session, inner_module);
+            if (import_status.is_error()) return import_status;
 
             Slang::ComPtr<slang::IEntryPoint> slang_entry_point;
 
@@ -216,18 +636,28 @@ namespace stardraw
 
             shader_components.push_back(slang_entry_point);
             entry_point_index_map[entry_point] = idx;
+
+            link_hash = stable_hash(&entry_point.module.internal->content_hash, sizeof(u64), link_hash);
+            link_hash = stable_hash(entry_point.entry_point_name, link_hash);
+            link_hash = stable_hash(";", link_hash);
         }
 
         for (const shader_module& additional_module : additional_modules)
         {
-            shader_components.push_back(additional_module.internal->slang_module);
+            if (additional_module.internal == nullptr) return {status_type::UNEXPECTED, "Additional module is invalid!"};
+            Slang::ComPtr<slang::IModule> inner_module;
+            const status import_status = internal->import_module(additional_module, session, inner_module);
+            if (import_status.is_error()) return import_status;
+
+            shader_components.push_back(inner_module);
+            link_hash = stable_hash(&additional_module.internal->content_hash, sizeof(u64), link_hash);
         }
 
         Slang::ComPtr<slang::IComponentType> composite;
 
         {
             Slang::ComPtr<slang::IBlob> diagnostics;
-            this->internal->session->createCompositeComponentType(shader_components.data(), shader_components.size(), composite.writeRef(), diagnostics.writeRef());
+            session->createCompositeComponentType(shader_components.data(), shader_components.size(), composite.writeRef(), diagnostics.writeRef());
 
             if (diagnostics)
             {
@@ -249,11 +679,14 @@ namespace stardraw
             }
         }
 
+        std::scoped_lock guard(internal->lock);
         internal->linked_programs.push_back(linked_program); //We need to hang on to the references so the lifetimes of pointers obtained via the linked program are kept alive until the shader compiler is cleaned up.
-        out_linked_shader = shader_program(std::make_unique<shader_program::shader_program_internal>(linked_program, std::move(entry_point_index_map)));
+        out_linked_shader = shader_program(std::make_unique<shader_program::shader_program_internal>(linked_program, std::move(entry_point_index_map), link_hash));
         return status_type::SUCCESS;
     }
 
+    std::unique_ptr<shader_reflection_index> build_reflection_index(slang::ShaderReflection* reflection);
+
     shader_stage_type to_shader_stage_type(const SlangStage slang_stage)
     {
         switch (slang_stage)
@@ -273,6 +706,7 @@ namespace stardraw
 
         const shader_stage result = shader_stage(std::make_shared<shader_stage::shader_stage_internal>());
 
+        std::scoped_lock global_guard(get_global_session().lock);
         const Slang::ComPtr<slang::IComponentType> linked_shader_component = linked_shader.internal->linked_components;
 
         if (!linked_shader.internal->entry_point_indexes.contains(entry_point)) return {status_type::UNKNOWN, "Entry point not found in linked shader"};
@@ -281,6 +715,8 @@ namespace stardraw
         const int target_index = get_target_index_for_api(api);
         if (target_index == -1) return {status_type::UNSUPPORTED, "API selected is not currently supported for slang shaders"};
 
+        //Layout reflection stays live (it's cheap once modules are loaded, and callers need it to locate parameters) but the generated code is cached.
+        SlangStage stage_slang_type;
         {
             Slang::ComPtr<slang::IBlob> diagnostics;
             slang::ShaderReflection* layout = linked_shader_component->getLayout(target_index, diagnostics.writeRef());
@@ -291,10 +727,45 @@ namespace stardraw
                 return {status_type::BACKEND_ERROR, std::format("Slang shader layout reflection failed with error: '{0}'", msg)};
             }
 
-            result.internal->reflection = layout;
-            result.internal->type = to_shader_stage_type(layout->getEntryPointByIndex(entry_point_idx)->getStage());
+            std::scoped_lock guard(internal->lock);
+            std::unique_ptr<shader_reflection_index>& parameters = internal->reflection_indexes[layout];
+            if (parameters == nullptr) parameters = build_reflection_index(layout);
+            result.internal->parameters = parameters.get();
+            stage_slang_type = layout->getEntryPointByIndex(entry_point_idx)->getStage();
+        }
+
+        u64 stage_key = stable_hash(&linked_shader.internal->link_hash, sizeof(u64));
+        stage_key = stable_hash(&entry_point_idx, sizeof(u32), stage_key);
+        stage_key = stable_hash(&target_index, sizeof(int), stage_key);
+        const std::filesystem::path cache_path = internal->cache_directory.empty() ? std::filesystem::path() : internal->cache_directory / std::format("{0:016x}.slang-stage", stage_key);
+
+        if (!cache_path.empty())
+        {
+            std::vector<u8> cached_stage;
+            if (read_cache_file(cache_path, cached_stage) && cached_stage.size() >= sizeof(shader_stage_cache_header))
+            {
+                shader_stage_cache_header header;
+                memcpy(&header, cached_stage.data(), sizeof(shader_stage_cache_header));
+
+                const bool is_valid = header.magic == SHADER_STAGE_CACHE_MAGIC && header.version == SHADER_STAGE_CACHE_VERSION && header.key == stage_key
+                                      && cached_stage.size() == sizeof(shader_stage_cache_header) + header.data_size;
+
+                if (is_valid)
+                {
+                    result.internal->api = api;
+                    result.internal->type = static_cast<shader_stage_type>(header.stage_type);
+                    result.internal->data_size = header.data_size;
+                    result.internal->data = malloc(header.data_size);
+                    memcpy(result.internal->data, cached_stage.data() + sizeof(shader_stage_cache_header), header.data_size);
+
+                    out_shader_stage = result;
+                    return status_type::SUCCESS;
+                }
+            }
         }
 
+        result.internal->type = to_shader_stage_type(stage_slang_type);
+
         {
             Slang::ComPtr<slang::IBlob> shader_blob;
             Slang::ComPtr<slang::IBlob> diagnostics;
@@ -318,6 +789,22 @@ namespace stardraw
             memcpy(result.internal->data, shader_blob->getBufferPointer(), result.internal->data_size);
         }
 
+        if (!cache_path.empty())
+        {
+            const shader_stage_cache_header header {
+                .magic = SHADER_STAGE_CACHE_MAGIC,
+                .version = SHADER_STAGE_CACHE_VERSION,
+                .key = stage_key,
+                .stage_type = static_cast<u32>(result.internal->type),
+                .data_size = result.internal->data_size,
+            };
+
+            std::vector<u8> cache_data(sizeof(shader_stage_cache_header) + result.internal->data_size);
+            memcpy(cache_data.data(), &header, sizeof(shader_stage_cache_header));
+            memcpy(cache_data.data() + sizeof(shader_stage_cache_header), result.internal->data, result.internal->data_size);
+            write_cache_file(cache_path, cache_data.data(), cache_data.size());
+        }
+
         out_shader_stage = result;
 
         return status_type::SUCCESS;
@@ -390,41 +877,102 @@ namespace stardraw
         return results;
     }
 
-    shader_module::~shader_module() = default;
-    shader_program::~shader_program() = default;
-
-    shader_parameter_location shader_parameter_location::index(const u32 index) const
+    memory_layout_info layout_for_buffer_element(slang::TypeLayoutReflection* base_layout)
     {
         ZoneScoped;
-        if (internal == nullptr)
+        memory_layout_info layout;
+        layout.padded_size = base_layout->getStride();
+
+        u64 current_offset = 0;
+        u64 packed_size = 0;
+
+        const std::vector<struct_field_location> fields = flatten_structure(base_layout);
+
+        for (const struct_field_location& field : fields)
         {
-            shader_parameter_location result = shader_parameter_location(*this);
-            result.internal->is_valid = false;
-            result.internal->path_string += std::format("[{0}]", index);
-            return result;
+            if (field.offset > current_offset)
+            {
+                layout.pads.push_back({current_offset, field.offset - current_offset});
+                current_offset = field.offset;
+            }
+
+            packed_size += field.size;
+            current_offset += field.size;
         }
 
-        slang::TypeLayoutReflection* type_layout = internal->offset_ptr;
-        slang::TypeLayoutReflection* element_layout = type_layout->getElementTypeLayout();
-        if (element_layout == nullptr)
+        //Padding at the end of the structure?
+        if (current_offset < layout.padded_size)
         {
-            shader_parameter_location result = shader_parameter_location(*this);
-            result.internal->is_valid = false;
-            result.internal->path_string += std::format("[{0}]", index);
-            return result;
+            layout.pads.push_back({current_offset, layout.padded_size - current_offset});
         }
 
-        shader_parameter_location result = shader_parameter_location(*this);
-        result.internal->offset_ptr = element_layout;
-        result.internal->byte_address += index * element_layout->getStride();
-        result.internal->binding_range_index *= type_layout->getElementCount();
-        result.internal->binding_range_index += index;
-        result.internal->path_string += std::format("[{0}]", index);
-        return result;
+        layout.packed_size = packed_size;
+        return layout;
     }
 
+    shader_module::~shader_module() = default;
+    shader_program::~shader_program() = default;
+
     shader_compiler_context::~shader_compiler_context() = default;
 
+    ///Invalid locations only keep the last valid entry they navigated through (if any), so failed lookups never allocate or grow any shared state.
+    static shader_parameter_location make_invalid_location(const shader_reflection_index* reflection, const u32 last_valid_entry)
+    {
+        return {reflection, last_valid_entry, 0, 0, false};
+    }
+
+    shader_parameter_location shader_parameter_location::index(const u32 index) const
+    {
+        ZoneScoped;
+        if (!valid) return *this;
+
+        const shader_reflection_entry& current = reflection->entries[entry];
+        if (current.element_entry == u32_max) return make_invalid_location(reflection, entry);
+
+        shader_parameter_location result = *this;
+        result.entry = current.element_entry;
+        result.element_offset += index * current.element_stride;
+        result.array_index = array_index * current.element_count + index;
+        return result;
+    }
+
+    shader_parameter_location shader_parameter_location::field(const std::string_view& name) const
+    {
+        ZoneScoped;
+        if (!valid) return *this;
+
+        const shader_reflection_entry& current = reflection->entries[entry];
+        const auto field_ptr = current.fields.find(name);
+        if (field_ptr == current.fields.end()) return make_invalid_location(reflection, entry);
+
+        shader_parameter_location result = *this;
+        result.entry = field_ptr->second;
+        return result;
+    }
+
+    bool shader_parameter_location::is_valid() const
+    {
+        return valid;
+    }
+
+    std::string_view shader_parameter_location::path() const
+    {
+        if (reflection == nullptr || entry == u32_max) return "???";
+        return reflection->entries[entry].path;
+    }
+
+    shader_parameter_location shader_stage::locate(const std::string_view& name) const
+    {
+        ZoneScoped;
+        if (internal == nullptr || internal->parameters == nullptr) return make_invalid_location(nullptr, u32_max);
+
+        const auto root_ptr = internal->parameters->roots.find(name);
+        if (root_ptr == internal->parameters->roots.end()) return make_invalid_location(internal->parameters, u32_max);
+
+        return {internal->parameters, root_ptr->second, 0, 0, true};
+    }
+
+
     bool is_single_element_container_kind(const slang::TypeReflection::Kind kind)
     {
         switch (kind)
@@ -444,131 +992,99 @@ namespace stardraw
         }
     }
 
-    shader_parameter_location shader_parameter_location::field(const std::string_view& name) const
+    i64 shader_stage::buffer_size(const std::string_view& name) const
     {
         ZoneScoped;
-        if (internal == nullptr)
-        {
-            shader_parameter_location result = shader_parameter_location(*this);
-            result.internal->is_valid = false;
-            result.internal->path_string += std::format(".{0}", name);
-            return result;
-        }
+        if (internal == nullptr || internal->parameters == nullptr) return -1;
+        const auto buffer_ptr = internal->parameters->buffers.find(name);
+        if (buffer_ptr == internal->parameters->buffers.end()) return -1;
+        return buffer_ptr->second.size;
+    }
 
-        slang::TypeLayoutReflection* type_layout = internal->offset_ptr;
+    static status validate_layout_fields(const shader_reflection_index& index, const shader_reflection_entry& entry, const std::vector<buffer_layout_field>& fields)
+    {
+        //Field maps are unordered, but fields in a structure are always laid out in declaration order.
+        std::vector<const shader_reflection_entry*> reflected_fields;
+        for (const u32 field_entry : entry.fields | std::views::values) reflected_fields.push_back(&index.entries[field_entry]);
+        std::ranges::sort(reflected_fields, {}, &shader_reflection_entry::byte_address);
 
-        if (is_single_element_container_kind(type_layout->getKind())) type_layout = type_layout->getElementTypeLayout();
+        if (reflected_fields.size() != fields.size()) return {status_type::INVALID, std::format("Buffer layout for '{0}' has {1} fields, but the shader has {2}", entry.path, fields.size(), reflected_fields.size())};
 
-        const i32 index = type_layout->findFieldIndexByName(name.data(), name.data() + name.size());
-        if (index < 0)
+        for (u32 idx = 0; idx < fields.size(); idx++)
         {
-            shader_parameter_location result = shader_parameter_location(*this);
-            result.internal->is_valid = false;
-            result.internal->path_string += std::format(".{0}", name);
-            return result;
-        }
+            const shader_reflection_entry& reflected = *reflected_fields[idx];
+            const buffer_layout_field& field = fields[idx];
 
-        slang::VariableLayoutReflection* field = type_layout->getFieldByIndex(index);
+            if (reflected.byte_address != field.offset) return {status_type::INVALID, std::format("Buffer layout puts '{0}' at offset {1}, but the shader has it at offset {2}", reflected.path, field.offset, reflected.byte_address)};
 
-        shader_parameter_location result = shader_parameter_location(*this);
-        result.internal->offset_ptr = field->getTypeLayout();
-        result.internal->byte_address += field->getOffset();
-        result.internal->binding_range += type_layout->getFieldBindingRangeOffset(index);
-        result.internal->path_string += std::format(".{0}", name);
-        return result;
-    }
+            if (field.element_count != 0)
+            {
+                if (reflected.element_entry == u32_max) return {status_type::INVALID, std::format("Buffer layout has an array for '{0}', but the shader doesn't", reflected.path)};
+                if (reflected.element_count != field.element_count || reflected.element_stride != field.element_stride)
+                {
+                    return {status_type::INVALID, std::format("Buffer layout has {1} elements with a stride of {2} for '{0}', but the shader has {3} with a stride of {4}", reflected.path, field.element_count, field.element_stride, reflected.element_count, reflected.element_stride)};
+                }
 
-    shader_parameter_location::shader_parameter_location(const shader_parameter_location& other) : internal(std::make_unique<shader_parameter_location_internal>(*other.internal)) {}
+                if (field.fields.empty()) continue;
+                const status element_status = validate_layout_fields(index, index.entries[reflected.element_entry], field.fields);
+                if (element_status.is_error()) return element_status;
+                continue;
+            }
 
-    shader_parameter_location& shader_parameter_location::operator=(const shader_parameter_location& other)
-    {
-        if (this == &other) return *this;
-        if (other.internal != nullptr) internal = std::make_unique<shader_parameter_location_internal>(*other.internal);
-        else internal = std::make_unique<shader_parameter_location_internal>();
-        return *this;
-    }
+            if (field.fields.empty())
+            {
+                if (reflected.size != field.size) return {status_type::INVALID, std::format("Buffer layout gives '{0}' a size of {1}, but the shader's is {2}", reflected.path, field.size, reflected.size)};
+                continue;
+            }
 
-    shader_parameter_location::shader_parameter_location(shader_parameter_location&& other) noexcept : internal(std::move(other.internal)) {}
+            const status struct_status = validate_layout_fields(index, reflected, field.fields);
+            if (struct_status.is_error()) return struct_status;
+        }
 
-    shader_parameter_location& shader_parameter_location::operator=(shader_parameter_location&& other) noexcept
-    {
-        if (this == &other) return *this;
-        internal = std::move(other.internal);
-        return *this;
+        return status_type::SUCCESS;
     }
 
-    bool shader_parameter_location::operator==(const shader_parameter_location& other) const
-    {
-        if (internal == nullptr || other.internal == nullptr) return internal == other.internal;
-        return *internal == *other.internal;
-    }
-
-    shader_parameter_location::shader_parameter_location(std::unique_ptr<shader_parameter_location_internal>&& internal) : internal(std::move(internal)) {}
-    shader_parameter_location::~shader_parameter_location() = default;
-
-    shader_parameter_location shader_stage::locate(const std::string_view& name) const
+    status shader_stage::validate_buffer_layout(const shader_buffer_layout& layout) const
     {
         ZoneScoped;
-        if (internal == nullptr)
-        {
-            return
-                shader_parameter_location {
-                    std::make_unique<shader_parameter_location::shader_parameter_location_internal>(
-                        shader_parameter_location::shader_parameter_location_internal {
-                            .path_string = std::string(name),
-                            .is_valid = false,
-                        }
-                    )
-                };
-        }
-
-        slang::VariableLayoutReflection* globals_as_var = internal->reflection->getGlobalParamsVarLayout();
-        slang::TypeLayoutReflection* globals = globals_as_var->getTypeLayout();
-        const i64 field_idx = globals->findFieldIndexByName(name.data(), name.data() + name.size());
-        slang::VariableLayoutReflection* root_param = field_idx < 0 ? nullptr : globals->getFieldByIndex(field_idx);
-        if (root_param == nullptr)
-        {
-            shader_parameter_location result {
-                std::make_unique<shader_parameter_location::shader_parameter_location_internal>(
-                    shader_parameter_location::shader_parameter_location_internal {
-                        .path_string = std::string(name),
-                        .is_valid = false,
-                    }
-                )
-            };
+        if (internal == nullptr || internal->parameters == nullptr) return {status_type::UNEXPECTED, "Shader stage is not valid!"};
+        const shader_reflection_index& index = *internal->parameters;
+
+        const auto root_ptr = index.roots.find(layout.buffer_name);
+        const auto buffer_ptr = index.buffers.find(layout.buffer_name);
+        if (root_ptr == index.roots.end() || buffer_ptr == index.buffers.end()) return {status_type::UNKNOWN, std::format("Couldn't find buffer by name '{0}'", layout.buffer_name)};
 
-            return result;
+        if (buffer_ptr->second.layout.padded_size != layout.size)
+        {
+            return {status_type::INVALID, std::format("Buffer layout for '{0}' is {1} bytes, but the shader's is {2}", layout.buffer_name, layout.size, buffer_ptr->second.layout.padded_size)};
         }
 
-        shader_parameter_location result {
-            std::make_unique<shader_parameter_location::shader_parameter_location_internal>(
-                shader_parameter_location::shader_parameter_location_internal {
-                    .root_ptr = root_param,
-                    .offset_ptr = root_param->getTypeLayout(),
-                    .root_idx = static_cast<u64>(field_idx),
-                    .byte_address = 0,
-                    .binding_range = 0,
-                    .binding_range_index = 0,
-                    .path_string = std::string(name),
-                }
-            )
-        };
+        //Constant buffers expose the fields of their element directly, other buffers (structured, etc) only through their element.
+        const shader_reflection_entry* buffer_entry = &index.entries[root_ptr->second];
+        if (buffer_entry->fields.empty() && buffer_entry->element_entry != u32_max) buffer_entry = &index.entries[buffer_entry->element_entry];
 
-        return result;
+        return validate_layout_fields(index, *buffer_entry, layout.fields);
     }
 
-    i64 shader_stage::buffer_size(const std::string_view& name) const
+    status validate_shader_buffer_layouts(const std::vector<shader_stage>& stages, const std::vector<shader_buffer_layout>& layouts)
     {
         ZoneScoped;
-        if (internal == nullptr) return -1;
-        slang::TypeLayoutReflection* globals = internal->reflection->getGlobalParamsTypeLayout();
-        const i64 global_idx = globals->findFieldIndexByName(name.data(), name.data() + name.size());
-        if (global_idx < 0) return -1;
+        for (const shader_buffer_layout& layout : layouts)
+        {
+            bool found = false;
+            for (const shader_stage& stage : stages)
+            {
+                if (!stage.locate(layout.buffer_name).is_valid()) continue;
+                found = true;
 
-        slang::VariableLayoutReflection* root_param = globals->getFieldByIndex(global_idx);
-        if (root_param == nullptr) return -1;
-        const size_t size = root_param->getTypeLayout()->getElementTypeLayout()->getSize();
-        return size == ~static_cast<size_t>(0) ? -1 : size; //Slang encodes unsized types as max value, we convert that to -1.
+                const status validate_status = stage.validate_buffer_layout(layout);
+                if (validate_status.is_error()) return validate_status;
+            }
+
+            if (!found) return {status_type::UNKNOWN, std::format("Couldn't find buffer by name '{0}' in any shader stage", layout.buffer_name)};
+        }
+
+        return status_type::SUCCESS;
     }
 
     shader_stage_type shader_stage::get_stage_type() const
@@ -576,48 +1092,30 @@ namespace stardraw
         return internal->type;
     }
 
-    shader_stage::~shader_stage() = default;
-
-    status shader_compiler_context::determine_shader_buffer_layout(const shader_stage& program, const std::string_view& buffer_name, memory_layout_info& out_buffer_layout) const
+    shader_stage shader_stage::specialize(const std::vector<shader_specialization_constant>& constants) const
     {
         ZoneScoped;
-        if (program.internal == nullptr) return {status_type::UNEXPECTED, "Shader program is not valid!"};
-        slang::ShaderReflection* shader_layout = program.internal->reflection;
-
-        slang::TypeLayoutReflection* globals = shader_layout->getGlobalParamsTypeLayout();
-        const i64 global_idx = globals->findFieldIndexByName(buffer_name.data(), buffer_name.data() + buffer_name.size());
-        if (global_idx < 0) return {status_type::UNKNOWN, std::format("Couldn't find buffer by name '{0}'", buffer_name)};
-        slang::VariableLayoutReflection* root_param = globals->getFieldByIndex(global_idx);
-        if (root_param == nullptr) return {status_type::UNKNOWN, std::format("Couldn't find buffer by name '{0}'", buffer_name)};
-
-        slang::TypeLayoutReflection* base_layout = root_param->getTypeLayout()->getElementTypeLayout();
-        out_buffer_layout.padded_size = base_layout->getStride();
-
-        u64 current_offset = 0;
-        u64 packed_size = 0;
-
-        const std::vector<struct_field_location> fields = flatten_structure(base_layout);
-
-        for (const struct_field_location& field : fields)
+        shader_stage result = *this;
+        for (const shader_specialization_constant& constant : constants)
         {
-            if (field.offset > current_offset)
-            {
-                out_buffer_layout.pads.push_back({current_offset, field.offset - current_offset});
-                current_offset = field.offset;
-            }
-
-            packed_size += field.size;
-            current_offset += field.size;
+            const auto existing = std::ranges::find(result.specialization_constants, constant.id, &shader_specialization_constant::id);
+            if (existing != result.specialization_constants.end()) existing->value_bits = constant.value_bits;
+            else result.specialization_constants.push_back(constant);
         }
+        return result;
+    }
 
-        //Padding at the end of the structure?
-        if (current_offset < out_buffer_layout.padded_size)
-        {
-            out_buffer_layout.pads.push_back({current_offset, out_buffer_layout.padded_size - current_offset});
-        }
+    shader_stage::~shader_stage() = default;
+
+    status shader_compiler_context::determine_shader_buffer_layout(const shader_stage& program, const std::string_view& buffer_name, memory_layout_info& out_buffer_layout)
+    {
+        ZoneScoped;
+        if (program.internal == nullptr || program.internal->parameters == nullptr) return {status_type::UNEXPECTED, "Shader program is not valid!"};
 
-        out_buffer_layout.packed_size = packed_size;
+        const auto buffer_ptr = program.internal->parameters->buffers.find(buffer_name);
+        if (buffer_ptr == program.internal->parameters->buffers.end()) return {status_type::UNKNOWN, std::format("Couldn't find buffer by name '{0}'", buffer_name)};
 
+        out_buffer_layout = buffer_ptr->second.layout;
         return status_type::SUCCESS;
     }
 
@@ -649,12 +1147,32 @@ namespace stardraw
         }
     }
 
-    binding_location_info vk_binding_for_location(const shader_parameter_location& location)
+    ///Position reached while walking the reflection of a shader parameter
+    struct reflection_walk_state
+    {
+        slang::VariableLayoutReflection* root_ptr;
+        slang::TypeLayoutReflection* type_ptr;
+        u64 byte_address;
+        u64 binding_range;
+    };
+
+    constexpr u32 MAX_REFLECTION_DEPTH = 32;
+
+    binding_location_info make_binding_location(const i64 set, const i64 slot, slang::TypeLayoutReflection* binding_layout, slang::TypeLayoutReflection* location_layout, const u64 byte_address)
+    {
+        const slang::TypeReflection::Kind kind = binding_layout->getKind();
+        const bool is_resource = kind == slang::TypeReflection::Kind::Resource;
+        const SlangResourceShape shape = is_resource ? binding_layout->getResourceShape() : SLANG_RESOURCE_NONE;
+        const SlangResourceAccess access = is_resource ? binding_layout->getResourceAccess() : SLANG_RESOURCE_ACCESS_NONE;
+        return {set, slot, kind, shape, access, binding_layout == location_layout, byte_address};
+    }
+
+    binding_location_info vk_binding_for_walk_state(const reflection_walk_state& state)
     {
         ZoneScoped;
-        slang::VariableLayoutReflection* root_var = location.internal->root_ptr;
+        slang::VariableLayoutReflection* root_var = state.root_ptr;
         slang::TypeLayoutReflection* root_layout = root_var->getTypeLayout();
-        slang::TypeLayoutReflection* selected_layout = location.internal->offset_ptr;
+        slang::TypeLayoutReflection* selected_layout = state.type_ptr;
 
         const bool inside_parameter_block = root_layout->getKind() == slang::TypeReflection::Kind::ParameterBlock;
         const bool is_parameter_block = root_var->getTypeLayout() == selected_layout && inside_parameter_block;
@@ -667,7 +1185,7 @@ namespace stardraw
             //This won't work for that case if it exists
             const SlangInt set = root_var->getBindingSpace(slang::ParameterCategory::DescriptorTableSlot);
             const SlangInt slot = root_var->getOffset(slang::DescriptorTableSlot);
-            return {set, slot, root_layout};
+            return make_binding_location(set, slot, root_layout, selected_layout, state.byte_address);
         }
 
         if (!does_consume_bindings || is_parameter_block)
@@ -678,14 +1196,14 @@ namespace stardraw
                 //They cannot have an explicit attribute for the binding slot, since they can contain multiple opaque types.
                 //The binding slot for plain data within a parameter block is always 0 (automatically introduced constant buffer)
                 const SlangInt set_offset = root_var->getOffset(slang::ParameterCategory::SubElementRegisterSpace);
-                return {set_offset, 0, root_layout};
+                return make_binding_location(set_offset, 0, root_layout, selected_layout, state.byte_address);
             }
 
             //Plain data outside of a parameter block (probably within a constant/structured/etc buffer) is part of the root binding
             const SlangInt set_offset = root_var->getBindingSpace(slang::ParameterCategory::DescriptorTableSlot);
             const SlangInt slot_offset = root_var->getOffset(slang::DescriptorTableSlot);
 
-            return {set_offset, slot_offset, root_layout};
+            return make_binding_location(set_offset, slot_offset, root_layout, selected_layout, state.byte_address);
         }
 
         //Inside a parameter block and DOES have its own binding - get binding data by binding range.
@@ -697,13 +1215,103 @@ namespace stardraw
         const SlangInt set_offset = root_var->getOffset(slang::ParameterCategory::SubElementRegisterSpace);
 
         //Slang binding range -> Slang descriptor set indexes
-        const SlangInt slang_binding_set = root_element_layout->getBindingRangeDescriptorSetIndex(location.internal->binding_range);
-        const SlangInt slang_binding_slot = root_element_layout->getBindingRangeFirstDescriptorRangeIndex(location.internal->binding_range);
+        const SlangInt slang_binding_set = root_element_layout->getBindingRangeDescriptorSetIndex(state.binding_range);
+        const SlangInt slang_binding_slot = root_element_layout->getBindingRangeFirstDescriptorRangeIndex(state.binding_range);
 
         //Slang descriptor set indexes -> actual VK descriptor set / slot.
         const SlangInt set = root_element_layout->getDescriptorSetSpaceOffset(slang_binding_set) + set_offset;
         const SlangInt slot = root_element_layout->getDescriptorSetDescriptorRangeIndexOffset(slang_binding_set, slang_binding_slot);
 
-        return {set, slot, selected_layout};
+        return make_binding_location(set, slot, selected_layout, selected_layout, state.byte_address);
+    }
+
+    u32 add_reflection_entries(shader_reflection_index& index, const reflection_walk_state& state, std::string&& path, const u32 depth)
+    {
+        const binding_location_info binding = vk_binding_for_walk_state(state);
+        const u32 entry_idx = index.entries.size();
+
+        index.entries.push_back(shader_reflection_entry {
+            .path = std::move(path),
+            .binding_kind = binding.binding_kind,
+            .binding_shape = binding.binding_shape,
+            .binding_access = binding.binding_access,
+            .is_binding = binding.is_binding,
+            .set = binding.set,
+            .slot = binding.slot,
+            .byte_address = state.byte_address,
+            .size = state.type_ptr->getSize(),
+        });
+
+        slang::TypeLayoutReflection* type_layout = state.type_ptr;
+        const slang::TypeReflection::Kind kind = type_layout->getKind();
+
+        //Pointers can refer back to the type containing them, so they (and anything absurdly deep) aren't expanded.
+        if (depth >= MAX_REFLECTION_DEPTH || kind == slang::TypeReflection::Kind::Pointer) return entry_idx;
+
+        slang::TypeLayoutReflection* element_layout = type_layout->getElementTypeLayout();
+        if (element_layout != nullptr)
+        {
+            const reflection_walk_state element_state {state.root_ptr, element_layout, state.byte_address, state.binding_range};
+            const u32 element_entry = add_reflection_entries(index, element_state, std::format("{0}[]", index.entries[entry_idx].path), depth + 1);
+
+            shader_reflection_entry& entry = index.entries[entry_idx];
+            entry.element_entry = element_entry;
+            entry.element_count = type_layout->getElementCount();
+            entry.element_stride = element_layout->getStride();
+
+            //Fields of buffers and blocks are accessed directly, which is the same as accessing the fields of their only element.
+            if (is_single_element_container_kind(kind))
+            {
+                entry.fields = index.entries[element_entry].fields;
+                return entry_idx;
+            }
+        }
+
+        for (u32 field_idx = 0; field_idx < type_layout->getFieldCount(); field_idx++)
+        {
+            slang::VariableLayoutReflection* field = type_layout->getFieldByIndex(field_idx);
+            const char* field_name = field->getName();
+            if (field_name == nullptr) continue;
+
+            const reflection_walk_state field_state {state.root_ptr, field->getTypeLayout(), state.byte_address + field->getOffset(), state.binding_range + type_layout->getFieldBindingRangeOffset(field_idx)};
+            const u32 field_entry = add_reflection_entries(index, field_state, std::format("{0}.{1}", index.entries[entry_idx].path, field_name), depth + 1);
+            index.entries[entry_idx].fields.emplace(field_name, field_entry);
+        }
+
+        return entry_idx;
+    }
+
+    std::unique_ptr<shader_reflection_index> build_reflection_index(slang::ShaderReflection* reflection)
+    {
+        ZoneScoped;
+        std::unique_ptr<shader_reflection_index> index = std::make_unique<shader_reflection_index>();
+        slang::TypeLayoutReflection* globals = reflection->getGlobalParamsTypeLayout();
+
+        for (u32 field_idx = 0; field_idx < globals->getFieldCount(); field_idx++)
+        {
+            slang::VariableLayoutReflection* root_param = globals->getFieldByIndex(field_idx);
+            const char* root_name = root_param->getName();
+            if (root_name == nullptr) continue;
+
+            const u32 root_entry = add_reflection_entries(*index, {root_param, root_param->getTypeLayout(), 0, 0}, std::string(root_name), 0);
+            index->roots.emplace(root_name, root_entry);
+
+            slang::TypeLayoutReflection* element_layout = root_param->getTypeLayout()->getElementTypeLayout();
+            if (element_layout == nullptr) continue;
+
+            const size_t size = element_layout->getSize();
+            index->buffers.emplace(root_name, shader_buffer_info {
+                .size = size == ~static_cast<size_t>(0) ? -1 : static_cast<i64>(size), //Slang encodes unsized types as max value, we convert that to -1.
+                .layout = layout_for_buffer_element(element_layout),
+            });
+        }
+
+        return index;
+    }
+
+    binding_location_info vk_binding_for_location(const shader_parameter_location& location)
+    {
+        const shader_reflection_entry& entry = location.reflection->entries[location.entry];
+        return {entry.set, entry.slot, entry.binding_kind, entry.binding_shape, entry.binding_access, entry.is_binding, entry.byte_address + location.element_offset};
     }
 }
@@ -0,0 +1,435 @@
+#include "../api/texture_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using pixel_data_type = texture_memory_transfer_info::pixel_data_type;
+    using pixel_channels = texture_memory_transfer_info::pixel_channels;
+
+    ///Maps a data format code used by a file format (a VkFormat or DXGI_FORMAT) to a texture data type, and the transfer format of uncompressed data.
+    struct file_format_mapping
+    {
+        u32 file_format;
+        texture_data_type data_type;
+        pixel_data_type pixel_type = pixel_data_type::U8;
+        pixel_channels channels = pixel_channels::RGBA;
+    };
+
+    static constexpr file_format_mapping vk_format_mappings[] = {
+        {9, texture_data_type::R_U8_NORM, pixel_data_type::U8, pixel_channels::R},
+        {16, texture_data_type::RG_U8_NORM, pixel_data_type::U8, pixel_channels::RG},
+        {23, texture_data_type::RGB_U8_NORM, pixel_data_type::U8, pixel_channels::RGB},
+        {29, texture_data_type::SRGB_U8_NORM, pixel_data_type::U8, pixel_channels::RGB},
+        {37, texture_data_type::RGBA_U8_NORM, pixel_data_type::U8, pixel_channels::RGBA},
+        {43, texture_data_type::SRGBA_U8_NORM, pixel_data_type::U8, pixel_channels::RGBA},
+        {100, texture_data_type::R_F32, pixel_data_type::F32, pixel_channels::R},
+        {103, texture_data_type::RG_F32, pixel_data_type::F32, pixel_channels::RG},
+        {106, texture_data_type::RGB_F32, pixel_data_type::F32, pixel_channels::RGB},
+        {109, texture_data_type::RGBA_F32, pixel_data_type::F32, pixel_channels::RGBA},
+        {131, texture_data_type::BC1_RGB}, {132, texture_data_type::BC1_SRGB},
+        {133, texture_data_type::BC1_RGBA}, {134, texture_data_type::BC1_SRGBA},
+        {135, texture_data_type::BC2_RGBA}, {136, texture_data_type::BC2_SRGBA},
+        {137, texture_data_type::BC3_RGBA}, {138, texture_data_type::BC3_SRGBA},
+        {139, texture_data_type::BC4_R}, {140, texture_data_type::BC4_R_SIGNED},
+        {141, texture_data_type::BC5_RG}, {142, texture_data_type::BC5_RG_SIGNED},
+        {143, texture_data_type::BC6H_RGB_UF16}, {144, texture_data_type::BC6H_RGB_F16},
+        {145, texture_data_type::BC7_RGBA}, {146, texture_data_type::BC7_SRGBA},
+        {147, texture_data_type::ETC2_RGB}, {148, texture_data_type::ETC2_SRGB},
+        {149, texture_data_type::ETC2_RGB_A1}, {150, texture_data_type::ETC2_SRGB_A1},
+        {151, texture_data_type::ETC2_RGBA}, {152, texture_data_type::ETC2_SRGBA},
+        {153, texture_data_type::EAC_R}, {154, texture_data_type::EAC_R_SIGNED},
+        {155, texture_data_type::EAC_RG}, {156, texture_data_type::EAC_RG_SIGNED},
+        {157, texture_data_type::ASTC_4X4_RGBA}, {158, texture_data_type::ASTC_4X4_SRGBA},
+        {165, texture_data_type::ASTC_6X6_RGBA}, {166, texture_data_type::ASTC_6X6_SRGBA},
+        {171, texture_data_type::ASTC_8X8_RGBA}, {172, texture_data_type::ASTC_8X8_SRGBA},
+    };
+
+    static constexpr file_format_mapping dxgi_format_mappings[] = {
+        {2, texture_data_type::RGBA_F32, pixel_data_type::F32, pixel_channels::RGBA},
+        {6, texture_data_type::RGB_F32, pixel_data_type::F32, pixel_channels::RGB},
+        {16, texture_data_type::RG_F32, pixel_data_type::F32, pixel_channels::RG},
+        {28, texture_data_type::RGBA_U8_NORM, pixel_data_type::U8, pixel_channels::RGBA},
+        {29, texture_data_type::SRGBA_U8_NORM, pixel_data_type::U8, pixel_channels::RGBA},
+        {41, texture_data_type::R_F32, pixel_data_type::F32, pixel_channels::R},
+        {49, texture_data_type::RG_U8_NORM, pixel_data_type::U8, pixel_channels::RG},
+        {61, texture_data_type::R_U8_NORM, pixel_data_type::U8, pixel_channels::R},
+        {71, texture_data_type::BC1_RGBA}, {72, texture_data_type::BC1_SRGBA},
+        {74, texture_data_type::BC2_RGBA}, {75, texture_data_type::BC2_SRGBA},
+        {77, texture_data_type::BC3_RGBA}, {78, texture_data_type::BC3_SRGBA},
+        {80, texture_data_type::BC4_R}, {81, texture_data_type::BC4_R_SIGNED},
+        {83, texture_data_type::BC5_RG}, {84, texture_data_type::BC5_RG_SIGNED},
+        {95, texture_data_type::BC6H_RGB_UF16}, {96, texture_data_type::BC6H_RGB_F16},
+        {98, texture_data_type::BC7_RGBA}, {99, texture_data_type::BC7_SRGBA},
+    };
+
+    static constexpr u32 make_fourcc(const char a, const char b, const char c, const char d)
+    {
+        return static_cast<u32>(a) | static_cast<u32>(b) << 8 | static_cast<u32>(c) << 16 | static_cast<u32>(d) << 24;
+    }
+
+    ///Legacy DDS files without a DX10 header identify their format with a FourCC code (or a D3DFORMAT number in its place), mapped to the equivalent DXGI format.
+    static constexpr std::array dds_fourcc_formats = {
+        std::pair {make_fourcc('D', 'X', 'T', '1'), 71u},
+        std::pair {make_fourcc('D', 'X', 'T', '3'), 74u},
+        std::pair {make_fourcc('D', 'X', 'T', '5'), 77u},
+        std::pair {make_fourcc('A', 'T', 'I', '1'), 80u},
+        std::pair {make_fourcc('B', 'C', '4', 'U'), 80u},
+        std::pair {make_fourcc('B', 'C', '4', 'S'), 81u},
+        std::pair {make_fourcc('A', 'T', 'I', '2'), 83u},
+        std::pair {make_fourcc('B', 'C', '5', 'U'), 83u},
+        std::pair {make_fourcc('B', 'C', '5', 'S'), 84u},
+        std::pair {116u, 2u}, //D3DFMT_A32B32G32R32F
+    };
+
+    #pragma pack(push, 1)
+    struct ktx2_header
+    {
+        u8 identifier[12];
+        u32 vk_format;
+        u32 type_size;
+        u32 pixel_width;
+        u32 pixel_height;
+        u32 pixel_depth;
+        u32 layer_count;
+        u32 face_count;
+        u32 level_count;
+        u32 supercompression_scheme;
+        u32 dfd_byte_offset;
+        u32 dfd_byte_length;
+        u32 kvd_byte_offset;
+        u32 kvd_byte_length;
+        u64 sgd_byte_offset;
+        u64 sgd_byte_length;
+    };
+
+    struct ktx2_level
+    {
+        u64 byte_offset;
+        u64 byte_length;
+        u64 uncompressed_byte_length;
+    };
+
+    struct dds_pixel_format
+    {
+        u32 size;
+        u32 flags;
+        u32 fourcc;
+        u32 rgb_bit_count;
+        u32 r_bit_mask;
+        u32 g_bit_mask;
+        u32 b_bit_mask;
+        u32 a_bit_mask;
+    };
+
+    struct dds_header
+    {
+        u32 magic;
+        u32 size;
+        u32 flags;
+        u32 height;
+        u32 width;
+        u32 pitch_or_linear_size;
+        u32 depth;
+        u32 mipmap_count;
+        u32 reserved1[11];
+        dds_pixel_format pixel_format;
+        u32 caps;
+        u32 caps2;
+        u32 caps3;
+        u32 caps4;
+        u32 reserved2;
+    };
+
+    struct dds_header_dx10
+    {
+        u32 dxgi_format;
+        u32 resource_dimension;
+        u32 misc_flag;
+        u32 array_size;
+        u32 misc_flags2;
+    };
+    #pragma pack(pop)
+
+    static constexpr std::array<u8, 12> KTX2_IDENTIFIER = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    static constexpr u32 DDS_MAGIC = make_fourcc('D', 'D', 'S', ' ');
+    static constexpr u32 DDS_FOURCC_DX10 = make_fourcc('D', 'X', '1', '0');
+    static constexpr u32 DDSD_MIPMAPCOUNT = 0x20000;
+    static constexpr u32 DDPF_FOURCC = 0x4;
+    static constexpr u32 DDPF_RGB = 0x40;
+    static constexpr u32 DDSCAPS2_CUBEMAP = 0x200;
+    static constexpr u32 DDSCAPS2_VOLUME = 0x200000;
+    static constexpr u32 DDS_DIMENSION_TEXTURE1D = 2;
+    static constexpr u32 DDS_DIMENSION_TEXTURE3D = 4;
+    static constexpr u32 DDS_MISC_TEXTURECUBE = 0x4;
+
+    ///A run of texture data in the mapped file covering one mipmap level of one or more consecutive layers.
+    struct texture_file_region
+    {
+        u32 mipmap_level;
+        u32 layer;
+        u32 layers;
+        const u8* data;
+    };
+
+    ///Everything read from a texture file's headers.
+    struct texture_file_contents
+    {
+        texture_format format;
+        pixel_data_type pixel_type = pixel_data_type::U8;
+        pixel_channels channels = pixel_channels::RGBA;
+        std::vector<texture_file_region> regions;
+        ///Whether there is exactly one region per mipmap level (covering every layer), in level order.
+        bool level_major = false;
+    };
+
+    struct texture_file::texture_file_internal
+    {
+        mapped_file file;
+        texture_file_contents contents;
+    };
+
+    static bool find_format_mapping(const std::span<const file_format_mapping> mappings, const u32 file_format, file_format_mapping& out_mapping)
+    {
+        const auto mapping_ptr = std::ranges::find_if(mappings, [file_format](const file_format_mapping& mapping) { return mapping.file_format == file_format; });
+        if (mapping_ptr == mappings.end()) return false;
+        out_mapping = *mapping_ptr;
+        return true;
+    }
+
+    ///Bytes of data for one mipmap level of a texture format, covering some number of layers.
+    static u64 mipmap_level_bytes(const texture_format& format, const u32 level, const u32 layers)
+    {
+        texture_format level_format = format;
+        level_format.width = std::max(format.width >> level, 1u);
+        level_format.height = std::max(format.height >> level, 1u);
+        level_format.depth = std::max(format.depth >> level, 1u);
+        level_format.layers = layers;
+        level_format.mipmap_levels = 1;
+        return texture_format_bytes(level_format);
+    }
+
+
+    static status parse_ktx2(const std::filesystem::path& path, const u8* data, const u64 size, texture_file_contents& out_contents)
+    {
+        ZoneScoped;
+        if (size < sizeof(ktx2_header)) return {status_type::INVALID, std::format("KTX2 file '{0}' is corrupted", path.string())};
+
+        ktx2_header header;
+        memcpy(&header, data, sizeof(header));
+        if (header.supercompression_scheme != 0) return {status_type::UNSUPPORTED, std::format("KTX2 file '{0}' is supercompressed, which isn't supported", path.string())};
+
+        file_format_mapping mapping;
+        if (!find_format_mapping(vk_format_mappings, header.vk_format, mapping)) return {status_type::UNSUPPORTED, std::format("KTX2 file '{0}' has an unsupported format (VkFormat {1})", path.string(), header.vk_format)};
+
+        texture_format& format = out_contents.format;
+        format.data_type = mapping.data_type;
+        format.shape = header.face_count == 6 ? texture_shape::CUBE_MAP : header.pixel_depth > 0 ? texture_shape::_3D : header.pixel_height > 0 ? texture_shape::_2D : texture_shape::_1D;
+        format.width = header.pixel_width;
+        format.height = std::max(header.pixel_height, 1u);
+        format.depth = std::max(header.pixel_depth, 1u);
+        format.layers = std::max(header.layer_count, 1u) * std::max(header.face_count, 1u);
+        format.mipmap_levels = std::max(header.level_count, 1u);
+        out_contents.pixel_type = mapping.pixel_type;
+        out_contents.channels = mapping.channels;
+
+        //The level index follows the header, level 0 first. Each level holds every layer and face of that level, tightly packed.
+        if (size < sizeof(ktx2_header) + format.mipmap_levels * sizeof(ktx2_level)) return {status_type::INVALID, std::format("KTX2 file '{0}' is corrupted", path.string())};
+        for (u32 level = 0; level < format.mipmap_levels; level++)
+        {
+            ktx2_level level_info;
+            memcpy(&level_info, data + sizeof(ktx2_header) + level * sizeof(ktx2_level), sizeof(level_info));
+
+            if (level_info.byte_length != mipmap_level_bytes(format, level, format.layers) || level_info.byte_offset > size || level_info.byte_length > size - level_info.byte_offset)
+            {
+                return {status_type::INVALID, std::format("KTX2 file '{0}' is corrupted - mipmap level {1} doesn't match the texture format", path.string(), level)};
+            }
+
+            out_contents.regions.push_back({level, 0, format.layers, data + level_info.byte_offset});
+        }
+
+        out_contents.level_major = true;
+        return status_type::SUCCESS;
+    }
+
+    static status parse_dds(const std::filesystem::path& path, const u8* data, const u64 size, texture_file_contents& out_contents)
+    {
+        ZoneScoped;
+        if (size < sizeof(dds_header)) return {status_type::INVALID, std::format("DDS file '{0}' is corrupted", path.string())};
+
+        dds_header header;
+        memcpy(&header, data, sizeof(header));
+        u64 data_offset = sizeof(dds_header);
+
+        u32 dxgi_format = 0;
+        u32 array_size = 1;
+        bool cubemap = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
+        bool volume = (header.caps2 & DDSCAPS2_VOLUME) != 0;
+        bool one_dimensional = false;
+        const dds_pixel_format& pixel_format = header.pixel_format;
+
+        if ((pixel_format.flags & DDPF_FOURCC) != 0 && pixel_format.fourcc == DDS_FOURCC_DX10)
+        {
+            if (size < sizeof(dds_header) + sizeof(dds_header_dx10)) return {status_type::INVALID, std::format("DDS file '{0}' is corrupted", path.string())};
+
+            dds_header_dx10 dx10_header;
+            memcpy(&dx10_header, data + sizeof(dds_header), sizeof(dx10_header));
+            data_offset += sizeof(dds_header_dx10);
+
+            dxgi_format = dx10_header.dxgi_format;
+            array_size = std::max(dx10_header.array_size, 1u);
+            cubemap = (dx10_header.misc_flag & DDS_MISC_TEXTURECUBE) != 0;
+            volume = dx10_header.resource_dimension == DDS_DIMENSION_TEXTURE3D;
+            one_dimensional = dx10_header.resource_dimension == DDS_DIMENSION_TEXTURE1D;
+        }
+        else if ((pixel_format.flags & DDPF_FOURCC) != 0)
+        {
+            const auto fourcc_ptr = std::ranges::find_if(dds_fourcc_formats, [&](const std::pair<u32, u32>& fourcc_format) { return fourcc_format.first == pixel_format.fourcc; });
+            if (fourcc_ptr == dds_fourcc_formats.end()) return {status_type::UNSUPPORTED, std::format("DDS file '{0}' has an unsupported format (FourCC {1:#x})", path.string(), pixel_format.fourcc)};
+            dxgi_format = fourcc_ptr->second;
+        }
+        else if ((pixel_format.flags & DDPF_RGB) != 0 && pixel_format.rgb_bit_count == 32 && pixel_format.r_bit_mask == 0x000000FF && pixel_format.g_bit_mask == 0x0000FF00 && pixel_format.b_bit_mask == 0x00FF0000)
+        {
+            dxgi_format = 28; //R8G8B8A8_UNORM
+        }
+
+        file_format_mapping mapping;
+        if (!find_format_mapping(dxgi_format_mappings, dxgi_format, mapping)) return {status_type::UNSUPPORTED, std::format("DDS file '{0}' has an unsupported format", path.string())};
+
+        texture_format& format = out_contents.format;
+        format.data_type = mapping.data_type;
+        format.shape = cubemap ? texture_shape::CUBE_MAP : volume ? texture_shape::_3D : one_dimensional ? texture_shape::_1D : texture_shape::_2D;
+        format.width = header.width;
+        format.height = std::max(header.height, 1u);
+        format.depth = volume ? std::max(header.depth, 1u) : 1;
+        format.layers = array_size * (cubemap ? 6 : 1);
+        format.mipmap_levels = (header.flags & DDSD_MIPMAPCOUNT) != 0 ? std::max(header.mipmap_count, 1u) : 1;
+        out_contents.pixel_type = mapping.pixel_type;
+        out_contents.channels = mapping.channels;
+
+        //DDS stores each layer (and cubemap face) as a whole mipmap chain, one after another.
+        for (u32 layer = 0; layer < format.layers; layer++)
+        {
+            for (u32 level = 0; level < format.mipmap_levels; level++)
+            {
+                const u64 level_bytes = mipmap_level_bytes(format, level, 1);
+                if (data_offset > size || level_bytes > size - data_offset) return {status_type::INVALID, std::format("DDS file '{0}' is corrupted - it's too small for its texture format", path.string())};
+
+                out_contents.regions.push_back({level, layer, 1, data + data_offset});
+                data_offset += level_bytes;
+            }
+        }
+
+        out_contents.level_major = format.layers == 1;
+        return status_type::SUCCESS;
+    }
+
+    status texture_file::open(const std::filesystem::path& path, texture_file*& out_file)
+    {
+        ZoneScoped;
+        std::unique_ptr<texture_file> file(new texture_file());
+        file->internal = std::make_unique<texture_file_internal>();
+        mapped_file& mapping = file->internal->file;
+
+        const status map_status = mapping.open(path);
+        if (map_status.is_error()) return map_status;
+
+        const u8* data = mapping.data();
+        const u64 size = mapping.size();
+
+        u32 magic = 0;
+        if (size >= sizeof(magic)) memcpy(&magic, data, sizeof(magic));
+
+        status parse_status = status_type::SUCCESS;
+        if (size >= KTX2_IDENTIFIER.size() && std::equal(KTX2_IDENTIFIER.begin(), KTX2_IDENTIFIER.end(), data)) parse_status = parse_ktx2(path, data, size, file->internal->contents);
+        else if (magic == DDS_MAGIC) parse_status = parse_dds(path, data, size, file->internal->contents);
+        else return {status_type::INVALID, std::format("'{0}' is not a KTX2 or DDS file", path.string())};
+
+        if (parse_status.is_error()) return parse_status;
+
+        out_file = file.release();
+        return status_type::SUCCESS;
+    }
+
+    const texture_format& texture_file::format() const
+    {
+        return internal->contents.format;
+    }
+
+    texture texture_file::texture_descriptor(const std::string_view& name, const texture_sampling_conifg& sampling_config, const bool streamed) const
+    {
+        texture file_texture(name, internal->contents.format, sampling_config);
+        file_texture.streamed = streamed;
+        return file_texture;
+    }
+
+    status texture_file::upload(render_context* context, const object_identifier& texture, const object_identifier& transfer_buffer) const
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to texture file upload"};
+
+        const texture_file_contents& contents = internal->contents;
+        for (const texture_file_region& region : contents.regions)
+        {
+            texture_memory_transfer_info info;
+            info.target = texture;
+            info.transfer_buffer = transfer_buffer;
+            info.width = std::max(contents.format.width >> region.mipmap_level, 1u);
+            info.height = std::max(contents.format.height >> region.mipmap_level, 1u);
+            info.depth = std::max(contents.format.depth >> region.mipmap_level, 1u);
+            info.mipmap_level = region.mipmap_level;
+            info.layer = region.layer;
+            info.layers = region.layers;
+            info.data_type = contents.pixel_type;
+            info.channels = contents.channels;
+
+            memory_transfer_handle* handle;
+            const status prepare_status = context->prepare_texture_memory_transfer(info, handle);
+            if (prepare_status.is_error()) return prepare_status;
+
+            //The only copy of the data is from the mapped file into transfer memory.
+            void* destination = nullptr;
+            const status write_status = handle->transfer_direct(destination);
+            if (!write_status.is_error()) memcpy(destination, region.data, mipmap_level_bytes(contents.format, region.mipmap_level, region.layers));
+
+            //Flush even if the write failed, so the handle is cleaned up.
+            const status flush_status = context->flush_texture_memory_transfer(handle);
+            if (write_status.is_error()) return write_status;
+            if (flush_status.is_error()) return flush_status;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status texture_file::stream_source(const object_identifier& texture, const object_identifier& transfer_buffer, texture_stream_source& out_source) const
+    {
+        ZoneScoped;
+        const texture_file_contents& contents = internal->contents;
+        if (!contents.level_major) return {status_type::UNSUPPORTED, "Texture file stores each layer's mipmap chain separately, so it can't be streamed"};
+
+        out_source.texture = texture;
+        out_source.transfer_buffer = transfer_buffer;
+        out_source.format = contents.format;
+        out_source.data_type = contents.pixel_type;
+        out_source.channels = contents.channels;
+        out_source.mipmap_levels.clear();
+        for (const texture_file_region& region : contents.regions)
+        {
+            out_source.mipmap_levels.push_back(region.data);
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    texture_file::texture_file() = default;
+    texture_file::~texture_file() = default;
+}
@@ -0,0 +1,132 @@
+#include "../api/texture_streaming.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+#include "tracy/Tracy.hpp"
+
+namespace stardraw
+{
+    using namespace starlib;
+
+    static texture_format mipmap_level_format(const texture_format& format, const u32 level)
+    {
+        texture_format level_format = format;
+        level_format.width = std::max(format.width >> level, 1u);
+        level_format.height = std::max(format.height >> level, 1u);
+        level_format.depth = std::max(format.depth >> level, 1u);
+        level_format.mipmap_levels = 1;
+        return level_format;
+    }
+
+    status texture_streamer::stream(const texture_stream_source& source)
+    {
+        ZoneScoped;
+        if (source.format.mipmap_levels == 0 || source.mipmap_levels.size() != source.format.mipmap_levels)
+        {
+            return {status_type::INVALID, std::format("Streaming texture '{0}' needs data for each of its {1} mipmap levels, but {2} were provided", source.texture.name, source.format.mipmap_levels, source.mipmap_levels.size())};
+        }
+
+        if (std::ranges::contains(source.mipmap_levels, nullptr)) return {status_type::INVALID, std::format("Streaming texture '{0}' has a mipmap level with no data", source.texture.name)};
+
+        cancel(source.texture);
+        queue.push_back({source, source.format.mipmap_levels - 1});
+        return status_type::SUCCESS;
+    }
+
+    void texture_streamer::cancel(const object_identifier& texture)
+    {
+        std::erase_if(queue, [&](const queued_texture& queued) { return queued.source.texture == texture; });
+    }
+
+    status texture_streamer::update(render_context* context)
+    {
+        ZoneScoped;
+        if (context == nullptr) return {status_type::INVALID, "Null render context passed to texture streamer update"};
+
+        u64 bytes_uploaded = 0;
+        bool uploaded_any = false;
+        while (!queue.empty())
+        {
+            //Take the smallest pending level across every texture, so all of them become visible before any of them gets sharper.
+            u32 next_idx = 0;
+            u64 next_bytes = 0;
+            for (u32 queue_idx = 0; queue_idx < queue.size(); queue_idx++)
+            {
+                const queued_texture& queued = queue[queue_idx];
+                const u64 level_bytes = texture_format_bytes(mipmap_level_format(queued.source.format, queued.next_level));
+                if (queue_idx == 0 || level_bytes < next_bytes)
+                {
+                    next_idx = queue_idx;
+                    next_bytes = level_bytes;
+                }
+            }
+
+            if (uploaded_any && bytes_uploaded + next_bytes > bytes_per_frame) break;
+
+            const status upload_status = upload_level(context, queue[next_idx]);
+            if (upload_status.is_error()) return upload_status;
+
+            bytes_uploaded += next_bytes;
+            uploaded_any = true;
+
+            if (queue[next_idx].next_level == 0) queue.erase(queue.begin() + next_idx);
+            else queue[next_idx].next_level--;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    u64 texture_streamer::queued_bytes() const
+    {
+        u64 bytes = 0;
+        for (const queued_texture& queued : queue)
+        {
+            for (u32 level = 0; level <= queued.next_level; level++)
+            {
+                bytes += texture_format_bytes(mipmap_level_format(queued.source.format, level));
+            }
+        }
+        return bytes;
+    }
+
+    bool texture_streamer::is_idle() const
+    {
+        return queue.empty();
+    }
+
+    status texture_streamer::upload_level(render_context* context, const queued_texture& queued)
+    {
+        ZoneScoped;
+        const texture_stream_source& source = queued.source;
+        const texture_format level_format = mipmap_level_format(source.format, queued.next_level);
+
+        texture_memory_transfer_info info;
+        info.target = source.texture;
+        info.transfer_buffer = source.transfer_buffer;
+        info.width = level_format.width;
+        info.height = level_format.height;
+        info.depth = level_format.depth;
+        info.mipmap_level = queued.next_level;
+        info.layers = source.format.layers;
+        info.data_type = source.data_type;
+        info.channels = source.channels;
+
+        memory_transfer_handle* handle;
+        const status prepare_status = context->prepare_texture_memory_transfer(info, handle);
+        if (prepare_status.is_error()) return prepare_status;
+
+        void* destination = nullptr;
+        const status write_status = handle->transfer_direct(destination);
+        if (!write_status.is_error())
+        {
+            std::memcpy(destination, source.mipmap_levels[queued.next_level], texture_format_bytes(level_format));
+        }
+
+        //Flush even if the write failed, so the handle is cleaned up.
+        const status flush_status = context->flush_texture_memory_transfer(handle);
+        if (write_status.is_error()) return write_status;
+        return flush_status;
+    }
+}